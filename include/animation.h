@@ -0,0 +1,63 @@
+#pragma once
+
+#include <stdint.h>
+
+//-----------------------------------------------------------------------------
+// Keyframe Animation
+//-----------------------------------------------------------------------------
+// Short transitions on the clock face, each a track of keyframes played
+// with fixed-point easing. There is one slot per kind of animation; starting
+// one that is already running restarts it. animUpdate() is called once per
+// frame and gives each running animation a value from 0 to 255, which the
+// animation layers (layers.h) read while drawing. While any animation runs
+// the loop draws at ANIM_REFRESH_MS instead of its idle rate.
+
+#define ANIM_REFRESH_MS     20      // Frame interval while animating (50 fps)
+
+enum AnimationKind : uint8_t
+{
+    ANIM_DAYLIGHT,          // Daylight band drawn in along its length (sunrise, sunset)
+    ANIM_SUN_PULSE,         // Sun LED pulsing
+    ANIM_CHIME,             // One sweep round the dial on the hour
+    ANIM_KIND_COUNT
+};
+
+enum Easing : uint8_t
+{
+    EASE_LINEAR,
+    EASE_IN,                // Cubic
+    EASE_OUT,
+    EASE_IN_OUT,            // Cosine
+    EASE_COUNT
+};
+
+// Easing is applied on the way into the keyframe from the one before
+struct Keyframe
+{
+    uint16_t ms;            // From the start of the track
+    uint8_t  value;
+    Easing   easing;
+};
+
+struct AnimationStats
+{
+    uint32_t idleFrames;
+    uint32_t idleUs;        // Total render time of frames without animation
+    uint32_t activeFrames;
+    uint32_t activeUs;      // Same, with at least one animation running
+    uint32_t activeMaxUs;
+    uint32_t started;
+};
+
+uint8_t easeApply(Easing easing, uint8_t t);     // t and result 0-255
+
+void    animStart(AnimationKind kind, uint32_t nowMs, int8_t direction = 1);
+int     animUpdate(uint32_t nowMs);             // Returns the number running
+int     animActiveCount();
+bool    animActive(AnimationKind kind);
+uint8_t animValue(AnimationKind kind);
+int8_t  animDirection(AnimationKind kind);
+
+void    animRecordFrame(uint32_t renderUs);
+const AnimationStats& animStats();
+void    cmdAnimation(const char* args);         // Console command: "anim [sunrise | sunset | chime]"
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <stdint.h>
+
+//-----------------------------------------------------------------------------
+// Boot Timeline
+//-----------------------------------------------------------------------------
+// Milestones from start-up to a fully running clock, each stamped once with
+// esp_timer (microseconds since the application started; the ROM and
+// second-stage bootloader before that are not counted). Repeated marks of a
+// step are ignored, so a mark can sit on a path that runs every frame.
+
+enum BootStep : uint8_t
+{
+    BOOT_SERIAL,            // Serial and logging up
+    BOOT_CONFIG,            // Settings loaded from NVS
+    BOOT_LEDS,              // FastLED.addLeds
+    BOOT_SETUP_DONE,        // setup() finished
+    BOOT_FIRST_SHOW,        // First frame on the strip
+    BOOT_CORRECT_FRAME,     // First frame drawn from a valid time
+    BOOT_WIFI_BEGIN,        // Network start, deferred until after the first frame
+    BOOT_WIFI_CONNECTED,
+    BOOT_CONFIG_TIME,       // SNTP started
+    BOOT_NTP_SYNC,          // First SNTP sync
+    BOOT_FIRST_FETCH,       // First sun data from the API
+    BOOT_STEP_COUNT
+};
+
+void        bootMark(BootStep step);
+uint32_t    bootStepUs(BootStep step);      // 0 if not reached yet
+const char* bootStepName(BootStep step);
+void        cmdBoot(const char* args);      // Console command: "boot"
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <FastLED.h>
+
+//-----------------------------------------------------------------------------
+// Frame Compositor
+//-----------------------------------------------------------------------------
+// All drawing into an LED buffer goes through set(), which keeps running
+// per-channel sums up to date. The frame's current draw can then be read at
+// any time without rescanning every pixel.
+
+// WS2812B current per channel at full value, and per LED when dark (mA at 5V).
+// Same model as FastLED's power management.
+#define LED_RED_MA      16
+#define LED_GREEN_MA    11
+#define LED_BLUE_MA     15
+#define LED_IDLE_MA     1
+
+struct CurrentEstimate
+{
+    uint32_t redMa;
+    uint32_t greenMa;
+    uint32_t blueMa;
+    uint32_t idleMa;
+
+    uint32_t totalMa() const { return redMa + greenMa + blueMa + idleMa; }
+};
+
+class Compositor
+{
+public:
+    Compositor(CRGB* leds, int count) : leds(leds), count(count)
+    {
+        clear();
+    }
+
+    void clear()
+    {
+        fill_solid(leds, count, CRGB::Black);
+        sums[0] = sums[1] = sums[2] = 0;
+    }
+
+    void set(int index, const CRGB& color)
+    {
+        CRGB& pixel = leds[index];
+        sums[0] += color.r - pixel.r;
+        sums[1] += color.g - pixel.g;
+        sums[2] += color.b - pixel.b;
+        pixel = color;
+    }
+
+    // Take up whatever the buffer holds after it was written directly
+    void rescan()
+    {
+        sums[0] = sums[1] = sums[2] = 0;
+        for (int i = 0; i < count; i++) 
+        {
+            sums[0] += leds[i].r;
+            sums[1] += leds[i].g;
+            sums[2] += leds[i].b;
+        }
+    }
+
+    // Use only the first count LEDs of the buffer
+    void resize(int newCount)
+    {
+        count = newCount;
+        clear();
+    }
+
+    const CRGB& get(int index) const { return leds[index]; }
+    int size() const { return count; }
+
+    // Current draw of the frame shown at the given global brightness
+    CurrentEstimate estimate(uint8_t brightness) const;
+
+private:
+    CRGB*    leds;
+    int      count;
+    uint32_t sums[3];   // Sum of each channel over all pixels
+};
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+//-----------------------------------------------------------------------------
+// Runtime Configuration
+//-----------------------------------------------------------------------------
+// Site settings kept as one binary record in NVS, so the same firmware runs
+// anywhere. The record is read once at boot into a plain Config that the
+// rest of the code reads directly. The stored header carries a version, the
+// record size and a CRC-32; anything that does not match is ignored and the
+// compiled-in defaults are used instead.
+
+#define CONFIG_VERSION  1
+
+struct Config
+{
+    char     ssid[33];
+    char     password[65];
+    double   latitude;              // Primary location
+    double   longitude;
+    uint8_t  brightness;            // Maximum brightness (0-255)
+    uint16_t numLeds;               // Clock ring length, applied at restart
+    char     winterSunrise[6];      // Solstice markers, "HH:MM" UTC
+    char     winterSunset[6];
+    char     summerSunrise[6];
+    char     summerSunset[6];
+};
+
+// Stored record, or the defaults if there is none or it is invalid.
+// Returns true if the stored record was used.
+bool configLoad(Config& config, const Config& defaults);
+bool configSave(const Config& config);
+void configErase();
+
+// Set one field from text, validating it. Returns false for an unknown key
+// or an out-of-range value, leaving the config unchanged.
+bool configSet(Config& config, const char* key, const char* value);
+
+// Field enumeration for printing: key, value as text, and whether the value
+// is a string (JSON quoting). The password is never shown.
+int  configFieldCount();
+const char* configFieldKey(int field);
+bool configFieldValue(const Config& config, int field, char* out, size_t size);
@@ -0,0 +1,13 @@
+#pragma once
+
+//-----------------------------------------------------------------------------
+// Serial Command Console
+//-----------------------------------------------------------------------------
+// Line-based commands on the debug serial port. Modules register their own
+// commands; consolePoll() never blocks and dispatches complete lines only.
+// Example: "date 2025-06-21 12:00"
+
+typedef void (*ConsoleHandler)(const char* args);   // args: text after the command name
+
+void consoleRegister(const char* name, ConsoleHandler handler, const char* help);
+void consolePoll();
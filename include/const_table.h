@@ -0,0 +1,44 @@
+#pragma once
+
+//-----------------------------------------------------------------------------
+// Compile-time Tables
+//-----------------------------------------------------------------------------
+// C++11 constexpr functions cannot loop, so a table is built from a pack of
+// indices 0..N-1 instead: each entry is Generator::at(i), evaluated by the
+// compiler, and the result is a plain const array in flash.
+//
+//   struct Squares { typedef uint16_t value_type;
+//                    static constexpr uint16_t at(int i) { return i * i; } };
+//   ConstTable<Squares, 16>::values[5]    // 25
+
+template<int... I> struct IndexList {};
+
+template<typename A, typename B> struct ConcatIndex;
+template<int... A, int... B>
+struct ConcatIndex<IndexList<A...>, IndexList<B...>>
+{
+    typedef IndexList<A..., (int)sizeof...(A) + B...> type;
+};
+
+// Halving keeps the template nesting depth at log2(N)
+template<int N>
+struct MakeIndexList
+{
+    typedef typename ConcatIndex<typename MakeIndexList<N / 2>::type,
+                                 typename MakeIndexList<N - N / 2>::type>::type type;
+};
+template<> struct MakeIndexList<0> { typedef IndexList<> type; };
+template<> struct MakeIndexList<1> { typedef IndexList<0> type; };
+
+template<typename Generator, typename List> struct ConstTableOf;
+template<typename Generator, int... I>
+struct ConstTableOf<Generator, IndexList<I...>>
+{
+    typedef typename Generator::value_type value_type;
+    static constexpr value_type values[sizeof...(I)] = { Generator::at(I)... };
+};
+template<typename Generator, int... I>
+constexpr typename Generator::value_type ConstTableOf<Generator, IndexList<I...>>::values[sizeof...(I)];
+
+template<typename Generator, int N>
+struct ConstTable : ConstTableOf<Generator, typename MakeIndexList<N>::type> {};
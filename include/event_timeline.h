@@ -0,0 +1,80 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+
+//-----------------------------------------------------------------------------
+// Event Timeline
+//-----------------------------------------------------------------------------
+// The day's events in time order: the sun events, the hours, a DST change,
+// the next sun data refresh and the midnight that ends the day. It is built
+// once a day (and again if the sun data changes), after which the next
+// event is a binary search. The wake scheduler sleeps until the next event
+// of any kind; the countdown trail and status use the next sun event.
+//
+//   timeline.clear(day);
+//   timeline.add(dayStart + sunriseMinutes * 60, EVENT_SUNRISE);
+//   ...
+//   timeline.sort();
+//   const TimelineEvent* next = timeline.next(now);
+
+#define TIMELINE_MAX_EVENTS 40
+
+enum EventKind : uint8_t
+{
+    EVENT_DAWN,             // Start of civil twilight
+    EVENT_SUNRISE,
+    EVENT_SOLAR_NOON,
+    EVENT_SUNSET,
+    EVENT_DUSK,             // End of civil twilight
+    EVENT_HOUR,
+    EVENT_MIDNIGHT,         // End of the day
+    EVENT_DST,              // Local DST state changes
+    EVENT_SUN_REFRESH,      // Sun data window runs low and is refilled
+    EVENT_KIND_COUNT
+};
+
+#define EVENT_MASK(kind)    (1u << (kind))
+#define EVENT_SUN_EVENTS    (EVENT_MASK(EVENT_DAWN) | EVENT_MASK(EVENT_SUNRISE) | EVENT_MASK(EVENT_SOLAR_NOON) | \
+                             EVENT_MASK(EVENT_SUNSET) | EVENT_MASK(EVENT_DUSK))
+#define EVENT_ALL           ((1u << EVENT_KIND_COUNT) - 1)
+
+struct TimelineEvent
+{
+    time_t    at;
+    EventKind kind;
+};
+
+class EventTimeline
+{
+public:
+    // Start again for a UTC day (time / 86400)
+    void clear(long day);
+
+    // Events outside the day are dropped, as are any past TIMELINE_MAX_EVENTS
+    void add(time_t at, EventKind kind);
+    void sort();
+
+    long day() const   { return timelineDay; }
+    int  count() const { return eventCount; }
+    const TimelineEvent& event(int i) const { return events[i]; }
+
+    // First event after now of one of the kinds, nullptr if none is left today
+    const TimelineEvent* next(time_t now, uint32_t kinds = EVENT_ALL) const;
+
+    // Seconds to the next event of one of the kinds, -1 if the day has none.
+    // After the last one of the day the first comes round again a day later,
+    // which is close enough for sun events.
+    long secondsToNext(time_t now, uint32_t kinds, EventKind* kind) const;
+
+private:
+    long          timelineDay = -1;
+    int           eventCount  = 0;
+    TimelineEvent events[TIMELINE_MAX_EVENTS];
+};
+
+const char* eventName(EventKind kind);
+
+// "1h12m", "12m" or "45s"
+void formatCountdown(char* out, size_t size, long seconds);
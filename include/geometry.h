@@ -0,0 +1,132 @@
+#pragma once
+
+#include <FastLED.h>
+#include "const_table.h"
+
+//-----------------------------------------------------------------------------
+// LED Geometry
+//-----------------------------------------------------------------------------
+// Everything draws in logical clock space: logical LED 0 is midnight on the
+// first dial and positions run clockwise. The geometry says where each
+// logical LED sits on the physical strip, as a list of runs; the compiler
+// turns it into a logical -> physical index table, and one remap pass per
+// frame copies the drawn frame onto the strip.
+//
+// Each run maps count logical LEDs from logical onwards onto count strip
+// LEDs from physical onwards. rotation is the strip LED, counted from the
+// start of the run, that shows the run's first logical LED (for a ring whose
+// midnight is not where the strip starts); step is 1 when clock order
+// follows strip order and -1 when it runs the other way. Strip LEDs that no
+// run covers stay dark, which leaves gaps; a ring or segment is a run.
+//
+//   { 0, 332, 0, 0, 1 }                          // One strip, LED 0 at midnight
+//   { 0, 332, 0, 83, -1 }                        // Midnight 83 LEDs in, anticlockwise
+//   { 0, 166, 0, 0, 1 }, { 166, 166, 170, 0, 1 } // 4 dark LEDs at a join
+//   { 0, 166, 0, 0, 1 }, { 166, 166, 166, 83, -1 }  // Two rings, the second mirrored
+
+struct LedRun
+{
+    uint16_t logical;       // First logical LED
+    uint16_t count;
+    uint16_t physical;      // First strip LED of the run
+    uint16_t rotation;      // Strip LED in the run showing the first logical LED
+    int8_t   step;          // 1 or -1
+};
+
+// Compile-time pieces of the table
+constexpr int ledRunPlace(const LedRun& run, int j)
+{
+    return run.physical + ((run.rotation + run.step * j) % run.count + run.count) % run.count;
+}
+
+constexpr bool ledRunHas(const LedRun& run, int i)
+{
+    return i >= run.logical && i < run.logical + run.count;
+}
+
+constexpr int largerOf(int a, int b)
+{
+    return a > b ? a : b;
+}
+
+template<const LedRun* Runs, int RunCount>
+constexpr int geometryEnd(int r = 0)
+{
+    return r == RunCount ? 0 : largerOf(Runs[r].physical + Runs[r].count, geometryEnd<Runs, RunCount>(r + 1));
+}
+
+template<const LedRun* Runs, int RunCount>
+constexpr bool geometryValid(int r = 0)
+{
+    return r == RunCount ||
+           (Runs[r].count > 0 && Runs[r].rotation < Runs[r].count &&
+            (Runs[r].step == 1 || Runs[r].step == -1) && geometryValid<Runs, RunCount>(r + 1));
+}
+
+// Logical LEDs outside every run go to one extra slot past the end of the
+// strip, so the remap needs no test
+template<const LedRun* Runs, int RunCount>
+constexpr uint16_t geometryMap(int i, int r = 0)
+{
+    return r == RunCount ? (uint16_t)geometryEnd<Runs, RunCount>() :
+           ledRunHas(Runs[r], i) ? (uint16_t)ledRunPlace(Runs[r], i - Runs[r].logical) :
+           geometryMap<Runs, RunCount>(i, r + 1);
+}
+
+template<const LedRun* Runs, int RunCount>
+struct GeometryEntries
+{
+    typedef uint16_t value_type;
+    static constexpr uint16_t at(int i) { return geometryMap<Runs, RunCount>(i); }
+};
+
+template<const LedRun* Runs, int RunCount, int LogicalLeds>
+struct GeometryTable
+{
+    static_assert(geometryValid<Runs, RunCount>(), "LED geometry: every run needs a count, a rotation below it and a step of 1 or -1");
+    static_assert(geometryEnd<Runs, RunCount>() < 0xFFFF, "LED geometry: strip too long");
+
+    typedef ConstTable<GeometryEntries<Runs, RunCount>, LogicalLeds> Table;
+
+    static const int logicalCount  = LogicalLeds;
+    static const int physicalCount = geometryEnd<Runs, RunCount>();    // Plus the discard slot
+    static const uint16_t* table() { return Table::values; }
+};
+
+//-----------------------------------------------------------------------------
+// Remap
+//-----------------------------------------------------------------------------
+// At start-up the table is split into straight spans, so the per-frame pass
+// is a memcpy per forward span and a short loop per reversed one. A table
+// that needs more spans than GEOMETRY_MAX_SPANS is remapped LED by LED.
+#define GEOMETRY_MAX_SPANS  16
+
+struct GeometrySpan
+{
+    uint16_t logical;
+    uint16_t physical;      // Strip LED of the first logical LED
+    uint16_t count;
+    int8_t   step;          // 1, -1, or 0 for LEDs not shown
+};
+
+class LedGeometry
+{
+public:
+    void begin(const uint16_t* table, int logicalLeds, int physicalCount);
+
+    // Copy a logical frame onto the strip
+    void remap(const CRGB* logical, CRGB* physical) const;
+
+    int  extent(int logicalLeds) const;     // Strip LEDs reached by the first logical LEDs
+    int  overlaps() const;                  // Strip LEDs claimed twice (a geometry mistake)
+
+    // Console command body: the spans and the remap cost
+    void report(const CRGB* logical, CRGB* physical) const;
+
+private:
+    const uint16_t* table         = nullptr;
+    int             logicalLeds   = 0;
+    int             physicalCount = 0;
+    int             spanCount     = -1;     // -1: too many, use the table
+    GeometrySpan    spans[GEOMETRY_MAX_SPANS];
+};
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <FastLED.h>
+#include <time.h>
+
+//-----------------------------------------------------------------------------
+// Task Health
+//-----------------------------------------------------------------------------
+// Each supervised stage reports a heartbeat, and a supervisor task checks
+// them every HEALTH_CHECK_MS. Recovery is staged:
+//   render   stalled: soft reset
+//   network  down: restart the network stack, again each timeout (a reset
+//            cannot fix a missing access point)
+//   fetch    wedged: restart the network stack, soft reset if that does
+//            not free it within HEALTH_ESCALATE_MS
+// The frame on the LEDs and the time are mirrored to RTC memory with every
+// frame, so after a reset the same frame is back on the strip moments into
+// boot, before WiFi. The task watchdog covers the render loop as a backstop
+// in case the supervisor itself is starved.
+//
+// Reset reasons and recoveries are counted in NVS. The "health" command
+// also shows how long after the last reset a correct frame was back.
+
+enum HealthStage : uint8_t
+{
+    HEALTH_RENDER,
+    HEALTH_NETWORK,
+    HEALTH_FETCH,
+    HEALTH_STAGE_COUNT
+};
+
+#define HEALTH_CHECK_MS             250
+#define HEALTH_ESCALATE_MS          30000
+#define HEALTH_TWDT_S               15          // Hardware backstop for the render loop
+#define HEALTH_MAX_LEDS             512         // Longer frames are not preserved
+#define HEALTH_RESET_REASONS        11          // esp_reset_reason_t values
+
+struct HealthCounts
+{
+    uint16_t resets[HEALTH_RESET_REASONS];          // By esp_reset_reason()
+    uint16_t networkRestarts[HEALTH_STAGE_COUNT];   // By the stage that stalled
+    uint16_t softResets[HEALTH_STAGE_COUNT];
+};
+
+// Early in setup(): count the reset, and after anything but power-on put
+// the preserved frame back into leds and the time back on the clock (if
+// the clock is not already past validAfter). True if a frame was restored.
+bool healthRestore(CRGB* leds, int count, time_t validAfter);
+
+// End of setup(), from the render loop's task: start the supervisor and
+// the task watchdog. restartNetwork runs in the supervisor task, so it
+// should only post the request for the loop to act on.
+void healthBegin(void (*restartNetwork)());
+
+void healthWatch(HealthStage stage, uint32_t timeoutMs);   // 0 stops watching
+void healthBeat(HealthStage stage);         // HEALTH_RENDER from the render loop only
+void healthPause(uint32_t ms);              // Expected silence (light sleep)
+void healthSaveFrame(const CRGB* leds, int count);
+
+const HealthCounts& healthCounts();
+const char*         healthStageName(int stage);
+const char*         healthResetName(int reason);
+void cmdHealth(const char* args);           // Console command: "health"
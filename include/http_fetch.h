@@ -0,0 +1,39 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+class WiFiClient;
+
+//-----------------------------------------------------------------------------
+// Allocation-free HTTP GET
+//-----------------------------------------------------------------------------
+// Just enough HTTP/1.1 for the sun data API. A request goes out on a
+// kept-alive connection (opened first if needed) and the body is read into
+// the caller's buffer. Content-Length, chunked and read-to-close bodies are
+// handled; redirects are not. The connection is closed after any error or
+// when the server asks for it. Nothing is allocated on the heap.
+
+// Negative results, in the spirit of HTTPClient's error codes
+#define HTTP_FETCH_ERROR_CONNECT    -1
+#define HTTP_FETCH_ERROR_SEND       -2
+#define HTTP_FETCH_ERROR_TIMEOUT    -3
+#define HTTP_FETCH_ERROR_HEADER     -4
+#define HTTP_FETCH_ERROR_TOO_LARGE  -5
+
+struct HttpTarget
+{
+    char     host[64];
+    uint16_t port;
+    bool     secure;            // https
+    char     path[64];          // Path without query
+};
+
+// Split "http[s]://host[:port]/path" into a target
+bool httpParseUrl(const char* url, HttpTarget& target);
+
+// GET pathAndQuery. Returns the HTTP status, or a negative error. With a
+// status the body is null-terminated in body and length excludes the
+// terminator; after an error neither is meaningful.
+int httpFetch(WiFiClient& client, const HttpTarget& target, const char* pathAndQuery, 
+              char* body, size_t size, size_t& length, uint32_t timeoutMs);
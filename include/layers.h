@@ -0,0 +1,417 @@
+#pragma once
+
+#include <limits.h>
+#include "animation.h"
+#include "compositor.h"
+#include "oklab.h"
+
+//-----------------------------------------------------------------------------
+// Dial Layers
+//-----------------------------------------------------------------------------
+// A dial is drawn by a stack of small layer types fixed at compile time.
+// Each layer gets a begin() call per dial and a shade() call per LED, in
+// stack order, and may overwrite the colour left by the layers before it.
+// The stack is a template, so the whole frame compiles to one inlined loop
+// over the LEDs with no virtual calls; reorder layers by reordering the
+// template arguments.
+//
+//   typedef LayerPipeline<DaylightLayer, HourTickLayer, SunLayer> Dial;
+//   Dial dial;
+//   dial.layer<HourTickLayer>().color = CRGB(0, 0, 32);
+//   dial.render(frame, context);
+
+// Positions on one dial, in LEDs from its midnight
+struct DialContext
+{
+    int  first;             // First LED of the dial in the frame
+    int  count;             // LEDs per dial
+    int  secondsPerLed;
+    int  sunLED;            // Current time
+    int  sunriseLED;
+    int  sunsetLED;
+    int  solarNoonLED;
+    int  twilightLEDs;      // Civil twilight either side of the daylight band
+    bool showSolstices;
+    int  solsticeLEDs[4];   // Winter and summer sunrise and sunset
+    bool animate;           // Dial shows the running animations
+    int  nextEventLED;      // Next sun event, -1 for no countdown trail
+
+    // Daylight test that also handles days wrapping past midnight UTC
+    bool isDaylight(int i) const
+    {
+        if (sunriseLED <= sunsetLED)
+        {
+            return i >= sunriseLED && i <= sunsetLED;
+        }
+        return i >= sunriseLED || i <= sunsetLED;
+    }
+};
+
+// CRTP base: per-layer switch and default no-op hooks
+template<typename Derived>
+struct Layer
+{
+    bool enabled = true;
+
+    void begin(const DialContext& dial) {}
+
+    void apply(const DialContext& dial, int i, CRGB& color)
+    {
+        if (enabled)
+        {
+            static_cast<Derived*>(this)->shade(dial, i, color);
+        }
+    }
+};
+
+//-----------------------------------------------------------------------------
+// Clock Layers
+//-----------------------------------------------------------------------------
+// Daylight period, with solar noon left dark as a marker
+struct DaylightLayer : Layer<DaylightLayer>
+{
+    CRGB color = CRGB(0, 0, 8);
+
+    void shade(const DialContext& dial, int i, CRGB& out) const
+    {
+        if (i != dial.solarNoonLED && dial.isDaylight(i))
+        {
+            out = color;
+        }
+    }
+};
+
+// Civil twilight before sunrise and after sunset, an OKLab gradient from the
+// night edge into the daylight colour. The gradient is rebuilt only when the
+// twilight length or a colour changes.
+#define TWILIGHT_MAX_LEDS   32
+
+struct TwilightLayer : Layer<TwilightLayer>
+{
+    CRGB nightColor = CRGB(12, 2, 6);
+    CRGB dayColor   = CRGB(0, 0, 8);
+
+    void begin(const DialContext& dial)
+    {
+        span = dial.twilightLEDs < TWILIGHT_MAX_LEDS ? dial.twilightLEDs : TWILIGHT_MAX_LEDS;
+        if (span > 0 && (span != rampSpan || nightColor != rampNight || dayColor != rampDay))
+        {
+            oklabGradient(ramp, span + 1, nightColor, dayColor);
+            rampSpan  = span;
+            rampNight = nightColor;
+            rampDay   = dayColor;
+        }
+    }
+
+    void shade(const DialContext& dial, int i, CRGB& out) const
+    {
+        if (span <= 0)
+        {
+            return;
+        }
+
+        // LEDs before sunrise and after sunset, the nearer if both
+        int before = dial.sunriseLED - i;
+        int after  = i - dial.sunsetLED;
+        if (before <= 0) before += dial.count;
+        if (after <= 0)  after  += dial.count;
+        int distance = before < after ? before : after;
+        if (distance <= span)
+        {
+            out = ramp[span - distance];
+        }
+    }
+
+private:
+    int  span;
+    int  rampSpan = 0;
+    CRGB rampNight;
+    CRGB rampDay;
+    CRGB ramp[TWILIGHT_MAX_LEDS + 1];
+};
+
+// Dim trail from the current time to the next sun event, added over the
+// daylight and twilight colours; goes before the markers
+struct CountdownLayer : Layer<CountdownLayer>
+{
+    CRGB color = CRGB(4, 3, 0);
+
+    void begin(const DialContext& dial)
+    {
+        length = dial.nextEventLED - dial.sunLED;
+        if (length < 0)
+        {
+            length += dial.count;
+        }
+    }
+
+    void shade(const DialContext& dial, int i, CRGB& out) const
+    {
+        if (dial.nextEventLED < 0)
+        {
+            return;
+        }
+        int ahead = i - dial.sunLED;
+        if (ahead < 0)
+        {
+            ahead += dial.count;
+        }
+        if (ahead > 0 && ahead < length)
+        {
+            out += color;
+        }
+    }
+
+private:
+    int length;
+};
+
+// One tick per hour; LEDs are visited in order, so the next tick is tracked
+// instead of dividing per LED
+struct HourTickLayer : Layer<HourTickLayer>
+{
+    CRGB color = CRGB(32, 0, 0);
+
+    void begin(const DialContext& dial)
+    {
+        hour    = 0;
+        nextLED = 0;
+    }
+
+    void shade(const DialContext& dial, int i, CRGB& out)
+    {
+        if (i != nextLED)
+        {
+            return;
+        }
+        if (i != dial.solarNoonLED)
+        {
+            out = color;
+        }
+        while (nextLED == i)
+        {
+            hour++;
+            nextLED = hour < 24 ? (hour * 3600) / dial.secondsPerLed : INT_MAX;
+        }
+    }
+
+private:
+    int hour;
+    int nextLED;
+};
+
+// Sunrise and sunset at both solstices, on the primary dial only
+struct SolsticeLayer : Layer<SolsticeLayer>
+{
+    CRGB color = CRGB(0, 255, 0);
+
+    void shade(const DialContext& dial, int i, CRGB& out) const
+    {
+        if (dial.showSolstices &&
+            (i == dial.solsticeLEDs[0] || i == dial.solsticeLEDs[1] ||
+             i == dial.solsticeLEDs[2] || i == dial.solsticeLEDs[3]))
+        {
+            out = color;
+        }
+    }
+};
+
+// Current sun position, shown only while the sun is up
+struct SunLayer : Layer<SunLayer>
+{
+    CRGB color = CRGB(255, 255, 0);
+
+    void shade(const DialContext& dial, int i, CRGB& out) const
+    {
+        if (i == dial.sunLED && i != dial.solarNoonLED && dial.isDaylight(i))
+        {
+            out = color;
+        }
+    }
+};
+
+//-----------------------------------------------------------------------------
+// Animation Layers
+//-----------------------------------------------------------------------------
+// Each reads its animation's value once per dial (see animation.h) and does
+// nothing while that animation is not running
+#define ANIM_FADE_EDGE      6       // LEDs over which the daylight front fades in
+#define ANIM_CHIME_TAIL     8       // LEDs in the tail of the hourly sweep
+
+// Daylight band drawn in from sunrise towards sunset, or from sunset back
+// towards sunrise; goes straight after DaylightLayer
+struct DaylightFadeLayer : Layer<DaylightFadeLayer>
+{
+    void begin(const DialContext& dial)
+    {
+        running  = dial.animate && animActive(ANIM_DAYLIGHT);
+        forward  = animDirection(ANIM_DAYLIGHT) > 0;
+        length   = dial.sunsetLED - dial.sunriseLED + 1;
+        if (length <= 0)
+        {
+            length += dial.count;
+        }
+        front = animValue(ANIM_DAYLIGHT) * (length + ANIM_FADE_EDGE);
+    }
+
+    void shade(const DialContext& dial, int i, CRGB& out) const
+    {
+        if (!running)
+        {
+            return;
+        }
+        int d = i - dial.sunriseLED;
+        if (d < 0)
+        {
+            d += dial.count;
+        }
+        if (d >= length)
+        {
+            return;
+        }
+        if (!forward)
+        {
+            d = length - 1 - d;
+        }
+
+        // Positions in 1/255 LED
+        int behind = front - d * 255;
+        if (behind <= 0)
+        {
+            out = CRGB::Black;
+        }
+        else if (behind < ANIM_FADE_EDGE * 255)
+        {
+            out.nscale8_video(behind / ANIM_FADE_EDGE);
+        }
+    }
+
+private:
+    bool running;
+    bool forward;
+    int  length;
+    int  front;
+};
+
+// Sun LED brightness follows the pulse; goes after SunLayer
+struct SunPulseLayer : Layer<SunPulseLayer>
+{
+    void begin(const DialContext& dial)
+    {
+        running = dial.animate && animActive(ANIM_SUN_PULSE);
+        level   = animValue(ANIM_SUN_PULSE);
+    }
+
+    void shade(const DialContext& dial, int i, CRGB& out) const
+    {
+        if (running && i == dial.sunLED && i != dial.solarNoonLED && dial.isDaylight(i))
+        {
+            out.nscale8_video(level);
+        }
+    }
+
+private:
+    bool    running;
+    uint8_t level;
+};
+
+// A dot with a fading tail once round the dial from the current time, added
+// over everything else
+struct ChimeLayer : Layer<ChimeLayer>
+{
+    CRGB color = CRGB(96, 48, 0);
+
+    void begin(const DialContext& dial)
+    {
+        running = dial.animate && animActive(ANIM_CHIME);
+        head    = (dial.sunLED + animValue(ANIM_CHIME) * dial.count / 255) % dial.count;
+    }
+
+    void shade(const DialContext& dial, int i, CRGB& out) const
+    {
+        if (!running)
+        {
+            return;
+        }
+        int behind = head - i;
+        if (behind < 0)
+        {
+            behind += dial.count;
+        }
+        if (behind < ANIM_CHIME_TAIL)
+        {
+            CRGB tail = color;
+            tail.nscale8_video(255 - behind * 255 / ANIM_CHIME_TAIL);
+            out += tail;
+        }
+    }
+
+private:
+    bool running;
+    int  head;
+};
+
+//-----------------------------------------------------------------------------
+// Pipeline
+//-----------------------------------------------------------------------------
+template<typename T> struct LayerTag {};
+
+// Recursive stack: each level holds one layer and inherits the rest
+template<typename... Layers>
+struct LayerStack
+{
+    void begin(const DialContext& dial) {}
+    void shade(const DialContext& dial, int i, CRGB& color) {}
+    void get();
+};
+
+template<typename First, typename... Rest>
+struct LayerStack<First, Rest...> : LayerStack<Rest...>
+{
+    First layer;
+
+    using LayerStack<Rest...>::get;
+    First& get(LayerTag<First>) { return layer; }
+
+    void begin(const DialContext& dial)
+    {
+        layer.begin(dial);
+        LayerStack<Rest...>::begin(dial);
+    }
+
+    void shade(const DialContext& dial, int i, CRGB& color)
+    {
+        layer.apply(dial, i, color);
+        LayerStack<Rest...>::shade(dial, i, color);
+    }
+};
+
+template<typename... Layers>
+class LayerPipeline
+{
+public:
+    template<typename T>
+    T& layer() { return stack.get(LayerTag<T>()); }
+
+    // Draw every LED of one dial in a single pass
+    void render(Compositor& frame, const DialContext& dial)
+    {
+        stack.begin(dial);
+        for (int i = 0; i < dial.count; i++)
+        {
+            CRGB color = CRGB::Black;
+            stack.shade(dial, i, color);
+            frame.set(dial.first + i, color);
+        }
+    }
+
+private:
+    LayerStack<Layers...> stack;
+};
+
+// The clock face, back to front
+typedef LayerPipeline<DaylightLayer, TwilightLayer, DaylightFadeLayer, CountdownLayer,
+                      HourTickLayer, SolsticeLayer, SunLayer, SunPulseLayer, ChimeLayer> ClockLayers;
+
+// Console command: the clock pipeline against virtual dispatch
+void layerBenchmark(const char* args);
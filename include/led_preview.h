@@ -0,0 +1,18 @@
+#pragma once
+
+#include <FastLED.h>
+#include "web_server.h"
+
+//-----------------------------------------------------------------------------
+// Live LED Preview
+//-----------------------------------------------------------------------------
+// Streams the clock buffer to one browser over a WebSocket, drawn as a ring
+// by the page at /preview. The render loop only offers a snapshot; if the
+// sender is busy the offer is skipped, so a viewer can never hold up show().
+//
+// Each WebSocket message carries one frame, key or delta, encoded as in
+// preview_codec.h.
+
+void previewBegin(uint16_t port, int ledCount);
+void previewPublish(const CRGB* leds);              // Non-blocking snapshot offer
+void handlePreviewPage(ResponseWriter& out, const char* query);  // GET /preview
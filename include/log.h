@@ -0,0 +1,147 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+//-----------------------------------------------------------------------------
+// Logging
+//-----------------------------------------------------------------------------
+// Levels and categories are fixed at compile time (see build_flags in
+// platformio.ini). A disabled statement compiles to nothing, its arguments
+// are not even evaluated. An enabled statement only captures the format
+// pointer and its arguments; formatting and the serial write happen later
+// in a background task.
+//
+// The format string and any %s arguments must outlive the statement, so use
+// string literals or static buffers.
+//
+//   LOG_INFO(LOG_NET, "WiFi connected, RSSI %d dBm", WiFi.RSSI());
+
+#define LOG_LEVEL_NONE      0
+#define LOG_LEVEL_ERROR     1
+#define LOG_LEVEL_WARN      2
+#define LOG_LEVEL_INFO      3
+#define LOG_LEVEL_DEBUG     4
+
+#ifndef LOG_LEVEL
+#define LOG_LEVEL           LOG_LEVEL_INFO
+#endif
+
+// Categories (bit mask)
+#define LOG_NET             0x01
+#define LOG_ASTRO           0x02
+#define LOG_RENDER          0x04
+#define LOG_TIME            0x08
+#define LOG_SYSTEM          0x10
+
+#ifndef LOG_CATEGORIES
+#define LOG_CATEGORIES      (LOG_NET | LOG_ASTRO | LOG_RENDER | LOG_TIME | LOG_SYSTEM)
+#endif
+
+#define LOG_MAX_ARGS        6
+
+//-----------------------------------------------------------------------------
+// Argument Capture
+//-----------------------------------------------------------------------------
+enum LogArgType : uint8_t
+{
+    LOG_ARG_INT,
+    LOG_ARG_UINT,
+    LOG_ARG_INT64,
+    LOG_ARG_UINT64,
+    LOG_ARG_DOUBLE,
+    LOG_ARG_STRING,
+    LOG_ARG_POINTER
+};
+
+struct LogArg
+{
+    LogArgType type;
+    union
+    {
+        int32_t     i;
+        uint32_t    u;
+        int64_t     i64;
+        uint64_t    u64;
+        double      d;
+        const char* s;
+        const void* p;
+    };
+};
+
+inline LogArg logArg(int v)                { LogArg a; a.type = LOG_ARG_INT;     a.i   = v; return a; }
+inline LogArg logArg(unsigned int v)       { LogArg a; a.type = LOG_ARG_UINT;    a.u   = v; return a; }
+inline LogArg logArg(long long v)          { LogArg a; a.type = LOG_ARG_INT64;   a.i64 = v; return a; }
+inline LogArg logArg(unsigned long long v) { LogArg a; a.type = LOG_ARG_UINT64;  a.u64 = v; return a; }
+
+// long is 32 bits on the ESP32 but 64 on most hosts
+inline LogArg logArg(long v)               { return sizeof(long) > 4 ? logArg((long long)v) : logArg((int)v); }
+inline LogArg logArg(unsigned long v)      { return sizeof(long) > 4 ? logArg((unsigned long long)v) : logArg((unsigned int)v); }
+inline LogArg logArg(double v)             { LogArg a; a.type = LOG_ARG_DOUBLE;  a.d   = v; return a; }
+inline LogArg logArg(const char* v)        { LogArg a; a.type = LOG_ARG_STRING;  a.s   = v; return a; }
+inline LogArg logArg(const void* v)        { LogArg a; a.type = LOG_ARG_POINTER; a.p   = v; return a; }
+
+// Queue a record; dropped (and counted) if the queue is full
+void logSubmit(uint8_t level, uint8_t category, const char* format, const LogArg* args, uint8_t count);
+
+inline void logDeferred(uint8_t level, uint8_t category, const char* format)
+{
+    logSubmit(level, category, format, nullptr, 0);
+}
+
+template<typename... Args>
+inline void logDeferred(uint8_t level, uint8_t category, const char* format, Args... args)
+{
+    static_assert(sizeof...(Args) <= LOG_MAX_ARGS, "Too many log arguments");
+    const LogArg captured[] = { logArg(args)... };
+    logSubmit(level, category, format, captured, sizeof...(Args));
+}
+
+//-----------------------------------------------------------------------------
+// Statements
+//-----------------------------------------------------------------------------
+// The category test is a constant expression, so the optimiser removes
+// statements for disabled categories along with their arguments.
+#define LOG_AT(level, category, ...) \
+    do { if ((category) & (LOG_CATEGORIES)) logDeferred((level), (category), __VA_ARGS__); } while (0)
+
+// Disabled statements stay type-checked but are discarded as dead code
+#define LOG_NOTHING(category, ...) \
+    do { if (0) logDeferred(0, (category), __VA_ARGS__); } while (0)
+
+#if LOG_LEVEL >= LOG_LEVEL_ERROR
+#define LOG_ERROR(category, ...)    LOG_AT(LOG_LEVEL_ERROR, category, __VA_ARGS__)
+#else
+#define LOG_ERROR(category, ...)    LOG_NOTHING(category, __VA_ARGS__)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_WARN
+#define LOG_WARN(category, ...)     LOG_AT(LOG_LEVEL_WARN, category, __VA_ARGS__)
+#else
+#define LOG_WARN(category, ...)     LOG_NOTHING(category, __VA_ARGS__)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_INFO
+#define LOG_INFO(category, ...)     LOG_AT(LOG_LEVEL_INFO, category, __VA_ARGS__)
+#else
+#define LOG_INFO(category, ...)     LOG_NOTHING(category, __VA_ARGS__)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_DEBUG
+#define LOG_DEBUG(category, ...)    LOG_AT(LOG_LEVEL_DEBUG, category, __VA_ARGS__)
+#else
+#define LOG_DEBUG(category, ...)    LOG_NOTHING(category, __VA_ARGS__)
+#endif
+
+// printf-style formatting from captured arguments, one conversion at a time.
+// Returns the length written, truncated to fit size - 1.
+size_t   logFormat(char* out, size_t size, const char* format, const LogArg* args, uint8_t count);
+
+void     logBegin();                        // Start the formatting task
+
+// The debug UART is shared with binary telemetry: hold this around a whole
+// line or frame so neither splits the other. A no-op before logBegin().
+void     logLockSerial();
+void     logUnlockSerial();
+uint32_t logDropped();
+void     logBenchmark(const char* args);    // Console command: cost per statement
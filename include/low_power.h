@@ -0,0 +1,36 @@
+#pragma once
+
+#include <stdint.h>
+
+//-----------------------------------------------------------------------------
+// Low-power Sleep
+//-----------------------------------------------------------------------------
+// Light sleep between display changes. The strip keeps showing its last
+// frame (WS2812 LEDs latch their data), and RAM and GPIO state are kept.
+// The WiFi link may lapse during long sleeps and reconnects after waking.
+//
+// Activity on the console UART also wakes it. The edges that wake it are
+// consumed, so the first character or two typed are lost; after such a
+// wake the loop stays awake for LOW_POWER_CONSOLE_AWAKE_MS so the command
+// can be typed again in full.
+
+// Rough ESP32-S3 supply current, used only for the average current report
+#define MCU_ACTIVE_MA   45      // Awake, WiFi in modem sleep
+#define MCU_SLEEP_MA    1       // Light sleep
+
+#define LOW_POWER_CONSOLE_UART      0       // UART behind Serial (not USB CDC)
+#define LOW_POWER_UART_WAKE_EDGES   3       // RX edges that wake the chip
+#define LOW_POWER_CONSOLE_AWAKE_MS  30000   // Stay awake this long after a console wake
+
+struct SleepStats
+{
+    uint32_t wakeCount;
+    uint32_t consoleWakes;      // Woken by the console UART
+    uint64_t sleepMs;
+    uint64_t awakeMs;
+};
+
+void lowPowerBegin();                   // Enable WiFi modem sleep and console wake
+bool lowPowerSleep(uint32_t ms);        // Light sleep for up to ms, true if the console woke it
+const SleepStats& lowPowerStats();
+uint32_t lowPowerAverageMa();           // Average MCU current since boot
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <FastLED.h>
+
+//-----------------------------------------------------------------------------
+// OKLab Colour Blending
+//-----------------------------------------------------------------------------
+// Blends in OKLab, where equal steps look equally far apart, instead of in
+// RGB, where a blend between two hues passes through a greyer, darker
+// midpoint. WS2812 PWM output is linear in the channel value, so CRGB values
+// are taken as linear light without any sRGB decoding. The cube roots of the
+// forward transform come from a table built at compile time; the inverse
+// needs only multiplications.
+//
+//   CRGB dusk[16];
+//   oklabGradient(dusk, 16, CRGB(12, 2, 6), CRGB(0, 0, 8));
+
+struct OkLab
+{
+    float L;
+    float a;
+    float b;
+};
+
+OkLab oklabFromRgb(const CRGB& color);
+CRGB  oklabToRgb(const OkLab& color);
+
+// t = 0 gives from, 255 gives to
+CRGB  oklabBlend(const CRGB& from, const CRGB& to, uint8_t t);
+
+// count colours from from to to inclusive; the ends are converted once
+void  oklabGradient(CRGB* out, int count, const CRGB& from, const CRGB& to);
+
+void  colorBenchmark(const char* args);     // Console command: gradient cost and accuracy
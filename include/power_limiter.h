@@ -0,0 +1,39 @@
+#pragma once
+
+#include <stdint.h>
+
+//-----------------------------------------------------------------------------
+// Power Budget Limiter
+//-----------------------------------------------------------------------------
+// Picks the highest global brightness whose estimated current stays within
+// the budget. Brightness drops at once when a frame would exceed the budget
+// and recovers gradually, so the budget is never exceeded and the display
+// does not flicker.
+
+typedef uint32_t (*CurrentEstimator)(uint8_t brightness);  // Total mA at a brightness
+
+class PowerLimiter
+{
+public:
+    PowerLimiter(uint32_t budgetMa, uint8_t maxBrightness, uint8_t rampStep);
+
+    // Brightness to show the current frame with
+    uint8_t update(CurrentEstimator estimateMa);
+
+    void setMaxBrightness(uint8_t brightness) { maxBrightness = brightness; }
+
+    uint8_t  brightness()  const { return current; }
+    bool     limiting()    const { return limited; }
+    uint32_t activations() const { return activationCount; }
+    uint32_t currentMa()   const { return lastMa; }
+    uint32_t budgetMa()    const { return budget; }
+
+private:
+    uint32_t budget;
+    uint8_t  maxBrightness;
+    uint8_t  rampStep;          // Brightness recovered per frame
+    uint8_t  current;
+    bool     limited;
+    uint32_t activationCount;   // Times the limiter started reducing brightness
+    uint32_t lastMa;
+};
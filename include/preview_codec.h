@@ -0,0 +1,60 @@
+#pragma once
+
+#include <FastLED.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+//-----------------------------------------------------------------------------
+// Preview Message Codec
+//-----------------------------------------------------------------------------
+// Message: type (0 = key frame, 1 = delta), LED count (u16), then runs of
+// changed pixels: start (u16), count (u16), count * RGB bytes. All integers
+// little-endian. A key frame is one run covering every LED.
+//
+// The encoder writes runs straight from the frame into a sink, any type
+// with bool write(const uint8_t* data, size_t length), so no message
+// buffer is ever built.
+
+#define PREVIEW_KEYFRAME        0
+#define PREVIEW_DELTA           1
+#define PREVIEW_RUN_GAP         2       // Changed pixels this close share a run (a run header costs more than a pixel)
+
+// Next run of pixels in frame that differ from sent, starting at index.
+// With all set, the whole frame is one run.
+bool previewNextRun(const CRGB* frame, const CRGB* sent, int count, int& index, int& runLength, bool all);
+
+// Bytes in the message for frame, or 0 for a delta with nothing changed
+size_t previewMessageSize(const CRGB* frame, const CRGB* sent, int count, bool keyframe);
+
+// Encode frame against what the viewer has, and update sent to match
+template<typename Sink>
+bool previewEncode(Sink& sink, const CRGB* frame, CRGB* sent, int count, bool keyframe)
+{
+    uint8_t header[3] = { (uint8_t)(keyframe ? PREVIEW_KEYFRAME : PREVIEW_DELTA), 
+                          (uint8_t)(count & 0xFF), (uint8_t)(count >> 8) };
+    if (!sink.write(header, sizeof(header))) 
+    {
+        return false;
+    }
+
+    int index = 0, runLength = 0;
+    while (previewNextRun(frame, sent, count, index, runLength, keyframe)) 
+    {
+        uint8_t run[4] = { (uint8_t)(index & 0xFF), (uint8_t)(index >> 8), 
+                           (uint8_t)(runLength & 0xFF), (uint8_t)(runLength >> 8) };
+        size_t bytes = runLength * sizeof(CRGB);
+        if (!sink.write(run, sizeof(run)) || !sink.write((const uint8_t*)&frame[index], bytes)) 
+        {
+            return false;
+        }
+        memcpy(&sent[index], &frame[index], bytes);
+        index += runLength;
+    }
+    return true;
+}
+
+// Apply a message to a viewer's pixels, as the preview page does. A key
+// frame clears them first. Returns the message's LED count, or -1 if the
+// message is malformed or larger than capacity.
+int previewDecode(const uint8_t* message, size_t length, CRGB* pixels, int capacity);
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <stdint.h>
+#include <time.h>
+
+//-----------------------------------------------------------------------------
+// Frame-phase Profiler
+//-----------------------------------------------------------------------------
+// Times each stage of loop() with the Xtensa CCOUNT cycle counter
+// (clock_gettime on other targets) and keeps min/avg/max and a log-linear
+// histogram per stage for percentiles. Recording is a handful of integer
+// operations; set PROFILE_ENABLED to 0 to compile it out entirely.
+//
+//   { PROFILE_STAGE(PROFILE_SHOW); showStrip(clockStrip); }
+
+#ifndef PROFILE_ENABLED
+#define PROFILE_ENABLED     1
+#endif
+
+enum ProfileStage : uint8_t
+{
+    PROFILE_SUN_REFRESH,
+    PROFILE_TIME_LOOKUP,
+    PROFILE_CLEAR,
+    PROFILE_LAYERS,
+    PROFILE_DEBUG,
+    PROFILE_REMAP,
+    PROFILE_SHOW,
+    PROFILE_STAGE_COUNT
+};
+
+// Raw timestamp: CPU cycles on Xtensa, nanoseconds elsewhere
+static inline uint32_t profileNow()
+{
+#if defined(__XTENSA__)
+    uint32_t ccount;
+    __asm__ __volatile__("rsr %0, ccount" : "=a"(ccount));
+    return ccount;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)(ts.tv_sec * 1000000000ULL + ts.tv_nsec);
+#endif
+}
+
+struct ProfileSummary
+{
+    uint32_t count;
+    float    minUs;
+    float    avgUs;
+    float    p99Us;
+    float    maxUs;
+};
+
+void profileRecord(ProfileStage stage, uint32_t ticks);
+void profileReset();
+ProfileSummary profileSummary(ProfileStage stage);
+const char*    profileStageName(ProfileStage stage);
+void profileDump();
+void cmdProfile(const char* args);     // Console command: "prof" or "prof reset"
+
+class ProfileScope
+{
+public:
+    explicit ProfileScope(ProfileStage stage) : stage(stage), start(profileNow()) {}
+    ~ProfileScope() { profileRecord(stage, profileNow() - start); }
+
+private:
+    ProfileStage stage;
+    uint32_t     start;
+};
+
+#if PROFILE_ENABLED
+#define PROFILE_CONCAT_(a, b)   a##b
+#define PROFILE_CONCAT(a, b)    PROFILE_CONCAT_(a, b)
+#define PROFILE_STAGE(stage)    ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(stage)
+#else
+#define PROFILE_STAGE(stage)    do { } while (0)
+#endif
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <stdint.h>
+
+//-----------------------------------------------------------------------------
+// On-device Solar Calculations
+//-----------------------------------------------------------------------------
+// NOAA "General Solar Position" approximation. Accurate to about a minute,
+// which is well below the ~4.3 minutes represented by one clock LED.
+// All times are UTC minutes after midnight, matching the API data.
+
+struct SunTimes
+{
+    int16_t sunriseMinutes;
+    int16_t sunsetMinutes;
+    int16_t solarNoonMinutes;
+    int16_t dayMinutes;         // 0 = polar night, 1440 = midnight sun
+};
+
+// Sun times for a given day of the year (0-based, as in tm_yday)
+SunTimes calcSunTimes(float latitude, float longitude, int dayOfYear);
+
+//-----------------------------------------------------------------------------
+// Batched Calculation
+//-----------------------------------------------------------------------------
+// Structure-of-arrays view over many locations. The date terms are evaluated
+// once per batch and the per-location loop is branch-free, so it pipelines
+// well and stays cheap for dozens of sites. Arrays are owned by the caller.
+struct SunBatch
+{
+    int            count;
+    const float*   latitude;
+    const float*   longitude;
+    int16_t*       sunriseMinutes;
+    int16_t*       sunsetMinutes;
+    int16_t*       solarNoonMinutes;
+    int16_t*       dayMinutes;
+    int16_t*       twilightMinutes;     // Civil twilight before sunrise and after sunset
+};
+
+void calcSunTimesBatch(const SunBatch& batch, int dayOfYear);
+
+//-----------------------------------------------------------------------------
+// Yearly Daylight Table
+//-----------------------------------------------------------------------------
+// Built once per year and shared by anything that needs the annual envelope.
+struct YearTable
+{
+    int      year;                  // Calendar year, 0 = not built
+    int      days;                  // 365 or 366
+    uint16_t dayMinutes[366];       // Day length for each day of the year
+    uint16_t minDayMinutes;
+    uint16_t maxDayMinutes;
+    int      springEquinoxDay;      // Days of the year (0-based)
+    int      summerSolsticeDay;
+    int      autumnEquinoxDay;
+    int      winterSolsticeDay;
+};
+
+void buildYearTable(YearTable& table, float latitude, float longitude, int year);
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "http_fetch.h"
+
+class WiFiClient;
+
+//-----------------------------------------------------------------------------
+// Sun Data Fetch
+//-----------------------------------------------------------------------------
+// One day from the sunrise-sunset API: the request goes out through
+// httpFetch() and the response is parsed into a static pool, so a refresh
+// never uses the heap. Only the fetch task calls these; the body buffer
+// and pool are shared between calls.
+
+struct SunData
+{
+    int sunriseMinutes;
+    int sunsetMinutes;
+    int solarNoonMinutes;
+    int daySeconds;
+    unsigned long lastUpdate;
+};
+
+// What became of a response body
+enum SunParseResult
+{
+    SUN_PARSE_OK,
+    SUN_PARSE_INVALID_JSON,
+    SUN_PARSE_MALFORMED         // A field missing, not ISO-8601 or out of range
+};
+
+// Fetch one day over the client's connection, opening it if needed. Returns
+// the HTTP status or a negative HTTP_FETCH_ERROR; the day is only good if
+// data.lastUpdate is set. length is the body size received with a status.
+int sunFetchDay(WiFiClient& client, const HttpTarget& api, const char* pathAndQuery, long day,
+                SunData& data, size_t& length, uint32_t timeoutMs);
+
+// Parse a response body; data.lastUpdate is set only on SUN_PARSE_OK
+SunParseResult sunParseResponse(const char* body, size_t length, SunData& data);
+
+// High-water mark and size of the JSON pool, in bytes
+size_t sunJsonPoolPeak();
+size_t sunJsonPoolCapacity();
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+//-----------------------------------------------------------------------------
+// Binary Telemetry
+//-----------------------------------------------------------------------------
+// Compact frames on the debug serial port, decoded on the host with
+// tools/telemetry_decode.py. Each frame is a type byte followed by varint
+// fields and a CRC-8, COBS-encoded and wrapped in 0x00 delimiters so that
+// ordinary text output in between can still be told apart.
+//
+// Frames are queued in a lock-free ring and written by a background task as
+// the UART has room, so the render loop never waits on the serial port.
+// Frames that do not fit in the ring are dropped and counted. The drain
+// holds the serial lock (log.h) while it writes, so a log line never lands
+// inside a frame.
+
+#define TELEMETRY_MAX_PAYLOAD   96
+#define TELEMETRY_MAX_FRAME     (TELEMETRY_MAX_PAYLOAD + TELEMETRY_MAX_PAYLOAD / 254 + 3)
+
+enum TelemetryType : uint8_t
+{
+    TELEMETRY_CLOCK = 1,        // Per-frame clock state, see field list in the decoder
+};
+
+class TelemetryFrame
+{
+public:
+    explicit TelemetryFrame(TelemetryType type);
+
+    void put(uint32_t value);       // Unsigned varint
+    void putSigned(int32_t value);  // Zigzag varint
+    bool send();                    // Queue the frame, false if dropped
+
+    const uint8_t* data() const { return payload; }     // Type byte and fields so far
+    size_t         size() const { return length; }
+    bool           overflowed() const { return overflow; }
+
+private:
+    uint8_t payload[TELEMETRY_MAX_PAYLOAD];
+    size_t  length;
+    bool    overflow;
+};
+
+// Frame codec: payload plus CRC-8, COBS-encoded between 0x00 delimiters.
+// Encode returns the frame length, 0 if the payload is too long; decode
+// takes the bytes between the delimiters and returns the payload length,
+// or -1 for a damaged frame. tools/telemetry_decode.py mirrors decode.
+size_t   telemetryEncode(const uint8_t* payload, size_t length, uint8_t* frame);
+int      telemetryDecode(const uint8_t* block, size_t length, uint8_t* payload, size_t size);
+
+void     telemetryBegin();                      // Start the drain task
+void     telemetryWaitEmpty(uint32_t timeoutMs);// Let queued frames go out, e.g. before sleeping
+uint32_t telemetryDropped();
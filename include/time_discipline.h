@@ -0,0 +1,82 @@
+#pragma once
+
+#include <stdint.h>
+#include <time.h>
+
+//-----------------------------------------------------------------------------
+// Clock Discipline
+//-----------------------------------------------------------------------------
+// What to do with each SNTP result, kept apart from the SNTP and adjtime()
+// calls so it runs unchanged in host tests. Small offsets are slewed so the
+// clock never jumps; only the first sync and offsets beyond
+// TIME_SLEW_LIMIT_MS step it.
+//
+// Each slewed sync also measures how far the RTC drifted since the last
+// one, net of any correction still being slewed in and of the lead given
+// last time. The drift in ppm is averaged across syncs and sets the sync
+// interval: just often enough that drift stays under TIME_TARGET_ERROR_MS,
+// within TIME_SYNC_MIN_MS and TIME_SYNC_MAX_MS.
+//
+// Once the drift is known, each slew leads it by half of what is expected
+// before the next sync, so the error swings between plus and minus half
+// the drift rather than from zero to all of it.
+
+#define TIME_SLEW_LIMIT_MS      10000
+#define TIME_HOLD_LIMIT_S       600
+#define TIME_TARGET_ERROR_MS    250
+#define TIME_SYNC_INITIAL_MS    (60UL * 60 * 1000)          // Until drift is known
+#define TIME_SYNC_MIN_MS        (15UL * 60 * 1000)
+#define TIME_SYNC_MAX_MS        (24UL * 60 * 60 * 1000)
+#define TIME_DRIFT_MIN_SPAN_S   300         // Shorter spans are too noisy to measure drift
+#define TIME_DRIFT_WEIGHT       0.3f        // Weight of each new drift measurement
+
+struct TimeCorrection
+{
+    bool    step;               // Set the clock to the server time
+    int64_t slewUs;             // Otherwise slew it by this much with adjtime()
+    int64_t offsetUs;           // Server minus local
+};
+
+class TimeDiscipline
+{
+public:
+    TimeDiscipline();
+
+    // One SNTP result: server time, local time at the same moment and the
+    // part of the last slew not yet applied
+    TimeCorrection sync(int64_t serverUs, int64_t localUs, int64_t outstandingUs);
+
+    float    driftPpm()   const { return drift; }       // Positive: the local clock runs fast
+    bool     driftKnown() const { return known; }
+    uint32_t intervalMs() const { return interval; }
+
+    // Long enough that drift stays within the target
+    static uint32_t intervalForDrift(float ppm);
+
+private:
+    int64_t  driftRefUs;        // Server time of the last sync, 0 = none
+    int64_t  leadUs;            // Slewed beyond the offset at the last sync
+    float    drift;
+    bool     known;
+    uint32_t interval;
+};
+
+//-----------------------------------------------------------------------------
+// Display Clock
+//-----------------------------------------------------------------------------
+// A step backwards of up to TIME_HOLD_LIMIT_S holds the shown time until
+// real time catches up, so the sun on the dial never moves back; larger
+// steps are real corrections and pass.
+class DisplayClock
+{
+public:
+    DisplayClock() : shown(0), holding(false), holdCount(0) {}
+
+    time_t   show(time_t now);
+    uint32_t holds() const { return holdCount; }
+
+private:
+    time_t   shown;
+    bool     holding;
+    uint32_t holdCount;         // Backward steps held
+};
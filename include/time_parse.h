@@ -0,0 +1,32 @@
+#pragma once
+
+#include <stdint.h>
+
+//-----------------------------------------------------------------------------
+// Timestamp Parsing
+//-----------------------------------------------------------------------------
+// Fixed-format parsers for text from the API and the config. They read
+// digits directly, never allocate, accept null, and reject anything that is
+// not exactly the expected form or is out of range.
+
+struct IsoTimestamp
+{
+    int year;
+    int month;              // 1-12
+    int day;                // 1-31
+    int hour;
+    int minute;
+    int second;             // 0-60 (leap second)
+    int offsetMinutes;      // East of UTC
+};
+
+// "YYYY-MM-DDTHH:MM:SS[.fff](Z|+HH:MM|-HH:MM)"
+bool parseIsoTimestamp(const char* text, IsoTimestamp& out);
+
+// Time of day of an ISO-8601 timestamp as UTC minutes after midnight (0-1439)
+bool parseIsoUtcMinutes(const char* text, int& minutes);
+
+// "HH:MM" (or "H:MM") as minutes after midnight
+bool parseClockTime(const char* text, int& minutes);
+
+void parseBenchmark(const char* args);      // Console command: against strptime
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <stdint.h>
+#include <time.h>
+#include "time_discipline.h"
+
+//-----------------------------------------------------------------------------
+// SNTP Time Sync
+//-----------------------------------------------------------------------------
+// Takes over applying SNTP results (sntp_sync_time is a weak hook in
+// ESP-IDF): each one goes through a TimeDiscipline (time_discipline.h),
+// which decides between a step and an adjtime() slew and sets the next
+// sync interval from the measured drift, so a good crystal means few
+// network wake-ups.
+//
+// timeSyncNow() is the display clock, held against small backward steps.
+
+struct TimeSyncStats
+{
+    uint32_t syncs;
+    uint32_t steps;
+    uint32_t slews;
+    uint32_t holds;                 // Display clock held against a backward step
+    int32_t  lastOffsetMs;          // Server minus local at the last sync
+    float    driftPpm;              // Positive: the local clock runs fast
+    bool     driftKnown;
+    uint32_t intervalMs;            // Current SNTP interval
+    uint32_t lastSyncMs;            // millis() of the last sync, 0 = none yet
+};
+
+// Start SNTP; onSync runs in the SNTP task after each applied sync
+void          timeSyncBegin(const char* server, void (*onSync)());
+time_t        timeSyncNow();
+TimeSyncStats timeSyncStats();
+void          cmdTime(const char* args);    // Console command: "time"
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+//-----------------------------------------------------------------------------
+// Response Writer
+//-----------------------------------------------------------------------------
+// Appends formatted text to a fixed buffer, no heap or String involved.
+// Output past the end is dropped and flagged.
+class ResponseWriter
+{
+public:
+    ResponseWriter(char* buffer, size_t size);
+
+    void print(const char* text);
+    void printf(const char* format, ...) __attribute__((format(printf, 2, 3)));
+    void printJson(const char* text);     // Quoted and escaped as a JSON string
+
+    size_t length()   const { return used; }
+    bool   overflow() const { return truncated; }
+
+private:
+    char*  buffer;
+    size_t size;
+    size_t used;
+    bool   truncated;
+};
+
+//-----------------------------------------------------------------------------
+// HTTP Server
+//-----------------------------------------------------------------------------
+// Minimal HTTP/1.0 server polled from loop(). Handlers serialise into one
+// preallocated buffer and each response goes out in a single write, so a
+// scrape costs one short burst of work between frames.
+//
+// webHandleRequest() holds all the request logic and never touches a
+// socket, so it can be driven directly with request text on a host.
+//
+// Routes answer GET unless registered with webRegisterPost(). Anything that
+// changes state should be a POST route, so a link or image on another site
+// cannot trigger it. POST parameters come in the query string, the request
+// body is ignored.
+
+typedef void (*WebHandler)(ResponseWriter& out, const char* query);
+
+void webRegister(const char* path, const char* contentType, WebHandler handler);
+void webRegisterPost(const char* path, const char* contentType, WebHandler handler);
+void webBegin(uint16_t port);
+void webPoll();
+
+// Next "key=value" pair of a query string, percent-decoded. Advances query;
+// returns false when there are no more pairs.
+bool webQueryParam(const char*& query, char* key, size_t keySize, char* value, size_t valueSize);
+
+// Build the full response (status line, headers, body) for a raw request.
+// A body that does not fit is replaced by a 500 error and counted.
+size_t webHandleRequest(const char* request, char* response, size_t size);
+
+uint32_t webTooLargeResponses();
@@ -0,0 +1,223 @@
+#include "animation.h"
+
+#include <Arduino.h>
+
+//-----------------------------------------------------------------------------
+// Easing
+//-----------------------------------------------------------------------------
+// 33-point curves (32 segments) in 0-255, interpolated linearly between
+// points. Generated with round(255 * f(i / 32)).
+static const uint8_t EASE_LUT[EASE_COUNT - 1][33] =
+{
+    // In: t^3
+    { 0, 0, 0, 0, 0, 1, 2, 3, 4, 6, 8, 10, 13, 17, 21, 26, 32, 38, 45, 53, 62, 72, 83, 95,
+      108, 122, 137, 153, 171, 190, 210, 232, 255 },
+    // Out: 1 - (1 - t)^3
+    { 0, 23, 45, 65, 84, 102, 118, 133, 147, 160, 172, 183, 193, 202, 210, 217, 223, 229,
+      234, 238, 242, 245, 247, 249, 251, 252, 253, 254, 255, 255, 255, 255, 255 },
+    // In-out: (1 - cos(pi t)) / 2
+    { 0, 1, 2, 5, 10, 15, 21, 29, 37, 47, 57, 67, 79, 90, 103, 115, 127, 140, 152, 165, 176,
+      188, 198, 208, 218, 226, 234, 240, 245, 250, 253, 254, 255 }
+};
+
+uint8_t easeApply(Easing easing, uint8_t t)
+{
+    if (easing == EASE_LINEAR || easing >= EASE_COUNT)
+    {
+        return t;
+    }
+    const uint8_t* lut = EASE_LUT[easing - 1];
+    int index = t >> 3;
+    int frac  = t & 7;
+    return lut[index] + (((lut[index + 1] - lut[index]) * frac) >> 3);
+}
+
+//-----------------------------------------------------------------------------
+// Tracks
+//-----------------------------------------------------------------------------
+struct Track
+{
+    const Keyframe* frames;
+    uint8_t         count;
+    uint8_t         repeats;
+};
+
+// Position of the front along the daylight band
+static const Keyframe DAYLIGHT_FRAMES[] =
+{
+    {    0,   0, EASE_LINEAR },
+    { 2500, 255, EASE_IN_OUT }
+};
+
+// Sun brightness, ten one-second pulses
+static const Keyframe PULSE_FRAMES[] =
+{
+    {    0, 255, EASE_LINEAR },
+    {  500,  64, EASE_IN_OUT },
+    { 1000, 255, EASE_IN_OUT }
+};
+
+// Position of the sweep round the dial
+static const Keyframe CHIME_FRAMES[] =
+{
+    {    0,   0, EASE_LINEAR },
+    { 2000, 255, EASE_IN_OUT }
+};
+
+static const Track TRACKS[ANIM_KIND_COUNT] =
+{
+    { DAYLIGHT_FRAMES, 2, 1 },
+    { PULSE_FRAMES,    3, 10 },
+    { CHIME_FRAMES,    2, 1 }
+};
+
+static const char* const KIND_NAMES[ANIM_KIND_COUNT] = { "daylight", "sun pulse", "chime" };
+
+static uint8_t trackValue(const Track& track, uint32_t elapsed)
+{
+    elapsed %= track.frames[track.count - 1].ms;
+    for (int k = 1; k < track.count; k++)
+    {
+        const Keyframe& a = track.frames[k - 1];
+        const Keyframe& b = track.frames[k];
+        if (elapsed < b.ms)
+        {
+            uint8_t t = (uint8_t)(((elapsed - a.ms) << 8) / (b.ms - a.ms));
+            int eased = easeApply(b.easing, t);
+            return (uint8_t)(a.value + ((b.value - a.value) * eased + 127) / 255);
+        }
+    }
+    return track.frames[track.count - 1].value;
+}
+
+//-----------------------------------------------------------------------------
+// Engine
+//-----------------------------------------------------------------------------
+struct Slot
+{
+    bool     active;
+    int8_t   direction;
+    uint8_t  value;
+    uint32_t startMs;
+};
+
+static Slot           slots[ANIM_KIND_COUNT];
+static int            activeCount = 0;
+static AnimationStats stats;
+
+void animStart(AnimationKind kind, uint32_t nowMs, int8_t direction)
+{
+    Slot& slot = slots[kind];
+    slot.active    = true;
+    slot.direction = direction;
+    slot.value     = TRACKS[kind].frames[0].value;
+    slot.startMs   = nowMs;
+    stats.started++;
+}
+
+int animUpdate(uint32_t nowMs)
+{
+    activeCount = 0;
+    for (int i = 0; i < ANIM_KIND_COUNT; i++)
+    {
+        Slot& slot = slots[i];
+        if (!slot.active)
+        {
+            continue;
+        }
+        const Track& track = TRACKS[i];
+        uint32_t elapsed = nowMs - slot.startMs;
+        if (elapsed >= (uint32_t)track.frames[track.count - 1].ms * track.repeats)
+        {
+            slot.active = false;
+            slot.value  = track.frames[track.count - 1].value;
+            continue;
+        }
+        slot.value = trackValue(track, elapsed);
+        activeCount++;
+    }
+    return activeCount;
+}
+
+int animActiveCount()
+{
+    return activeCount;
+}
+
+bool animActive(AnimationKind kind)
+{
+    return slots[kind].active;
+}
+
+uint8_t animValue(AnimationKind kind)
+{
+    return slots[kind].value;
+}
+
+int8_t animDirection(AnimationKind kind)
+{
+    return slots[kind].direction;
+}
+
+//-----------------------------------------------------------------------------
+// Cost
+//-----------------------------------------------------------------------------
+// Frames with and without animation are timed separately, so the difference
+// in average render time is what the animations cost
+void animRecordFrame(uint32_t renderUs)
+{
+    if (activeCount > 0)
+    {
+        stats.activeFrames++;
+        stats.activeUs   += renderUs;
+        stats.activeMaxUs = max(stats.activeMaxUs, renderUs);
+    }
+    else
+    {
+        stats.idleFrames++;
+        stats.idleUs += renderUs;
+    }
+}
+
+const AnimationStats& animStats()
+{
+    return stats;
+}
+
+void cmdAnimation(const char* args)
+{
+    if (strcmp(args, "sunrise") == 0 || strcmp(args, "sunset") == 0)
+    {
+        animStart(ANIM_DAYLIGHT, millis(), args[3] == 'r' ? 1 : -1);
+        animStart(ANIM_SUN_PULSE, millis());
+    }
+    else if (strcmp(args, "chime") == 0)
+    {
+        animStart(ANIM_CHIME, millis());
+    }
+    else if (args[0] != '\0')
+    {
+        Serial.println("Usage: anim [sunrise | sunset | chime]");
+        return;
+    }
+
+    Serial.printf("Animations: %d running, %lu started since boot\n", activeCount, (unsigned long)stats.started);
+    for (int i = 0; i < ANIM_KIND_COUNT; i++)
+    {
+        if (slots[i].active)
+        {
+            Serial.printf("  %-10s value %3u, %lu ms in\n", KIND_NAMES[i], slots[i].value,
+                         (unsigned long)(millis() - slots[i].startMs));
+        }
+    }
+
+    float idleAvg   = stats.idleFrames   ? (float)stats.idleUs   / stats.idleFrames   : 0.0f;
+    float activeAvg = stats.activeFrames ? (float)stats.activeUs / stats.activeFrames : 0.0f;
+    Serial.printf("Render: idle %.1f us over %lu frames, animating %.1f us (max %lu) over %lu frames\n",
+                 idleAvg, (unsigned long)stats.idleFrames, activeAvg,
+                 (unsigned long)stats.activeMaxUs, (unsigned long)stats.activeFrames);
+    if (stats.idleFrames && stats.activeFrames)
+    {
+        Serial.printf("Animation cost: %.1f us per frame\n", activeAvg - idleAvg);
+    }
+}
@@ -0,0 +1,62 @@
+#include "boot_timeline.h"
+
+#include <Arduino.h>
+#include <esp_timer.h>
+
+static const char* const STEP_NAMES[BOOT_STEP_COUNT] = 
+{
+    "serial", "config", "leds", "setup done", "first show", "correct frame", 
+    "wifi begin", "wifi connected", "configTime", "ntp sync", "first fetch"
+};
+
+// Each slot is written once, by whichever task reaches the step
+static volatile uint32_t stamps[BOOT_STEP_COUNT];
+
+void bootMark(BootStep step)
+{
+    if (stamps[step] == 0) 
+    {
+        stamps[step] = max((uint32_t)esp_timer_get_time(), (uint32_t)1);
+    }
+}
+
+uint32_t bootStepUs(BootStep step)
+{
+    return stamps[step];
+}
+
+const char* bootStepName(BootStep step)
+{
+    return step < BOOT_STEP_COUNT ? STEP_NAMES[step] : "-";
+}
+
+// Steps in the order they happened, with the time since the previous one
+void cmdBoot(const char* args)
+{
+    bool     printed[BOOT_STEP_COUNT] = {false};
+    uint32_t previous = 0;
+    Serial.println("Boot timeline (ms since app start, +ms since the previous step):");
+    for (;;) 
+    {
+        int next = -1;
+        for (int i = 0; i < BOOT_STEP_COUNT; i++) 
+        {
+            if (!printed[i] && stamps[i] != 0 && (next < 0 || stamps[i] < stamps[next])) next = i;
+        }
+        if (next < 0) 
+        {
+            break;
+        }
+        printed[next] = true;
+        Serial.printf("  %-15s %9.1f  +%.1f\n", STEP_NAMES[next], stamps[next] / 1000.0f, 
+                     (stamps[next] - previous) / 1000.0f);
+        previous = stamps[next];
+    }
+    for (int i = 0; i < BOOT_STEP_COUNT; i++) 
+    {
+        if (stamps[i] == 0) 
+        {
+            Serial.printf("  %-15s not yet\n", STEP_NAMES[i]);
+        }
+    }
+}
@@ -0,0 +1,13 @@
+#include "compositor.h"
+
+CurrentEstimate Compositor::estimate(uint8_t brightness) const
+{
+    // Channel values are scaled by brightness when shown, both out of 255
+    const uint32_t fullScale = 255UL * 255UL;
+    CurrentEstimate e;
+    e.redMa   = (sums[0] * brightness * LED_RED_MA   + fullScale - 1) / fullScale;
+    e.greenMa = (sums[1] * brightness * LED_GREEN_MA + fullScale - 1) / fullScale;
+    e.blueMa  = (sums[2] * brightness * LED_BLUE_MA  + fullScale - 1) / fullScale;
+    e.idleMa  = count * LED_IDLE_MA;
+    return e;
+}
@@ -0,0 +1,241 @@
+#include "config_store.h"
+#include "time_parse.h"
+
+#include <Arduino.h>
+#include <Preferences.h>
+#include <stddef.h>
+
+//-----------------------------------------------------------------------------
+// Stored Record
+//-----------------------------------------------------------------------------
+#define CONFIG_NAMESPACE    "astroclock"
+#define CONFIG_KEY          "config"
+#define CONFIG_MAGIC        0x4143      // "AC"
+
+struct ConfigRecord
+{
+    uint16_t magic;
+    uint16_t version;
+    uint16_t size;                      // sizeof(Config) when written
+    uint32_t crc;                       // CRC-32 of config
+    Config   config;
+};
+
+// CRC-32 (IEEE), bitwise; only run at boot and on save
+static uint32_t crc32(const uint8_t* data, size_t length)
+{
+    uint32_t crc = 0xFFFFFFFF;
+    for (size_t i = 0; i < length; i++) 
+    {
+        crc ^= data[i];
+        for (int bit = 0; bit < 8; bit++) 
+        {
+            crc = (crc & 1) ? (crc >> 1) ^ 0xEDB88320 : crc >> 1;
+        }
+    }
+    return ~crc;
+}
+
+bool configLoad(Config& config, const Config& defaults)
+{
+    config = defaults;
+
+    Preferences prefs;
+    if (!prefs.begin(CONFIG_NAMESPACE, true)) 
+    {
+        return false;
+    }
+    ConfigRecord record;
+    size_t length = prefs.getBytes(CONFIG_KEY, &record, sizeof(record));
+    prefs.end();
+
+    if (length != sizeof(record) || record.magic != CONFIG_MAGIC || 
+        record.version != CONFIG_VERSION || record.size != sizeof(Config) || 
+        record.crc != crc32((const uint8_t*)&record.config, sizeof(Config))) 
+    {
+        return false;
+    }
+
+    // Strings are terminated in case the record was written by hand
+    config = record.config;
+    config.ssid[sizeof(config.ssid) - 1]                   = '\0';
+    config.password[sizeof(config.password) - 1]           = '\0';
+    config.winterSunrise[sizeof(config.winterSunrise) - 1] = '\0';
+    config.winterSunset[sizeof(config.winterSunset) - 1]   = '\0';
+    config.summerSunrise[sizeof(config.summerSunrise) - 1] = '\0';
+    config.summerSunset[sizeof(config.summerSunset) - 1]   = '\0';
+    return true;
+}
+
+bool configSave(const Config& config)
+{
+    ConfigRecord record;
+    memset(&record, 0, sizeof(record));
+    record.magic   = CONFIG_MAGIC;
+    record.version = CONFIG_VERSION;
+    record.size    = sizeof(Config);
+    record.config  = config;
+    record.crc     = crc32((const uint8_t*)&record.config, sizeof(Config));
+
+    Preferences prefs;
+    if (!prefs.begin(CONFIG_NAMESPACE, false)) 
+    {
+        return false;
+    }
+    size_t written = prefs.putBytes(CONFIG_KEY, &record, sizeof(record));
+    prefs.end();
+    return written == sizeof(record);
+}
+
+void configErase()
+{
+    Preferences prefs;
+    if (prefs.begin(CONFIG_NAMESPACE, false)) 
+    {
+        prefs.remove(CONFIG_KEY);
+        prefs.end();
+    }
+}
+
+//-----------------------------------------------------------------------------
+// Fields
+//-----------------------------------------------------------------------------
+enum ConfigFieldType : uint8_t
+{
+    FIELD_STRING,
+    FIELD_SECRET,
+    FIELD_DOUBLE,
+    FIELD_UINT8,
+    FIELD_UINT16,
+    FIELD_HHMM
+};
+
+struct ConfigField
+{
+    const char*     key;
+    ConfigFieldType type;
+    size_t          offset;
+    size_t          size;
+    double          min;
+    double          max;
+};
+
+#define CONFIG_FIELD(name, type, min, max) \
+    { #name, type, offsetof(Config, name), sizeof(((Config*)0)->name), min, max }
+
+static const ConfigField FIELDS[] = 
+{
+    CONFIG_FIELD(ssid,          FIELD_STRING, 1,    0),
+    CONFIG_FIELD(password,      FIELD_SECRET, 0,    0),
+    CONFIG_FIELD(latitude,      FIELD_DOUBLE, -90,  90),
+    CONFIG_FIELD(longitude,     FIELD_DOUBLE, -180, 180),
+    CONFIG_FIELD(brightness,    FIELD_UINT8,  1,    255),
+    CONFIG_FIELD(numLeds,       FIELD_UINT16, 24,   65535),
+    CONFIG_FIELD(winterSunrise, FIELD_HHMM,   0,    0),
+    CONFIG_FIELD(winterSunset,  FIELD_HHMM,   0,    0),
+    CONFIG_FIELD(summerSunrise, FIELD_HHMM,   0,    0),
+    CONFIG_FIELD(summerSunset,  FIELD_HHMM,   0,    0),
+};
+static const int FIELD_COUNT = sizeof(FIELDS) / sizeof(FIELDS[0]);
+
+static const ConfigField* findField(const char* key)
+{
+    for (int i = 0; i < FIELD_COUNT; i++) 
+    {
+        if (strcasecmp(FIELDS[i].key, key) == 0) 
+        {
+            return &FIELDS[i];
+        }
+    }
+    return nullptr;
+}
+
+// Whole-string number within range
+static bool parseNumber(const char* text, double min, double max, double& out)
+{
+    char* end;
+    out = strtod(text, &end);
+    return end != text && *end == '\0' && out >= min && out <= max;
+}
+
+bool configSet(Config& config, const char* key, const char* value)
+{
+    const ConfigField* field = findField(key);
+    if (field == nullptr) 
+    {
+        return false;
+    }
+    uint8_t* target = (uint8_t*)&config + field->offset;
+    double number;
+    int minutes;
+
+    switch (field->type) 
+    {
+    case FIELD_STRING:
+    case FIELD_SECRET:
+        if (strlen(value) < field->min || strlen(value) >= field->size) 
+        {
+            return false;
+        }
+        strcpy((char*)target, value);
+        return true;
+    case FIELD_HHMM:
+        if (!parseClockTime(value, minutes)) 
+        {
+            return false;
+        }
+        snprintf((char*)target, field->size, "%02d:%02d", minutes / 60, minutes % 60);
+        return true;
+    case FIELD_DOUBLE:
+        if (!parseNumber(value, field->min, field->max, number)) return false;
+        *(double*)target = number;
+        return true;
+    case FIELD_UINT8:
+        if (!parseNumber(value, field->min, field->max, number) || number != (int)number) return false;
+        *(uint8_t*)target = (uint8_t)number;
+        return true;
+    case FIELD_UINT16:
+        if (!parseNumber(value, field->min, field->max, number) || number != (int)number) return false;
+        *(uint16_t*)target = (uint16_t)number;
+        return true;
+    }
+    return false;
+}
+
+int configFieldCount()
+{
+    return FIELD_COUNT;
+}
+
+const char* configFieldKey(int field)
+{
+    return FIELDS[field].key;
+}
+
+bool configFieldValue(const Config& config, int field, char* out, size_t size)
+{
+    const ConfigField& f = FIELDS[field];
+    const uint8_t* source = (const uint8_t*)&config + f.offset;
+
+    switch (f.type) 
+    {
+    case FIELD_SECRET:
+        snprintf(out, size, "%s", *(const char*)source ? "********" : "");
+        return true;
+    case FIELD_STRING:
+    case FIELD_HHMM:
+        snprintf(out, size, "%s", (const char*)source);
+        return true;
+    case FIELD_DOUBLE:
+        snprintf(out, size, "%.7f", *(const double*)source);
+        return false;
+    case FIELD_UINT8:
+        snprintf(out, size, "%u", *(const uint8_t*)source);
+        return false;
+    case FIELD_UINT16:
+        snprintf(out, size, "%u", *(const uint16_t*)source);
+        return false;
+    }
+    out[0] = '\0';
+    return false;
+}
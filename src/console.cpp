@@ -0,0 +1,90 @@
+#include "console.h"
+
+#include <Arduino.h>
+#include "log.h"
+
+//-----------------------------------------------------------------------------
+// Command Table
+//-----------------------------------------------------------------------------
+#define CONSOLE_MAX_COMMANDS    32
+#define CONSOLE_LINE_LENGTH     96
+
+struct ConsoleCommand
+{
+    const char*    name;
+    ConsoleHandler handler;
+    const char*    help;
+};
+
+static ConsoleCommand commands[CONSOLE_MAX_COMMANDS];
+static int  commandCount = 0;
+static char line[CONSOLE_LINE_LENGTH];
+static int  lineLength = 0;
+
+void consoleRegister(const char* name, ConsoleHandler handler, const char* help)
+{
+    if (commandCount == CONSOLE_MAX_COMMANDS) 
+    {
+        LOG_ERROR(LOG_SYSTEM, "Console full, \"%s\" not registered (raise CONSOLE_MAX_COMMANDS)", name);
+        return;
+    }
+    commands[commandCount++] = { name, handler, help };
+}
+
+static void printHelp()
+{
+    Serial.println("Commands:");
+    for (int i = 0; i < commandCount; i++) 
+    {
+        Serial.printf("  %-8s %s\n", commands[i].name, commands[i].help);
+    }
+}
+
+static void dispatch(char* text)
+{
+    // Split the command name from its arguments
+    while (*text == ' ') text++;
+    char* args = text;
+    while (*args && *args != ' ') args++;
+    if (*args) *args++ = '\0';
+    while (*args == ' ') args++;
+
+    if (*text == '\0') 
+    {
+        return;
+    }
+    for (int i = 0; i < commandCount; i++) 
+    {
+        if (strcmp(text, commands[i].name) == 0) 
+        {
+            commands[i].handler(args);
+            return;
+        }
+    }
+    if (strcmp(text, "help") != 0) 
+    {
+        Serial.printf("Unknown command: %s\n", text);
+    }
+    printHelp();
+}
+
+//-----------------------------------------------------------------------------
+// Polling
+//-----------------------------------------------------------------------------
+void consolePoll()
+{
+    while (Serial.available() > 0) 
+    {
+        char c = (char)Serial.read();
+        if (c == '\r' || c == '\n') 
+        {
+            line[lineLength] = '\0';
+            dispatch(line);
+            lineLength = 0;
+        }
+        else if (lineLength < CONSOLE_LINE_LENGTH - 1) 
+        {
+            line[lineLength++] = c;
+        }
+    }
+}
@@ -0,0 +1,109 @@
+#include "event_timeline.h"
+
+#include <stdio.h>
+
+void EventTimeline::clear(long day)
+{
+    timelineDay = day;
+    eventCount  = 0;
+}
+
+void EventTimeline::add(time_t at, EventKind kind)
+{
+    time_t start = (time_t)timelineDay * 24*60*60;
+    if (at < start || at > start + 24*60*60 || eventCount == TIMELINE_MAX_EVENTS)
+    {
+        return;
+    }
+    events[eventCount].at   = at;
+    events[eventCount].kind = kind;
+    eventCount++;
+}
+
+// Insertion sort: a few dozen events, mostly added in order, once a day
+void EventTimeline::sort()
+{
+    for (int i = 1; i < eventCount; i++)
+    {
+        TimelineEvent event = events[i];
+        int j = i;
+        while (j > 0 && events[j - 1].at > event.at)
+        {
+            events[j] = events[j - 1];
+            j--;
+        }
+        events[j] = event;
+    }
+}
+
+const TimelineEvent* EventTimeline::next(time_t now, uint32_t kinds) const
+{
+    // First event later than now
+    int low = 0, high = eventCount;
+    while (low < high)
+    {
+        int middle = (low + high) / 2;
+        if (events[middle].at <= now)
+        {
+            low = middle + 1;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+
+    for (int i = low; i < eventCount; i++)
+    {
+        if (kinds & EVENT_MASK(events[i].kind))
+        {
+            return &events[i];
+        }
+    }
+    return nullptr;
+}
+
+long EventTimeline::secondsToNext(time_t now, uint32_t kinds, EventKind* kind) const
+{
+    const TimelineEvent* event = next(now, kinds);
+    long tomorrow = 0;
+    if (!event)
+    {
+        event    = next((time_t)timelineDay * 24*60*60 - 1, kinds);
+        tomorrow = 24*60*60;
+    }
+    if (!event)
+    {
+        return -1;
+    }
+    if (kind)
+    {
+        *kind = event->kind;
+    }
+    return (long)(event->at - now) + tomorrow;
+}
+
+const char* eventName(EventKind kind)
+{
+    static const char* const names[EVENT_KIND_COUNT] =
+    {
+        "dawn", "sunrise", "solar noon", "sunset", "dusk", "hour", "midnight", "DST change", "sun data refresh"
+    };
+    return kind < EVENT_KIND_COUNT ? names[kind] : "?";
+}
+
+void formatCountdown(char* out, size_t size, long seconds)
+{
+    if (seconds >= 3600)
+    {
+        snprintf(out, size, "%ldh%02ldm", seconds / 3600, (seconds / 60) % 60);
+    }
+    else if (seconds >= 60)
+    {
+        snprintf(out, size, "%ldm", seconds / 60);
+    }
+    else
+    {
+        snprintf(out, size, "%lds", seconds < 0 ? 0 : seconds);
+    }
+}
@@ -0,0 +1,161 @@
+#include "geometry.h"
+
+#include <Arduino.h>
+
+//-----------------------------------------------------------------------------
+// Spans
+//-----------------------------------------------------------------------------
+// A span continues while each logical LED is the next strip LED in the same
+// direction, or while LEDs stay unmapped
+void LedGeometry::begin(const uint16_t* map, int logical, int physical)
+{
+    table         = map;
+    logicalLeds   = logical;
+    physicalCount = physical;
+    spanCount     = 0;
+
+    int start = 0;
+    int step  = 0;
+    for (int i = 1; i <= logicalLeds; i++)
+    {
+        bool startShown = table[start] < physicalCount;
+        if (i < logicalLeds)
+        {
+            bool shown = table[i] < physicalCount;
+            int  delta = (int)table[i] - (int)table[i - 1];
+            if (!shown && !startShown)
+            {
+                continue;
+            }
+            if (shown && startShown && (delta == 1 || delta == -1) && (step == 0 || delta == step))
+            {
+                step = delta;
+                continue;
+            }
+        }
+
+        if (spanCount == GEOMETRY_MAX_SPANS)
+        {
+            spanCount = -1;
+            return;
+        }
+        GeometrySpan& span = spans[spanCount++];
+        span.logical  = start;
+        span.physical = table[start];
+        span.count    = i - start;
+        span.step     = !startShown ? 0 : step == 0 ? 1 : step;
+        start = i;
+        step  = 0;
+    }
+}
+
+void LedGeometry::remap(const CRGB* logical, CRGB* physical) const
+{
+    if (spanCount < 0)
+    {
+        for (int i = 0; i < logicalLeds; i++)
+        {
+            physical[table[i]] = logical[i];
+        }
+        return;
+    }
+
+    for (int n = 0; n < spanCount; n++)
+    {
+        const GeometrySpan& span = spans[n];
+        if (span.step > 0)
+        {
+            memcpy(&physical[span.physical], &logical[span.logical], span.count * sizeof(CRGB));
+        }
+        else if (span.step < 0)
+        {
+            const CRGB* from = &logical[span.logical];
+            CRGB*       to   = &physical[span.physical];
+            for (int i = 0; i < span.count; i++)
+            {
+                *to-- = *from++;
+            }
+        }
+    }
+}
+
+int LedGeometry::extent(int logical) const
+{
+    int end = 0;
+    for (int i = 0; i < logical && i < logicalLeds; i++)
+    {
+        if (table[i] < physicalCount && table[i] >= end) end = table[i] + 1;
+    }
+    return end;
+}
+
+int LedGeometry::overlaps() const
+{
+    uint8_t* claimed = (uint8_t*)calloc((physicalCount + 7) / 8 + 1, 1);
+    if (!claimed)
+    {
+        return 0;
+    }
+
+    int count = 0;
+    for (int i = 0; i < logicalLeds; i++)
+    {
+        int p = table[i];
+        if (p >= physicalCount)
+        {
+            continue;
+        }
+        if (claimed[p / 8] & (1 << (p % 8)))
+        {
+            count++;
+        }
+        claimed[p / 8] |= 1 << (p % 8);
+    }
+    free(claimed);
+    return count;
+}
+
+//-----------------------------------------------------------------------------
+// Report
+//-----------------------------------------------------------------------------
+#define GEOMETRY_BENCH_PASSES   100
+#define GEOMETRY_TARGET_NS      1000    // Per 100 LEDs
+
+void LedGeometry::report(const CRGB* logical, CRGB* physical) const
+{
+    Serial.printf("Geometry: %d logical LEDs on %d strip LEDs\n", logicalLeds, physicalCount);
+    if (spanCount < 0)
+    {
+        Serial.printf("  more than %d spans, remapped LED by LED\n", GEOMETRY_MAX_SPANS);
+    }
+    for (int n = 0; n < spanCount; n++)
+    {
+        const GeometrySpan& span = spans[n];
+        if (span.step == 0)
+        {
+            Serial.printf("  logical %3d-%3d  not shown\n", span.logical, span.logical + span.count - 1);
+        }
+        else
+        {
+            Serial.printf("  logical %3d-%3d  strip %3d-%3d\n", span.logical, span.logical + span.count - 1,
+                         span.physical, span.physical + span.step * (span.count - 1));
+        }
+    }
+    int claimedTwice = overlaps();
+    if (claimedTwice)
+    {
+        Serial.printf("  %d strip LEDs are claimed twice, check the geometry\n", claimedTwice);
+    }
+
+    uint32_t start = ESP.getCycleCount();
+    for (int n = 0; n < GEOMETRY_BENCH_PASSES; n++)
+    {
+        remap(logical, physical);
+    }
+    uint32_t cycles = (ESP.getCycleCount() - start) / GEOMETRY_BENCH_PASSES;
+    float ns     = cycles * 1000.0f / ESP.getCpuFreqMHz();
+    float per100 = ns * 100.0f / max(logicalLeds, 1);
+    Serial.printf("Remap: %lu cycles (%.2f us) per frame, %.0f ns per 100 LEDs (%s %d ns)\n",
+                 (unsigned long)cycles, ns / 1000.0f, per100,
+                 per100 <= GEOMETRY_TARGET_NS ? "within" : "over", GEOMETRY_TARGET_NS);
+}
@@ -0,0 +1,298 @@
+#include "health.h"
+
+#include <Arduino.h>
+#include <Preferences.h>
+#include <esp_attr.h>
+#include <esp_system.h>
+#include <esp_task_wdt.h>
+#include <sys/time.h>
+#include "boot_timeline.h"
+#include "log.h"
+
+//-----------------------------------------------------------------------------
+// Stages
+//-----------------------------------------------------------------------------
+struct StagePolicy
+{
+    const char* name;
+    bool        restartNetwork;
+    bool        reset;
+};
+
+static const StagePolicy POLICIES[HEALTH_STAGE_COUNT] = 
+{
+    { "render",  false, true  },
+    { "network", true,  false },
+    { "fetch",   true,  true  },
+};
+
+static const char* const RESET_NAMES[HEALTH_RESET_REASONS] = 
+{
+    "unknown", "power-on", "external", "software", "panic", "interrupt-wdt", 
+    "task-wdt", "other-wdt", "deep-sleep", "brownout", "sdio"
+};
+
+static volatile uint32_t lastBeat[HEALTH_STAGE_COUNT];
+static volatile uint32_t timeouts[HEALTH_STAGE_COUNT];     // 0 = not watched
+static uint32_t          restartedAt[HEALTH_STAGE_COUNT];  // Network restart for a stall, 0 = none
+static void            (*restartNetworkHandler)() = nullptr;
+
+const char* healthStageName(int stage)
+{
+    return (stage >= 0 && stage < HEALTH_STAGE_COUNT) ? POLICIES[stage].name : "-";
+}
+
+const char* healthResetName(int reason)
+{
+    return (reason >= 0 && reason < HEALTH_RESET_REASONS) ? RESET_NAMES[reason] : "-";
+}
+
+//-----------------------------------------------------------------------------
+// Counts (NVS)
+//-----------------------------------------------------------------------------
+#define HEALTH_NAMESPACE    "health"
+#define HEALTH_KEY          "counts"
+
+static HealthCounts counts;
+
+static void loadCounts()
+{
+    Preferences prefs;
+    memset(&counts, 0, sizeof(counts));
+    if (prefs.begin(HEALTH_NAMESPACE, true)) 
+    {
+        if (prefs.getBytes(HEALTH_KEY, &counts, sizeof(counts)) != sizeof(counts)) 
+        {
+            memset(&counts, 0, sizeof(counts));
+        }
+        prefs.end();
+    }
+}
+
+static void saveCounts()
+{
+    Preferences prefs;
+    if (prefs.begin(HEALTH_NAMESPACE, false)) 
+    {
+        prefs.putBytes(HEALTH_KEY, &counts, sizeof(counts));
+        prefs.end();
+    }
+}
+
+const HealthCounts& healthCounts()
+{
+    return counts;
+}
+
+//-----------------------------------------------------------------------------
+// Preserved Frame (RTC)
+//-----------------------------------------------------------------------------
+// magic is cleared while the frame is copied, so a reset part way through
+// a copy leaves nothing to restore rather than a torn frame
+#define HEALTH_MAGIC    0x484C5448      // "HLTH"
+
+struct PreservedState
+{
+    uint32_t magic;
+    uint32_t epoch;                     // Time when last written
+    uint16_t ledCount;
+    uint8_t  cause;                     // Stage + 1 of the last soft reset, 0 = none
+    CRGB     frame[HEALTH_MAX_LEDS];
+};
+
+RTC_NOINIT_ATTR static PreservedState preserved;
+
+static int         lastReason = 0;
+static int         lastCause  = 0;
+
+void healthSaveFrame(const CRGB* leds, int count)
+{
+    if (count > HEALTH_MAX_LEDS) 
+    {
+        return;
+    }
+    preserved.magic = 0;
+    memcpy(preserved.frame, leds, count * sizeof(CRGB));
+    preserved.ledCount = count;
+    preserved.epoch    = time(nullptr);
+    preserved.magic    = HEALTH_MAGIC;
+}
+
+bool healthRestore(CRGB* leds, int count, time_t validAfter)
+{
+    lastReason = esp_reset_reason();
+    loadCounts();
+    if (lastReason >= 0 && lastReason < HEALTH_RESET_REASONS) 
+    {
+        counts.resets[lastReason]++;
+        saveCounts();
+    }
+
+    bool valid = lastReason != ESP_RST_POWERON && preserved.magic == HEALTH_MAGIC;
+    lastCause  = (valid && lastReason == ESP_RST_SW && preserved.cause <= HEALTH_STAGE_COUNT) ? preserved.cause : 0;
+    LOG_INFO(LOG_SYSTEM, "Reset reason: %s%s%s", healthResetName(lastReason), 
+             lastCause ? ", recovering from stalled " : "", lastCause ? healthStageName(lastCause - 1) : "");
+    if (!valid || preserved.ledCount != count) 
+    {
+        preserved.magic = 0;
+        preserved.cause = 0;
+        return false;
+    }
+    preserved.cause = 0;
+
+    memcpy(leds, preserved.frame, count * sizeof(CRGB));
+    if (time(nullptr) < validAfter && (time_t)preserved.epoch >= validAfter) 
+    {
+        // Good to a few seconds until SNTP catches up
+        struct timeval tv = { (time_t)preserved.epoch + 1, 0 };
+        settimeofday(&tv, nullptr);
+    }
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+// Heartbeats
+//-----------------------------------------------------------------------------
+void healthWatch(HealthStage stage, uint32_t timeoutMs)
+{
+    lastBeat[stage]    = millis();
+    restartedAt[stage] = 0;
+    timeouts[stage]    = timeoutMs;
+}
+
+void healthBeat(HealthStage stage)
+{
+    lastBeat[stage] = millis();
+    if (stage == HEALTH_RENDER) 
+    {
+        esp_task_wdt_reset();
+    }
+}
+
+// Deadlines move on by the pause; beats land "in the future"
+void healthPause(uint32_t ms)
+{
+    uint32_t resume = millis() + ms;
+    for (int i = 0; i < HEALTH_STAGE_COUNT; i++) 
+    {
+        lastBeat[i] = resume;
+    }
+    esp_task_wdt_reset();
+}
+
+//-----------------------------------------------------------------------------
+// Supervisor
+//-----------------------------------------------------------------------------
+static void softReset(int stage)
+{
+    LOG_ERROR(LOG_SYSTEM, "%s stalled, resetting", healthStageName(stage));
+    counts.softResets[stage]++;
+    saveCounts();
+
+    preserved.cause = stage + 1;
+    if (preserved.magic == HEALTH_MAGIC) 
+    {
+        preserved.epoch = time(nullptr);
+    }
+    delay(100);     // Let the log task print
+    esp_restart();
+}
+
+static void restartNetwork(int stage)
+{
+    LOG_WARN(LOG_SYSTEM, "%s stalled, restarting the network", healthStageName(stage));
+    counts.networkRestarts[stage]++;
+    saveCounts();
+    restartedAt[stage] = millis();
+    if (restartNetworkHandler != nullptr) 
+    {
+        restartNetworkHandler();
+    }
+}
+
+static void supervisorTask(void* param)
+{
+    for (;;) 
+    {
+        vTaskDelay(pdMS_TO_TICKS(HEALTH_CHECK_MS));
+        uint32_t now = millis();
+
+        for (int i = 0; i < HEALTH_STAGE_COUNT; i++) 
+        {
+            uint32_t timeout = timeouts[i];
+            if (timeout == 0 || (int32_t)(now - lastBeat[i]) <= (int32_t)timeout) 
+            {
+                restartedAt[i] = 0;
+                continue;
+            }
+
+            const StagePolicy& policy = POLICIES[i];
+            uint32_t sinceRestart = now - restartedAt[i];
+            if (policy.restartNetwork && restartedAt[i] == 0) 
+            {
+                restartNetwork(i);
+            }
+            else if (policy.reset && (!policy.restartNetwork || sinceRestart > HEALTH_ESCALATE_MS)) 
+            {
+                softReset(i);
+            }
+            else if (!policy.reset && sinceRestart > timeout) 
+            {
+                restartNetwork(i);
+            }
+        }
+    }
+}
+
+void healthBegin(void (*restartNetwork)())
+{
+    restartNetworkHandler = restartNetwork;
+    esp_task_wdt_init(HEALTH_TWDT_S, true);
+    esp_task_wdt_add(nullptr);
+    xTaskCreatePinnedToCore(supervisorTask, "health", 3072, nullptr, 2, nullptr, 0);
+}
+
+//-----------------------------------------------------------------------------
+// Report
+//-----------------------------------------------------------------------------
+void cmdHealth(const char* args)
+{
+    uint32_t now = millis();
+    Serial.printf("Last reset: %s%s%s\n", healthResetName(lastReason), 
+                 lastCause ? ", recovered from stalled " : "", lastCause ? healthStageName(lastCause - 1) : "");
+
+    // The app start is the reset, so the boot stamp is the recovery time
+    uint32_t correctUs = bootStepUs(BOOT_CORRECT_FRAME);
+    if (correctUs != 0) 
+    {
+        Serial.printf("Correct frame %lu ms after the reset\n", (unsigned long)(correctUs / 1000));
+    }
+    else 
+    {
+        Serial.println("No correct frame yet");
+    }
+    for (int i = 0; i < HEALTH_STAGE_COUNT; i++) 
+    {
+        int32_t age = (int32_t)(now - lastBeat[i]);
+        Serial.printf("  %-8s ", POLICIES[i].name);
+        if (timeouts[i] == 0) 
+        {
+            Serial.print("not watched");
+        }
+        else 
+        {
+            Serial.printf("beat %ld ms ago (limit %lu)", (long)max(age, (int32_t)0), (unsigned long)timeouts[i]);
+        }
+        Serial.printf(", %u network restarts, %u resets\n", 
+                     (unsigned)counts.networkRestarts[i], (unsigned)counts.softResets[i]);
+    }
+    Serial.print("Resets:");
+    for (int i = 0; i < HEALTH_RESET_REASONS; i++) 
+    {
+        if (counts.resets[i] != 0) 
+        {
+            Serial.printf(" %s %u", RESET_NAMES[i], (unsigned)counts.resets[i]);
+        }
+    }
+    Serial.println();
+}
@@ -0,0 +1,241 @@
+#include "http_fetch.h"
+
+#include <Arduino.h>
+#include <WiFi.h>
+
+//-----------------------------------------------------------------------------
+// URL
+//-----------------------------------------------------------------------------
+bool httpParseUrl(const char* url, HttpTarget& target)
+{
+    const char* p;
+    if (strncmp(url, "https://", 8) == 0) 
+    {
+        target.secure = true;
+        target.port   = 443;
+        p = url + 8;
+    }
+    else if (strncmp(url, "http://", 7) == 0) 
+    {
+        target.secure = false;
+        target.port   = 80;
+        p = url + 7;
+    }
+    else 
+    {
+        return false;
+    }
+
+    size_t n = 0;
+    while (*p && *p != ':' && *p != '/' && n < sizeof(target.host) - 1) target.host[n++] = *p++;
+    target.host[n] = '\0';
+    if (n == 0) 
+    {
+        return false;
+    }
+    if (*p == ':') 
+    {
+        target.port = (uint16_t)strtoul(p + 1, (char**)&p, 10);
+    }
+
+    n = 0;
+    if (*p != '/') target.path[n++] = '/';
+    while (*p && n < sizeof(target.path) - 1) target.path[n++] = *p++;
+    target.path[n] = '\0';
+    return *p == '\0';
+}
+
+//-----------------------------------------------------------------------------
+// Reading
+//-----------------------------------------------------------------------------
+// Wait for data until the deadline; false on timeout or a closed connection
+static bool waitForData(WiFiClient& client, unsigned long deadline)
+{
+    while (client.available() <= 0) 
+    {
+        if (!client.connected() || (long)(millis() - deadline) >= 0) 
+        {
+            return false;
+        }
+        delay(1);
+    }
+    return true;
+}
+
+// One CRLF-terminated line, without the terminator. Overlong lines are cut
+// short but still consumed.
+static bool readLine(WiFiClient& client, char* line, size_t size, unsigned long deadline)
+{
+    size_t n = 0;
+    for (;;) 
+    {
+        if (!waitForData(client, deadline)) 
+        {
+            return false;
+        }
+        int c = client.read();
+        if (c < 0 || c == '\n') 
+        {
+            break;
+        }
+        if (c != '\r' && n < size - 1) line[n++] = (char)c;
+    }
+    line[n] = '\0';
+    return true;
+}
+
+// Exactly count bytes into out (or discarded if out is null)
+static bool readBytes(WiFiClient& client, char* out, size_t count, unsigned long deadline)
+{
+    char discard[32];
+    while (count > 0) 
+    {
+        if (!waitForData(client, deadline)) 
+        {
+            return false;
+        }
+        size_t want = out ? count : min(count, sizeof(discard));
+        int n = client.read((uint8_t*)(out ? out : discard), want);
+        if (n <= 0) 
+        {
+            continue;
+        }
+        count -= n;
+        if (out) out += n;
+    }
+    return true;
+}
+
+static bool headerIs(const char* line, const char* name)
+{
+    return strncasecmp(line, name, strlen(name)) == 0;
+}
+
+//-----------------------------------------------------------------------------
+// Request
+//-----------------------------------------------------------------------------
+static int fail(WiFiClient& client, int error)
+{
+    client.stop();
+    return error;
+}
+
+int httpFetch(WiFiClient& client, const HttpTarget& target, const char* pathAndQuery, 
+              char* body, size_t size, size_t& length, uint32_t timeoutMs)
+{
+    unsigned long deadline = millis() + timeoutMs;
+    length  = 0;
+    body[0] = '\0';
+
+    if (!client.connected() && !client.connect(target.host, target.port)) 
+    {
+        return fail(client, HTTP_FETCH_ERROR_CONNECT);
+    }
+
+    char line[192];
+    bool defaultPort = target.port == (target.secure ? 443 : 80);
+    int requestLength = snprintf(line, sizeof(line), defaultPort ? 
+                                 "GET %s HTTP/1.1\r\nHost: %s\r\nConnection: keep-alive\r\n\r\n" : 
+                                 "GET %s HTTP/1.1\r\nHost: %s:%u\r\nConnection: keep-alive\r\n\r\n", 
+                                 pathAndQuery, target.host, target.port);
+    if (requestLength <= 0 || requestLength >= (int)sizeof(line) || 
+        client.write((const uint8_t*)line, requestLength) != (size_t)requestLength) 
+    {
+        return fail(client, HTTP_FETCH_ERROR_SEND);
+    }
+
+    // Status line and the headers that shape the body
+    int status = 0;
+    if (!readLine(client, line, sizeof(line), deadline)) 
+    {
+        return fail(client, HTTP_FETCH_ERROR_TIMEOUT);
+    }
+    if (sscanf(line, "HTTP/1.%*d %d", &status) != 1) 
+    {
+        return fail(client, HTTP_FETCH_ERROR_HEADER);
+    }
+
+    long contentLength = -1;
+    bool chunked = false, close = false;
+    for (;;) 
+    {
+        if (!readLine(client, line, sizeof(line), deadline)) 
+        {
+            return fail(client, HTTP_FETCH_ERROR_TIMEOUT);
+        }
+        if (line[0] == '\0') 
+        {
+            break;
+        }
+        if (headerIs(line, "Content-Length:"))    contentLength = strtol(line + 15, nullptr, 10);
+        if (headerIs(line, "Transfer-Encoding:")) chunked = strstr(line, "chunked") != nullptr;
+        if (headerIs(line, "Connection:"))        close = strstr(line, "close") != nullptr;
+    }
+
+    // Body
+    if (chunked) 
+    {
+        for (;;) 
+        {
+            if (!readLine(client, line, sizeof(line), deadline)) 
+            {
+                return fail(client, HTTP_FETCH_ERROR_TIMEOUT);
+            }
+            size_t chunk = strtoul(line, nullptr, 16);
+            if (chunk == 0) 
+            {
+                // Trailers end with an empty line
+                while (readLine(client, line, sizeof(line), deadline) && line[0] != '\0') {}
+                break;
+            }
+            if (chunk >= size - length) 
+            {
+                return fail(client, HTTP_FETCH_ERROR_TOO_LARGE);
+            }
+            if (!readBytes(client, body + length, chunk, deadline) || 
+                !readLine(client, line, sizeof(line), deadline)) 
+            {
+                return fail(client, HTTP_FETCH_ERROR_TIMEOUT);
+            }
+            length += chunk;
+        }
+    }
+    else if (contentLength >= 0) 
+    {
+        if ((size_t)contentLength >= size) 
+        {
+            return fail(client, HTTP_FETCH_ERROR_TOO_LARGE);
+        }
+        if (!readBytes(client, body, contentLength, deadline)) 
+        {
+            return fail(client, HTTP_FETCH_ERROR_TIMEOUT);
+        }
+        length = contentLength;
+    }
+    else 
+    {
+        // No length: the body runs to the end of the connection
+        while (waitForData(client, deadline)) 
+        {
+            if (length >= size - 1) 
+            {
+                return fail(client, HTTP_FETCH_ERROR_TOO_LARGE);
+            }
+            int n = client.read((uint8_t*)body + length, size - 1 - length);
+            if (n > 0) length += n;
+        }
+        if (client.connected()) 
+        {
+            // Out of time before the server closed: the body may be cut short
+            return fail(client, HTTP_FETCH_ERROR_TIMEOUT);
+        }
+        close = true;
+    }
+    body[length] = '\0';
+
+    if (close) 
+    {
+        client.stop();
+    }
+    return status;
+}
@@ -0,0 +1,112 @@
+#include "layers.h"
+
+#include <Arduino.h>
+
+//-----------------------------------------------------------------------------
+// Benchmark
+//-----------------------------------------------------------------------------
+// The same layers behind a virtual interface, drawn the same way, for
+// comparison with the template pipeline
+#define LAYER_BENCH_LEDS    332
+#define LAYER_BENCH_FRAMES  50
+
+struct VirtualLayer
+{
+    virtual ~VirtualLayer() {}
+    virtual void begin(const DialContext& dial) = 0;
+    virtual void shade(const DialContext& dial, int i, CRGB& color) = 0;
+};
+
+template<typename T>
+struct VirtualAdapter : VirtualLayer
+{
+    T layer;
+
+    void begin(const DialContext& dial) override { layer.begin(dial); }
+    void shade(const DialContext& dial, int i, CRGB& color) override { layer.apply(dial, i, color); }
+};
+
+static void renderVirtual(Compositor& frame, const DialContext& dial, VirtualLayer* const* layers, int count)
+{
+    for (int n = 0; n < count; n++)
+    {
+        layers[n]->begin(dial);
+    }
+    for (int i = 0; i < dial.count; i++)
+    {
+        CRGB color = CRGB::Black;
+        for (int n = 0; n < count; n++)
+        {
+            layers[n]->shade(dial, i, color);
+        }
+        frame.set(dial.first + i, color);
+    }
+}
+
+void layerBenchmark(const char* args)
+{
+    static CRGB scratch[LAYER_BENCH_LEDS];
+    Compositor frame(scratch, LAYER_BENCH_LEDS);
+
+    DialContext dial;
+    dial.first         = 0;
+    dial.count         = LAYER_BENCH_LEDS;
+    dial.secondsPerLed = (24*60*60) / LAYER_BENCH_LEDS;
+    dial.sunLED        = (13 * 3600) / dial.secondsPerLed;
+    dial.sunriseLED    = (4 * 3600) / dial.secondsPerLed;
+    dial.sunsetLED     = (20 * 3600) / dial.secondsPerLed;
+    dial.solarNoonLED  = (12 * 3600) / dial.secondsPerLed;
+    dial.twilightLEDs  = (35 * 60) / dial.secondsPerLed;
+    dial.showSolstices = true;
+    dial.solsticeLEDs[0] = (8 * 3600) / dial.secondsPerLed;
+    dial.solsticeLEDs[1] = (16 * 3600) / dial.secondsPerLed;
+    dial.solsticeLEDs[2] = (3 * 3600 + 1800) / dial.secondsPerLed;
+    dial.solsticeLEDs[3] = (21 * 3600) / dial.secondsPerLed;
+    dial.animate       = true;
+    dial.nextEventLED  = dial.sunsetLED;
+
+    ClockLayers pipeline;
+    uint32_t start = ESP.getCycleCount();
+    for (int f = 0; f < LAYER_BENCH_FRAMES; f++)
+    {
+        pipeline.render(frame, dial);
+    }
+    uint32_t staticCycles = ESP.getCycleCount() - start;
+    uint32_t check = frame.estimate(255).totalMa();
+
+    // Heap objects behind a volatile pointer so the calls cannot be devirtualised
+    VirtualLayer* layers[] =
+    {
+        new VirtualAdapter<DaylightLayer>(), new VirtualAdapter<TwilightLayer>(),
+        new VirtualAdapter<DaylightFadeLayer>(), new VirtualAdapter<CountdownLayer>(),
+        new VirtualAdapter<HourTickLayer>(), new VirtualAdapter<SolsticeLayer>(),
+        new VirtualAdapter<SunLayer>(), new VirtualAdapter<SunPulseLayer>(),
+        new VirtualAdapter<ChimeLayer>()
+    };
+    VirtualLayer* const* volatile table = layers;
+    const int count = sizeof(layers) / sizeof(layers[0]);
+
+    frame.clear();
+    start = ESP.getCycleCount();
+    for (int f = 0; f < LAYER_BENCH_FRAMES; f++)
+    {
+        renderVirtual(frame, dial, table, count);
+    }
+    uint32_t virtualCycles = ESP.getCycleCount() - start;
+    bool same = frame.estimate(255).totalMa() == check;
+
+    for (int n = 0; n < count; n++)
+    {
+        delete layers[n];
+    }
+
+    uint32_t cyclesPerUs = ESP.getCpuFreqMHz();
+    Serial.printf("Layers, %d LEDs x %d layers: static %lu cycles (%.1f us), virtual %lu cycles (%.1f us) per frame, %.2fx%s\n",
+                  LAYER_BENCH_LEDS, count,
+                  (unsigned long)(staticCycles / LAYER_BENCH_FRAMES),
+                  (float)staticCycles / LAYER_BENCH_FRAMES / cyclesPerUs,
+                  (unsigned long)(virtualCycles / LAYER_BENCH_FRAMES),
+                  (float)virtualCycles / LAYER_BENCH_FRAMES / cyclesPerUs,
+                  (float)virtualCycles / max(1UL, (unsigned long)staticCycles),
+                  same ? "" : " (outputs differ!)");
+}
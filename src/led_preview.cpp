@@ -0,0 +1,249 @@
+#include "led_preview.h"
+#include "preview_codec.h"
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include <mbedtls/base64.h>
+#include <mbedtls/sha1.h>
+
+//-----------------------------------------------------------------------------
+// Snapshot
+//-----------------------------------------------------------------------------
+#define PREVIEW_INTERVAL_MS     200     // Most frames sent per second: 5
+#define PREVIEW_KEYFRAME_MS     5000    // Full frame now and then, in case a delta was lost
+
+static WiFiServer*       server     = nullptr;
+static SemaphoreHandle_t snapLock   = nullptr;
+static CRGB*             snapshot   = nullptr;  // Latest frame offered by the render loop
+static CRGB*             sent       = nullptr;  // What the viewer has
+static int               count      = 0;
+static uint16_t          pagePort   = 0;
+static volatile bool     snapFresh  = false;
+
+void previewPublish(const CRGB* leds)
+{
+    if (snapshot == nullptr || xSemaphoreTake(snapLock, 0) != pdTRUE) 
+    {
+        return;
+    }
+    memcpy(snapshot, leds, count * sizeof(CRGB));
+    snapFresh = true;
+    xSemaphoreGive(snapLock);
+}
+
+//-----------------------------------------------------------------------------
+// WebSocket
+//-----------------------------------------------------------------------------
+static bool handshake(WiFiClient& client)
+{
+    // Find the key among the request headers
+    char line[128];
+    char key[32] = "";
+    unsigned long start = millis();
+    client.setTimeout(500);
+    while (client.connected() && millis() - start < 2000) 
+    {
+        size_t length = client.readBytesUntil('\n', line, sizeof(line) - 1);
+        line[length] = '\0';
+        if (length > 0 && line[length - 1] == '\r') line[--length] = '\0';
+        if (length == 0) 
+        {
+            break;
+        }
+        if (strncasecmp(line, "Sec-WebSocket-Key:", 18) == 0) 
+        {
+            const char* value = line + 18;
+            while (*value == ' ') value++;
+            strncpy(key, value, sizeof(key) - 1);
+        }
+    }
+    if (key[0] == '\0') 
+    {
+        return false;
+    }
+
+    // Accept = base64(SHA-1(key + GUID))
+    char joined[80];
+    snprintf(joined, sizeof(joined), "%s258EAFA5-E914-47DA-95CA-C5AB0DC85B11", key);
+    unsigned char digest[20];
+    mbedtls_sha1((const unsigned char*)joined, strlen(joined), digest);
+    unsigned char accept[32];
+    size_t acceptLength = 0;
+    mbedtls_base64_encode(accept, sizeof(accept), &acceptLength, digest, sizeof(digest));
+    accept[acceptLength] = '\0';
+
+    char response[192];
+    int length = snprintf(response, sizeof(response),
+                          "HTTP/1.1 101 Switching Protocols\r\nUpgrade: websocket\r\n"
+                          "Connection: Upgrade\r\nSec-WebSocket-Accept: %s\r\n\r\n", accept);
+    return client.write((const uint8_t*)response, length) == (size_t)length;
+}
+
+// Message bytes go straight to the socket
+struct ClientSink
+{
+    WiFiClient& client;
+
+    bool write(const uint8_t* data, size_t length)
+    {
+        return client.write(data, length) == length;
+    }
+};
+
+// Send one binary WebSocket message with pixels written straight from the snapshot
+static bool sendFrame(WiFiClient& client, bool keyframe)
+{
+    size_t payload = previewMessageSize(snapshot, sent, count, keyframe);
+    if (payload == 0) 
+    {
+        return true;
+    }
+
+    // WebSocket header: binary, unmasked
+    uint8_t header[4];
+    size_t headerLength = 0;
+    header[headerLength++] = 0x82;
+    if (payload < 126) 
+    {
+        header[headerLength++] = payload;
+    }
+    else 
+    {
+        header[headerLength++] = 126;
+        header[headerLength++] = payload >> 8;
+        header[headerLength++] = payload & 0xFF;
+    }
+    if (client.write(header, headerLength) != headerLength) 
+    {
+        return false;
+    }
+
+    ClientSink sink = { client };
+    return previewEncode(sink, snapshot, sent, count, keyframe);
+}
+
+//-----------------------------------------------------------------------------
+// Sender Task
+//-----------------------------------------------------------------------------
+static void previewTask(void* param)
+{
+    WiFiClient viewer;
+    unsigned long lastKeyframe = 0;
+
+    for (;;) 
+    {
+        vTaskDelay(pdMS_TO_TICKS(PREVIEW_INTERVAL_MS));
+
+        // One viewer at a time, a new one replaces the old
+        WiFiClient incoming = server->available();
+        if (incoming) 
+        {
+            viewer.stop();
+            viewer = incoming;
+            if (!handshake(viewer)) 
+            {
+                viewer.stop();
+                continue;
+            }
+            lastKeyframe = 0;
+        }
+        if (!viewer || !viewer.connected()) 
+        {
+            continue;
+        }
+
+        // Anything the browser sends (close, pong) is discarded
+        while (viewer.available() > 0) 
+        {
+            viewer.read();
+        }
+
+        bool keyframe = lastKeyframe == 0 || millis() - lastKeyframe > PREVIEW_KEYFRAME_MS;
+        if (!snapFresh && !keyframe) 
+        {
+            continue;
+        }
+
+        xSemaphoreTake(snapLock, portMAX_DELAY);
+        snapFresh = false;
+        bool ok = sendFrame(viewer, keyframe);
+        xSemaphoreGive(snapLock);
+
+        if (!ok) 
+        {
+            viewer.stop();
+        }
+        else if (keyframe) 
+        {
+            lastKeyframe = millis();
+        }
+    }
+}
+
+void previewBegin(uint16_t port, int ledCount)
+{
+    count    = ledCount;
+    pagePort = port;
+    snapshot = new CRGB[count];
+    sent     = new CRGB[count];
+    fill_solid(snapshot, count, CRGB::Black);
+    fill_solid(sent, count, CRGB::Black);
+    snapLock = xSemaphoreCreateMutex();
+
+    static WiFiServer instance(port);
+    server = &instance;
+    server->begin();
+    xTaskCreatePinnedToCore(previewTask, "preview", 4096, nullptr, 1, nullptr, 0);
+}
+
+//-----------------------------------------------------------------------------
+// Viewer Page
+//-----------------------------------------------------------------------------
+static const char PREVIEW_PAGE[] = R"HTML(<!DOCTYPE html>
+<html><head><meta charset="utf-8"><title>Astro Clock preview</title>
+<style>body{background:#111;color:#ccc;font:14px sans-serif;text-align:center}canvas{max-width:95vmin}</style>
+</head><body><canvas id="ring" width="800" height="800"></canvas><div id="state">connecting</div>
+<script>
+const PORT = %u;
+const canvas = document.getElementById('ring'), ctx = canvas.getContext('2d');
+const state = document.getElementById('state');
+let pixels = new Uint8Array(0);
+
+function draw() {
+  const n = pixels.length / 3, c = canvas.width / 2, r = c * 0.85;
+  ctx.fillStyle = '#111'; ctx.fillRect(0, 0, canvas.width, canvas.height);
+  for (let i = 0; i < n; i++) {
+    // LED 0 (midnight) at the bottom, clockwise like the clock face
+    const a = Math.PI / 2 + 2 * Math.PI * i / n;
+    const [red, green, blue] = pixels.subarray(i * 3, i * 3 + 3);
+    ctx.fillStyle = (red | green | blue) ? `rgb(${red},${green},${blue})` : '#222';
+    ctx.beginPath(); ctx.arc(c + r * Math.cos(a), c + r * Math.sin(a), Math.max(2, 3 * r / n), 0, 2 * Math.PI); ctx.fill();
+  }
+}
+
+function apply(buffer) {
+  const v = new DataView(buffer), count = v.getUint16(1, true);
+  if (v.getUint8(0) === 0 || pixels.length !== count * 3) pixels = new Uint8Array(count * 3);
+  for (let p = 3; p + 4 <= buffer.byteLength;) {
+    const start = v.getUint16(p, true), length = v.getUint16(p + 2, true);
+    pixels.set(new Uint8Array(buffer, p + 4, length * 3), start * 3);
+    p += 4 + length * 3;
+  }
+  draw();
+}
+
+function connect() {
+  const ws = new WebSocket(`ws://${location.hostname}:${PORT}/`);
+  ws.binaryType = 'arraybuffer';
+  ws.onopen = () => state.textContent = 'live';
+  ws.onmessage = e => apply(e.data);
+  ws.onclose = () => { state.textContent = 'reconnecting'; setTimeout(connect, 2000); };
+}
+connect();
+</script></body></html>
+)HTML";
+
+void handlePreviewPage(ResponseWriter& out, const char* query)
+{
+    out.printf(PREVIEW_PAGE, pagePort);
+}
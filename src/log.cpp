@@ -0,0 +1,203 @@
+#include "log.h"
+
+#include <Arduino.h>
+#include <atomic>
+
+//-----------------------------------------------------------------------------
+// Record Queue
+//-----------------------------------------------------------------------------
+#define LOG_QUEUE_DEPTH     32
+#define LOG_LINE_LENGTH     160
+
+struct LogRecord
+{
+    uint32_t    timeMs;
+    const char* format;
+    uint8_t     level;
+    uint8_t     category;
+    uint8_t     count;
+    LogArg      args[LOG_MAX_ARGS];
+};
+
+static QueueHandle_t         logQueue   = nullptr;
+static SemaphoreHandle_t     serialLock = nullptr;
+static std::atomic<uint32_t> dropCount(0);     // Incremented from every logging task
+
+void logSubmit(uint8_t level, uint8_t category, const char* format, const LogArg* args, uint8_t count)
+{
+    LogRecord record;
+    record.timeMs   = millis();
+    record.format   = format;
+    record.level    = level;
+    record.category = category;
+    record.count    = count;
+    for (uint8_t i = 0; i < count; i++)
+    {
+        record.args[i] = args[i];
+    }
+
+    if (logQueue == nullptr || xQueueSend(logQueue, &record, 0) != pdTRUE)
+    {
+        dropCount++;
+    }
+}
+
+uint32_t logDropped()
+{
+    return dropCount.load();
+}
+
+//-----------------------------------------------------------------------------
+// Formatting
+//-----------------------------------------------------------------------------
+static const char* categoryName(uint8_t category)
+{
+    switch (category)
+    {
+    case LOG_NET:    return "net";
+    case LOG_ASTRO:  return "astro";
+    case LOG_RENDER: return "render";
+    case LOG_TIME:   return "time";
+    case LOG_SYSTEM: return "system";
+    default:         return "-";
+    }
+}
+
+// Format one conversion such as "%02d" with its captured argument
+static int formatArg(char* out, size_t size, const char* spec, const LogArg& arg)
+{
+    switch (arg.type)
+    {
+    case LOG_ARG_INT:     return snprintf(out, size, spec, arg.i);
+    case LOG_ARG_UINT:    return snprintf(out, size, spec, arg.u);
+    case LOG_ARG_INT64:   return snprintf(out, size, spec, arg.i64);
+    case LOG_ARG_UINT64:  return snprintf(out, size, spec, arg.u64);
+    case LOG_ARG_DOUBLE:  return snprintf(out, size, spec, arg.d);
+    case LOG_ARG_STRING:  return snprintf(out, size, spec, arg.s ? arg.s : "(null)");
+    case LOG_ARG_POINTER: return snprintf(out, size, spec, arg.p);
+    }
+    return 0;
+}
+
+size_t logFormat(char* out, size_t size, const char* format, const LogArg* args, uint8_t count)
+{
+    size_t length = 0;
+    uint8_t next = 0;
+    const char* p = format;
+
+    while (*p && length < size - 1)
+    {
+        if (*p != '%')
+        {
+            out[length++] = *p++;
+            continue;
+        }
+        if (p[1] == '%')
+        {
+            out[length++] = '%';
+            p += 2;
+            continue;
+        }
+
+        // Copy the conversion spec up to and including its type letter
+        char spec[16];
+        size_t n = 0;
+        do
+        {
+            spec[n++] = *p++;
+        } while (*p && n < sizeof(spec) - 2 && !strchr("diouxXeEfFgGcspaA", *p));
+        if (*p) spec[n++] = *p++;
+        spec[n] = '\0';
+
+        if (next < count)
+        {
+            int written = formatArg(&out[length], size - length, spec, args[next++]);
+            if (written > 0) length = min(length + written, size - 1);
+        }
+    }
+    out[length] = '\0';
+    return length;
+}
+
+static size_t formatRecord(char* out, size_t size, const LogRecord& record)
+{
+    static const char LEVELS[] = "-EWID";
+    size_t length = snprintf(out, size, "[%8lu] %c %s: ", (unsigned long)record.timeMs,
+                             LEVELS[record.level], categoryName(record.category));
+    length = min(length, size - 1);
+    return length + logFormat(&out[length], size - length, record.format, record.args, record.count);
+}
+
+//-----------------------------------------------------------------------------
+// Writer Task
+//-----------------------------------------------------------------------------
+static void logTask(void* param)
+{
+    LogRecord record;
+    char line[LOG_LINE_LENGTH];
+    for (;;)
+    {
+        if (xQueueReceive(logQueue, &record, portMAX_DELAY) == pdTRUE)
+        {
+            size_t length = formatRecord(line, sizeof(line) - 1, record);
+            line[length++] = '\n';
+            logLockSerial();
+            Serial.write((const uint8_t*)line, length);
+            logUnlockSerial();
+        }
+    }
+}
+
+void logBegin()
+{
+    serialLock = xSemaphoreCreateMutex();
+    logQueue   = xQueueCreate(LOG_QUEUE_DEPTH, sizeof(LogRecord));
+    xTaskCreatePinnedToCore(logTask, "log", 3072, nullptr, 1, nullptr, 0);
+}
+
+void logLockSerial()
+{
+    if (serialLock != nullptr) 
+    {
+        xSemaphoreTake(serialLock, portMAX_DELAY);
+    }
+}
+
+void logUnlockSerial()
+{
+    if (serialLock != nullptr) 
+    {
+        xSemaphoreGive(serialLock);
+    }
+}
+
+//-----------------------------------------------------------------------------
+// Benchmark
+//-----------------------------------------------------------------------------
+// Cycles per statement: a statement for a category that is compiled out,
+// and a queued one (kept below the queue depth so nothing is dropped)
+#define LOG_BENCH_DISABLED  1000
+#define LOG_BENCH_ENABLED   16
+
+void logBenchmark(const char* args)
+{
+    volatile int value = 42;
+
+    uint32_t start = ESP.getCycleCount();
+    for (int i = 0; i < LOG_BENCH_DISABLED; i++)
+    {
+        LOG_AT(LOG_LEVEL_ERROR, 0, "disabled %d %d", i, value);
+    }
+    uint32_t disabledCycles = ESP.getCycleCount() - start;
+
+    start = ESP.getCycleCount();
+    for (int i = 0; i < LOG_BENCH_ENABLED; i++)
+    {
+        logDeferred(LOG_LEVEL_INFO, LOG_RENDER, "benchmark %d of %d", i, (int)value);
+    }
+    uint32_t enabledCycles = ESP.getCycleCount() - start;
+
+    Serial.printf("Log cost: disabled %lu cycles, enabled %lu cycles per statement (%lu dropped so far)\n",
+                 (unsigned long)(disabledCycles / LOG_BENCH_DISABLED),
+                 (unsigned long)(enabledCycles / LOG_BENCH_ENABLED), (unsigned long)logDropped());
+}
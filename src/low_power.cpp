@@ -0,0 +1,60 @@
+#include "low_power.h"
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include <esp_sleep.h>
+#include <driver/uart.h>
+
+static SleepStats    stats = {0, 0, 0, 0};
+static unsigned long awakeSinceMs = 0;
+
+void lowPowerBegin()
+{
+    WiFi.setSleep(WIFI_PS_MAX_MODEM);
+    WiFi.setAutoReconnect(true);
+
+    // Without this, bytes arriving while asleep are lost rather than delayed
+    uart_set_wakeup_threshold((uart_port_t)LOW_POWER_CONSOLE_UART, LOW_POWER_UART_WAKE_EDGES);
+    esp_sleep_enable_uart_wakeup(LOW_POWER_CONSOLE_UART);
+    awakeSinceMs = millis();
+}
+
+bool lowPowerSleep(uint32_t ms)
+{
+    // Finish pending UART output before the clocks stop
+    Serial.flush();
+
+    unsigned long start = millis();
+    stats.awakeMs += start - awakeSinceMs;
+
+    esp_sleep_enable_timer_wakeup((uint64_t)ms * 1000ULL);
+    esp_light_sleep_start();
+
+    // millis() keeps counting through light sleep
+    awakeSinceMs = millis();
+    stats.sleepMs += awakeSinceMs - start;
+    stats.wakeCount++;
+
+    bool console = esp_sleep_get_wakeup_cause() == ESP_SLEEP_WAKEUP_UART;
+    if (console) 
+    {
+        stats.consoleWakes++;
+    }
+    return console;
+}
+
+const SleepStats& lowPowerStats()
+{
+    return stats;
+}
+
+uint32_t lowPowerAverageMa()
+{
+    uint64_t awake = stats.awakeMs + (millis() - awakeSinceMs);
+    uint64_t total = awake + stats.sleepMs;
+    if (total == 0) 
+    {
+        return MCU_ACTIVE_MA;
+    }
+    return (uint32_t)((awake * MCU_ACTIVE_MA + stats.sleepMs * MCU_SLEEP_MA) / total);
+}
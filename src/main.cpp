@@ -1,219 +1,1875 @@
 #include <Arduino.h>
 #include <FastLED.h>
 #include <WiFi.h>
+#include <WiFiClientSecure.h>
+#include <atomic>
 #include <time.h>
-#include <HTTPClient.h>
+#include <sys/time.h>
 #include <ArduinoJson.h> folder name is AstroWS2812
+#include "boot_timeline.h"
+#include "compositor.h"
+#include "config_store.h"
+#include "event_timeline.h"
+#include "geometry.h"
+#include "console.h"
+#include "health.h"
+#include "animation.h"
+#include "http_fetch.h"
+#include "layers.h"
+#include "led_preview.h"
+#include "log.h"
+#include "low_power.h"
+#include "memory_monitor.h"
+#include "oklab.h"
+#include "power_limiter.h"
+#include "profiler.h"
+#include "sun_calc.h"
+#include "sun_fetch.h"
+#include "telemetry.h"
+#include "time_parse.h"
+#include "time_sync.h"
+#include "web_server.h"
 
 //-----------------------------------------------------------------------------
 // Configuration Constants
 //-----------------------------------------------------------------------------
+// Site settings (network, location, brightness, LED count, solstice markers)
+// are only defaults here. The copy in NVS, edited with the "config" serial
+// command or /config, takes precedence.
+
 // LED configuration
 #define LED_PIN         48      // Data pin for LED strip
-#define NUM_LEDS        332     // Number of LEDs in the strip
+#define NUM_LEDS        332     // Number of clock LEDs (also the most the config can set)
 #define LED_TYPE        WS2812B // LED strip type
 #define COLOR_ORDER     GRB     // LED colour order
 #define BRIGHTNESS      50      // LED brightness (0-255)
 
+// Where the clock LEDs sit on the strip, as runs of
+// { first logical LED, count, first strip LED, rotation, step } (see geometry.h).
+// Default: one strip, LED 0 at midnight, running clockwise.
+constexpr LedRun LED_GEOMETRY[] = 
+{
+    { 0, NUM_LEDS, 0, 0, 1 }
+};
+
+// Power configuration
+#define POWER_BUDGET_MA     2000    // Supply current available for all LEDs (mA at 5V)
+#define POWER_RAMP_STEP     4       // Brightness recovered per frame after limiting
+
+// Day-of-year strip configuration (second strip, one LED per day)
+#define YEAR_LED_PIN    47      // Data pin for day-of-year strip
+#define YEAR_NUM_LEDS   0       // Number of LEDs in the strip (0 = disabled, 365 = one per day)
+
+// Refresh intervals, each strip is throttled independently
+#define CLOCK_REFRESH_MS    1000        // 24-hour clock ring
+#define YEAR_REFRESH_MS     60000       // Day-of-year strip (changes once a day)
+#define SWEEP_CLOCK_REFRESH_MS  16      // Clock ring while sweeping through dates (~60 fps)
+#define SWEEP_YEAR_REFRESH_MS   100     // Day-of-year strip while sweeping
+#define CONSOLE_POLL_MS     100         // Longest wait between serial command polls
+#define SUN_RETRY_MS        60000       // Wait before retrying a failed sun data fetch
+#define ANIM_TRIGGER_WINDOW_S   60      // Sunrise, sunset and hour animations start only this soon after the event
+
+// Sun data prefetch: several days are fetched over one connection, so an
+// outage of a few days goes unnoticed and most days need no handshake
+#define SUN_PREFETCH_DAYS   7           // Days of sun data kept, from today on
+#define SUN_PREFETCH_MIN    3           // Refill when fewer days than this are left
+#define CLOCK_VALID_AFTER   1700000000  // Earliest plausible time, before that NTP has not synced
+#define SUN_FETCH_DEADLINE_MS   20000   // Hard limit for one background prefetch
+
+// Stall limits for the health supervisor (see health.h)
+#define RENDER_STALL_MS     5000        // Loop not running
+#define NETWORK_STALL_MS    60000       // WiFi not connected
+#define FETCH_STALL_MS      (SUN_FETCH_DEADLINE_MS + 10000)    // Fetch past its own deadline
+
+// Debug output
+#define TELEMETRY_BINARY    1       // 1 = binary frames for tools/telemetry_decode.py, 0 = text lines
+
+// Power-managed mode: light sleep until the display next has to change
+#define LOW_POWER_MODE          0       // 1 = sleep between LED changes
+#define LOW_POWER_MAX_SLEEP_MS  60000   // Longest sleep
+#define LOW_POWER_WAKE_GUARD_MS 50      // Wake just after a boundary rather than before it
+
 // Network configuration
 const char* ssid      = "Your_SSID";
 const char* password  = "Your_PASSWORD";
-const char* ntpServer = "pool.ntp.org";
+#ifndef NTP_SERVER
+#define NTP_SERVER      "pool.ntp.org"      // A PC running tools/mock_ntp.py for drift tests
+#endif
+const char* ntpServer = NTP_SERVER;
+#ifndef SUN_API_URL
+#define SUN_API_URL     "https://api.sunrise-sunset.org/json"   // http:// for tools/mock_sun_api.py
+#endif
+#define HTTP_PORT       80      // Status, metrics, config and preview pages
+#define PREVIEW_PORT    81      // Live LED preview WebSocket
 
 // Location configuration
-const double LATITUDE  = 51.4785810;    // Your latitude
-const double LONGITUDE = -0.0012920;    // Your Longitude
+// Each location is drawn as its own 24-hour dial on an equal segment of the
+// strip. The first location is the primary one: it uses live API data and
+// carries the solstice markers, and its coordinates can be changed at run
+// time through the config.
+struct Location
+{
+    const char* name;
+    double      latitude;
+    double      longitude;
+};
+
+const Location LOCATIONS[] = 
+{
+    { "Greenwich", 51.4785810, -0.0012920 },   // Your latitude and longitude
+};
+const int NUM_LOCATIONS = sizeof(LOCATIONS) / sizeof(LOCATIONS[0]);
 
-// Time calculations
-static const int SECONDS_PER_LED = (24*60*60) / NUM_LEDS;   // Seconds per LED
+// Runtime configuration, loaded once at boot
+Config config;
 
-// LED array
-CRGB leds[NUM_LEDS];
+// Time calculations, from the LED count in use since boot
+int activeLeds    = NUM_LEDS;
+int segmentLeds   = NUM_LEDS / NUM_LOCATIONS;      // LEDs per location dial
+int secondsPerLed = (24*60*60) / segmentLeds;      // Seconds per LED
+
+// LED arrays: the clock is drawn in logical order and remapped onto the
+// strip buffer (one spare slot past the end for unmapped LEDs)
+typedef GeometryTable<LED_GEOMETRY, sizeof(LED_GEOMETRY) / sizeof(LED_GEOMETRY[0]), NUM_LEDS> ClockGeometry;
+CRGB clockLeds[NUM_LEDS];
+CRGB leds[ClockGeometry::physicalCount + 1];
+int  physicalLeds = ClockGeometry::physicalCount;  // Strip LEDs reached by the active clock LEDs
+LedGeometry geometry;
+#if YEAR_NUM_LEDS > 0
+CRGB yearLeds[YEAR_NUM_LEDS];
+#endif
+
+// Strip controllers, shown individually so each keeps its own refresh rate
+CLEDController* clockStrip = nullptr;
+CLEDController* yearStrip  = nullptr;
+
+// Drawing goes through the compositors, which track each frame's current draw
+Compositor clockFrame(clockLeds, NUM_LEDS);
+#if YEAR_NUM_LEDS > 0
+Compositor yearFrame(yearLeds, YEAR_NUM_LEDS);
+#endif
+PowerLimiter powerLimiter(POWER_BUDGET_MA, BRIGHTNESS, POWER_RAMP_STEP);
 
 //-----------------------------------------------------------------------------
 // Solstice Time Definitions
 //-----------------------------------------------------------------------------
-// Time conversion utility function
+// Time conversion utility function: minutes after midnight, -1 if malformed
 int convertTimeToMinutes(const char* timeStr) 
 {
-    int hours, minutes;
-    sscanf(timeStr, "%d:%d", &hours, &minutes);
-    return (hours * 60) + minutes;
+    int minutes;
+    return parseClockTime(timeStr, minutes) ? minutes : -1;
 }
 
-// Define solstice times Found using https://www.timeanddate.com
+// LED for a time of day in minutes, -1 (never drawn) for no time
+int minutesToLED(int minutes)
+{
+    return minutes < 0 ? -1 : (minutes * 60) / secondsPerLed;
+}
 
-const int winterSolsticeSunrise = convertTimeToMinutes("08:47");    // Winter solstice sunrise
-const int winterSolsticeSunset  = convertTimeToMinutes("16:02");    // Winter solstice sunset
-const int summerSolsticeSunrise = convertTimeToMinutes("03:47");    // Summer solstice sunrise
-const int summerSolsticeSunset  = convertTimeToMinutes("20:34");    // Summer solstice sunset
+// Default solstice times Found using https://www.timeanddate.com
+#define WINTER_SOLSTICE_SUNRISE "08:47"     // Winter solstice sunrise
+#define WINTER_SOLSTICE_SUNSET  "16:02"     // Winter solstice sunset
+#define SUMMER_SOLSTICE_SUNRISE "03:47"     // Summer solstice sunrise
+#define SUMMER_SOLSTICE_SUNSET  "20:34"     // Summer solstice sunset
 
-// Calculate LED positions for solstices
-const int winterSolsticeSunriseLED = (winterSolsticeSunrise * 60) / SECONDS_PER_LED;    // Winter solstice sunrise LED
-const int winterSolsticeSunsetLED  = (winterSolsticeSunset  * 60) / SECONDS_PER_LED;    // Winter solstice sunset LED
-const int summerSolsticeSunriseLED = (summerSolsticeSunrise * 60) / SECONDS_PER_LED;    // Summer solstice sunrise LED
-const int summerSolsticeSunsetLED  = (summerSolsticeSunset  * 60) / SECONDS_PER_LED;    // Summer solstice sunset LED
+// Solstice times in minutes and their LED positions, derived from the config
+int winterSolsticeSunrise, winterSolsticeSunset;
+int summerSolsticeSunrise, summerSolsticeSunset;
+int winterSolsticeSunriseLED, winterSolsticeSunsetLED;
+int summerSolsticeSunriseLED, summerSolsticeSunsetLED;
 
 //-----------------------------------------------------------------------------
 // Data Structures
 //-----------------------------------------------------------------------------
-struct SunData 
+// Per-day totals over the last seven days
+struct WeekCounter
+{
+    long     days[7];
+    uint32_t counts[7];
+
+    void add(long day, uint32_t amount)
+    {
+        int slot = day % 7;
+        if (days[slot] != day) 
+        {
+            days[slot]   = day;
+            counts[slot] = 0;
+        }
+        counts[slot] += amount;
+    }
+
+    uint32_t total(long today) const
+    {
+        uint32_t sum = 0;
+        for (int i = 0; i < 7; i++) 
+        {
+            if (today - days[i] < 7) sum += counts[i];
+        }
+        return sum;
+    }
+};
+
+// Outcome of sun data fetches, for the status page and metrics
+struct FetchStats 
+{
+    int           lastCode;         // HTTP status, or negative HTTP_FETCH_ERROR
+    bool          lastOk;
+    unsigned long lastAttemptMs;
+    uint32_t      lastLatencyMs;
+    uint32_t      successes;
+    uint32_t      failures;
+    uint32_t      handshakes;       // New TLS connections
+    uint32_t      bytes;            // Response bodies received
+    WeekCounter   weekHandshakes;
+    WeekCounter   weekBytes;
+};
+
+// The fetch task counts into fetchTally and publishes a copy after each
+// request, the way it publishes the sun cache; readers take the published one
+FetchStats                     fetchTally          = {0};
+FetchStats                     fetchStatsCopies[2] = {{0}};
+std::atomic<const FetchStats*> fetchStats(&fetchStatsCopies[0]);
+
+void publishFetchStats()
+{
+    FetchStats* staged = (fetchStats.load() == &fetchStatsCopies[0]) ? &fetchStatsCopies[1] : &fetchStatsCopies[0];
+    *staged = fetchTally;
+    fetchStats.store(staged);
+}
+
+// Sun data by UTC day number (days since 1970), one slot per day of the window
+struct SunCache
+{
+    long    days[SUN_PREFETCH_DAYS];
+    SunData entries[SUN_PREFETCH_DAYS];
+
+    const SunData* find(long day) const
+    {
+        int slot = day % SUN_PREFETCH_DAYS;
+        return (days[slot] == day && entries[slot].lastUpdate != 0) ? &entries[slot] : nullptr;
+    }
+
+    void store(long day, const SunData& data)
+    {
+        int slot = day % SUN_PREFETCH_DAYS;
+        days[slot]    = day;
+        entries[slot] = data;
+    }
+
+    // Consecutive days cached from the given day on
+    int daysAhead(long day) const
+    {
+        int ahead = 0;
+        while (ahead < SUN_PREFETCH_DAYS && find(day + ahead) != nullptr) 
+        {
+            ahead++;
+        }
+        return ahead;
+    }
+};
+
+// The render loop reads whichever cache is published; the fetch task fills
+// the other one and publishes it by swapping the pointer
+SunCache                sunCaches[2]  = {{{0}}};
+SunCache                sunCacheEmpty = {{0}};     // Published after a location change
+std::atomic<SunCache*>  sunCache(&sunCaches[0]);
+portMUX_TYPE            publishLock = portMUX_INITIALIZER_UNLOCKED;    // Also guards the request path
+
+// Independent refresh throttle for one LED strip
+struct StripRefresh
+{
+    unsigned long intervalMs;
+    unsigned long lastShow;
+    bool          shown;
+
+    bool due(unsigned long now) const
+    {
+        return !shown || now - lastShow >= intervalMs;
+    }
+
+    unsigned long remaining(unsigned long now) const
+    {
+        return due(now) ? 0 : intervalMs - (now - lastShow);
+    }
+
+    void markShown(unsigned long now)
+    {
+        lastShow = now;
+        shown    = true;
+    }
+};
+
+// Sun events for every location, batch-computed once a day (structure of arrays)
+float   locationLatitude[NUM_LOCATIONS];
+float   locationLongitude[NUM_LOCATIONS];
+int16_t locationSunrise[NUM_LOCATIONS];
+int16_t locationSunset[NUM_LOCATIONS];
+int16_t locationSolarNoon[NUM_LOCATIONS];
+int16_t locationDayMinutes[NUM_LOCATIONS];
+int16_t locationTwilight[NUM_LOCATIONS];
+
+const SunBatch locationBatch = 
 {
-    int sunriseMinutes;
-    int sunsetMinutes;
-    int solarNoonMinutes;
-    int daySeconds;
-    unsigned long lastUpdate;
+    NUM_LOCATIONS, locationLatitude, locationLongitude,
+    locationSunrise, locationSunset, locationSolarNoon, locationDayMinutes, locationTwilight
 };
+int locationBatchDay = -1;     // Day of year the batch was computed for
+
+// Sun data on the primary dial, and whether it came from the API
+SunData shownSun  = {0};
+bool    shownLive = false;
+EventTimeline timeline;                 // Events of the shown day
+bool    sunLocationChanged = false;     // Primary location edited, refetch
+
+// Longest gap between clock frames, proof that nothing stalls the loop
+unsigned long lastFrameMs        = 0;  // 0 after a sleep, the gap is intended
+uint32_t      frameIntervalMaxMs = 0;
+
+// Annual daylight envelope for the day-of-year strip, rebuilt once a year
+YearTable yearTable = {0};
 
 //-----------------------------------------------------------------------------
 // API Functions
 //-----------------------------------------------------------------------------
-SunData getSunData() 
+// The request path needs the location with six decimals, which only changes
+// with the config. It is formatted once then, and each fetch just writes its
+// date over the placeholder at the end. sunFetchDay() reads and parses
+// the response without the heap.
+#define SUN_PATH_LENGTH     128
+#define SUN_DATE_PLACEHOLDER "YYYY-MM-DD"
+
+HttpTarget sunApi;
+char       sunRequestPath[SUN_PATH_LENGTH];
+size_t     sunRequestDate = 0;      // Offset of the date in sunRequestPath
+
+// One prefetch, handed to the fetch task. Carries its own copy of the path
+// and date offset so a config change cannot rewrite them mid-fetch.
+struct SunFetchRequest
+{
+    uint32_t id;                // Generation it was issued in
+    long     today;             // UTC day number
+    size_t   date;              // Offset of the date in path
+    char     path[SUN_PATH_LENGTH];
+};
+
+void buildSunRequestPath()
+{
+    if (sunApi.host[0] == '\0' && !httpParseUrl(SUN_API_URL, sunApi)) 
+    {
+        LOG_ERROR(LOG_NET, "SUN_API_URL is not a valid http(s) URL");
+    }
+    char path[SUN_PATH_LENGTH];
+    int length = snprintf(path, sizeof(path), "%s?lat=%.6f&lng=%.6f&formatted=0&date=", 
+                          sunApi.path, config.latitude, config.longitude);
+    size_t date = min((size_t)max(length, 0), sizeof(path) - sizeof(SUN_DATE_PLACEHOLDER));
+    strcpy(path + date, SUN_DATE_PLACEHOLDER);
+
+    // Formatted outside the lock, swapped in under it with the offset
+    portENTER_CRITICAL(&publishLock);
+    memcpy(sunRequestPath, path, sizeof(sunRequestPath));
+    sunRequestDate = date;
+    portEXIT_CRITICAL(&publishLock);
+}
+
+// Fetch one UTC day over the session's connection, opening it if needed
+SunData getSunData(WiFiClient& client, SunFetchRequest& request, long day, uint32_t timeoutMs) 
 {
-    HTTPClient http;
     SunData data = {0};
-    String url = "https://api.sunrise-sunset.org/json?lat=" + 
-                 String(LATITUDE, 6) + "&lng=" + 
-                 String(LONGITUDE, 6) + "&formatted=0";
-    http.begin(url);
-    
-    if (http.GET() > 0) 
+    time_t midnight = (time_t)day * 24*60*60;
+    struct tm date;
+    gmtime_r(&midnight, &date);
+    char dateText[sizeof(SUN_DATE_PLACEHOLDER)];
+    snprintf(dateText, sizeof(dateText), "%04d-%02d-%02d", 
+             (date.tm_year + 1900) % 10000, (date.tm_mon + 1) % 100, date.tm_mday % 100);
+    memcpy(request.path + request.date, dateText, sizeof(dateText) - 1);
+
+    // The weekly counters cover traffic by when it happened, not the day fetched
+    long today = time(nullptr) / (24*60*60);
+    if (!client.connected()) 
+    {
+        fetchTally.handshakes++;
+        fetchTally.weekHandshakes.add(today, 1);
+    }
+    size_t length;
+    int code = sunFetchDay(client, sunApi, request.path, day, data, length, timeoutMs);
+    if (code == 200) 
+    {
+        fetchTally.bytes += length;
+        fetchTally.weekBytes.add(today, length);
+    }
+
+    fetchTally.lastCode = code;
+    fetchTally.lastOk   = data.lastUpdate != 0;
+    if (fetchTally.lastOk) 
+    {
+        fetchTally.successes++;
+    }
+    else 
+    {
+        fetchTally.failures++;
+    }
+    publishFetchStats();
+    return data;
+}
+
+//-----------------------------------------------------------------------------
+// Background Fetch
+//-----------------------------------------------------------------------------
+// Fetches run in their own task so the render loop never waits on the
+// network. A fetch gives up at its deadline (each request's timeouts are
+// cut to the time left) and stops between requests once cancelled. It only
+// publishes its result if no newer request or cancel came in meanwhile.
+std::atomic<uint32_t> fetchGeneration(0);      // Bumped by every request and cancel
+std::atomic<bool>     fetchBusy(false);
+QueueHandle_t         fetchQueue = nullptr;
+
+// Fill the missing days of the window in one keep-alive session. Returns
+// the number of days fetched; stops at the first failure.
+int prefetchSunData(SunCache& cache, SunFetchRequest& request)
+{
+    // Static, so the clients' own state is allocated once, not per session
+    static WiFiClientSecure secureClient;
+    static WiFiClient       plainClient;
+    WiFiClient& client = sunApi.secure ? secureClient : plainClient;
+    secureClient.setInsecure();     // As HTTPClient does for a bare https URL
+
+    unsigned long start = millis();
+    uint32_t handshakes = fetchTally.handshakes;
+    int fetched = 0;
+    const char* stopped = nullptr;
+    for (long day = request.today; day < request.today + SUN_PREFETCH_DAYS; day++) 
     {
-        JsonDocument doc;
-        if (!deserializeJson(doc, http.getString())) 
+        if (cache.find(day) != nullptr) 
+        {
+            continue;
+        }
+        long remaining = SUN_FETCH_DEADLINE_MS - (long)(millis() - start);
+        if (request.id != fetchGeneration.load()) 
         {
-            struct tm sunrise = {0}, sunset = {0}, solarNoon = {0};
-            strptime(doc["results"]["sunrise"], "%Y-%m-%dT%H:%M:%S+00:00", &sunrise);
-            strptime(doc["results"]["sunset"], "%Y-%m-%dT%H:%M:%S+00:00", &sunset);
-            strptime(doc["results"]["solar_noon"], "%Y-%m-%dT%H:%M:%S+00:00", &solarNoon);
-            
-            data.sunriseMinutes = sunrise.tm_hour * 60 + sunrise.tm_min;
-            data.sunsetMinutes = sunset.tm_hour * 60 + sunset.tm_min;
-            data.solarNoonMinutes = solarNoon.tm_hour * 60 + solarNoon.tm_min;
-            data.daySeconds = doc["results"]["day_length"];
-            data.lastUpdate = millis();
+            stopped = "cancelled";
+            break;
         }
+        if (remaining <= 0) 
+        {
+            stopped = "deadline";
+            break;
+        }
+        client.setTimeout(max(1L, remaining / 1000));   // Seconds in this core
+        secureClient.setHandshakeTimeout(max(1L, remaining / 1000));
+
+        healthBeat(HEALTH_FETCH);
+        SunData data = getSunData(client, request, day, remaining);
+        if (data.lastUpdate == 0) 
+        {
+            stopped = "error";
+            break;
+        }
+        cache.store(day, data);
+        bootMark(BOOT_FIRST_FETCH);
+        fetched++;
     }
-    http.end();
-    return data;
+    client.stop();
+
+    fetchTally.lastAttemptMs = start;
+    fetchTally.lastLatencyMs = millis() - start;
+    publishFetchStats();
+    LOG_INFO(LOG_NET, "Sun data: %d days fetched in %lu ms, %lu handshakes%s%s", fetched, 
+             (unsigned long)fetchTally.lastLatencyMs, (unsigned long)(fetchTally.handshakes - handshakes), 
+             stopped ? ", stopped: " : "", stopped ? stopped : "");
+    return fetched;
+}
+
+// Completion: publish the filled cache unless the fetch is out of date
+void onSunFetchComplete(SunCache* staged, uint32_t id)
+{
+    portENTER_CRITICAL(&publishLock);
+    if (id == fetchGeneration.load()) 
+    {
+        sunCache.store(staged);
+    }
+    portEXIT_CRITICAL(&publishLock);
+}
+
+void sunFetchTask(void* param)
+{
+    SunFetchRequest request;
+    for (;;) 
+    {
+        if (xQueueReceive(fetchQueue, &request, portMAX_DELAY) != pdTRUE) 
+        {
+            continue;
+        }
+
+        // Start from what is already published, fill in the other buffer
+        SunCache* published = sunCache.load();
+        SunCache* staged    = (published == &sunCaches[0]) ? &sunCaches[1] : &sunCaches[0];
+        *staged = *published;
+        healthWatch(HEALTH_FETCH, FETCH_STALL_MS);
+        prefetchSunData(*staged, request);
+        healthWatch(HEALTH_FETCH, 0);
+        onSunFetchComplete(staged, request.id);
+        fetchBusy = false;
+    }
+}
+
+void sunFetchBegin()
+{
+    fetchQueue = xQueueCreate(1, sizeof(SunFetchRequest));
+    xTaskCreatePinnedToCore(sunFetchTask, "sunfetch", 8192, nullptr, 1, nullptr, 0);
+}
+
+// Start a prefetch from today, unless one is already running
+bool sunFetchRequest(long today)
+{
+    if (fetchQueue == nullptr || fetchBusy.exchange(true)) 
+    {
+        return false;
+    }
+    SunFetchRequest request;
+    request.id    = ++fetchGeneration;
+    request.today = today;
+    portENTER_CRITICAL(&publishLock);
+    memcpy(request.path, sunRequestPath, sizeof(request.path));
+    request.date  = sunRequestDate;
+    portEXIT_CRITICAL(&publishLock);
+    xQueueOverwrite(fetchQueue, &request);
+    return true;
+}
+
+void sunFetchCancel()
+{
+    portENTER_CRITICAL(&publishLock);
+    fetchGeneration++;
+    portEXIT_CRITICAL(&publishLock);
+}
+
+// Drop all fetched data (location changed), including any fetch in flight
+void sunFetchReset()
+{
+    portENTER_CRITICAL(&publishLock);
+    fetchGeneration++;
+    sunCache.store(&sunCacheEmpty);
+    portEXIT_CRITICAL(&publishLock);
+}
+
+// Serial command: fetch status, or start / cancel a prefetch
+void cmdFetch(const char* args)
+{
+    long today = time(nullptr) / (24*60*60);
+    if (strcmp(args, "now") == 0) 
+    {
+        Serial.println(sunFetchRequest(today) ? "Fetch started" : "Fetch already running");
+        return;
+    }
+    if (strcmp(args, "cancel") == 0) 
+    {
+        sunFetchCancel();
+        return;
+    }
+    const FetchStats& stats = *fetchStats.load();
+    Serial.printf("Sun data: %d days ahead, fetch %s, last %s in %lu ms (HTTP %d)\n", 
+                 sunCache.load()->daysAhead(today), fetchBusy ? "running" : "idle", 
+                 stats.lastOk ? "ok" : "failed", (unsigned long)stats.lastLatencyMs, stats.lastCode);
+    Serial.printf("Last 7 days: %lu handshakes, %lu bytes; longest frame gap %lu ms\n", 
+                 (unsigned long)stats.weekHandshakes.total(today), 
+                 (unsigned long)stats.weekBytes.total(today), (unsigned long)frameIntervalMaxMs);
+    Serial.printf("Request %s, JSON pool peak %u of %u bytes\n", sunRequestPath, 
+                 (unsigned)sunJsonPoolPeak(), (unsigned)sunJsonPoolCapacity());
 }
 
 //-----------------------------------------------------------------------------
-// Setup & Loop
+// Date Scrub / Replay
 //-----------------------------------------------------------------------------
-void setup() 
+// Shows any date from the on-device sun calculation, no network needed.
+// Serial commands:
+//   date YYYY-MM-DD [HH:MM]        show a fixed date and time (UTC)
+//   sweep DAYS_PER_SEC [YYYY-MM-DD] replay from a date at the given speed
+//   live                           return to the real clock
+enum DisplayMode
 {
-    // Initialize serial communication
-    Serial.begin(115200);
-    
-    // Initialize LED strip
-    FastLED.addLeds<LED_TYPE, LED_PIN, COLOR_ORDER>(leds, NUM_LEDS).setCorrection(TypicalLEDStrip);
-    FastLED.setBrightness(BRIGHTNESS);
-    
-    // Initialize WiFi
-    WiFi.begin(ssid, password);
-    while (WiFi.status() != WL_CONNECTED) 
+    DISPLAY_LIVE,
+    DISPLAY_FIXED,
+    DISPLAY_SWEEP
+};
+
+DisplayMode   displayMode     = DISPLAY_LIVE;
+time_t        scrubTime       = 0;      // Fixed time, or start of the sweep
+float         sweepDaysPerSec = 0;
+unsigned long sweepStartMs    = 0;
+
+// Time to display, real or scrubbed
+time_t displayTime()
+{
+    switch (displayMode) 
     {
-        delay(500);
-        Serial.print(".");
+    case DISPLAY_FIXED:
+        return scrubTime;
+    case DISPLAY_SWEEP:
+        return scrubTime + (time_t)((millis() - sweepStartMs) * (sweepDaysPerSec * 86.4f));
+    default:
+        return timeSyncNow();
     }
-    
-    // Initialize time
-    configTime(0, 0, ntpServer);
+}
 
-    // Print initial solstice times for debugging
-    Serial.println("\nSolstice times in minutes:");
-    Serial.printf("Winter Solstice - Sunrise: %d minutes (%02d:%02d), Sunset: %d minutes (%02d:%02d)\n", 
-                 winterSolsticeSunrise, winterSolsticeSunrise/60, winterSolsticeSunrise%60,
-                 winterSolsticeSunset, winterSolsticeSunset/60, winterSolsticeSunset%60);
-    Serial.printf("Summer Solstice - Sunrise: %d minutes (%02d:%02d), Sunset: %d minutes (%02d:%02d)\n", 
-                 summerSolsticeSunrise, summerSolsticeSunrise/60, summerSolsticeSunrise%60,
-                 summerSolsticeSunset, summerSolsticeSunset/60, summerSolsticeSunset%60);
+// Parse "YYYY-MM-DD [HH:MM]" as UTC
+bool parseScrubDate(const char* text, time_t& out)
+{
+    int year, month, day, hour = 0, minute = 0;
+    int fields = sscanf(text, "%d-%d-%d %d:%d", &year, &month, &day, &hour, &minute);
+    if (fields < 3 || month < 1 || month > 12 || day < 1 || day > 31 || 
+        hour < 0 || hour > 23 || minute < 0 || minute > 59) 
+    {
+        return false;
+    }
+
+    struct tm t = {0};
+    t.tm_year = year - 1900;
+    t.tm_mon  = month - 1;
+    t.tm_mday = day;
+    t.tm_hour = hour;
+    t.tm_min  = minute;
+    out = mktime(&t);
+    return out != (time_t)-1;
 }
 
-void loop() 
+void cmdDate(const char* args)
 {
-    static SunData sun;
-    
-    // Update sun data daily
-    if (millis() - sun.lastUpdate > 24*60*60*1000 || sun.lastUpdate == 0) 
+    time_t t;
+    if (*args == '\0') 
+    {
+        t = displayTime();
+        struct tm* shown = localtime(&t);
+        Serial.printf("Showing %04d-%02d-%02d %02d:%02d\n", shown->tm_year + 1900, 
+                     shown->tm_mon + 1, shown->tm_mday, shown->tm_hour, shown->tm_min);
+        return;
+    }
+    if (!parseScrubDate(args, t)) 
+    {
+        Serial.println("Usage: date YYYY-MM-DD [HH:MM]");
+        return;
+    }
+    scrubTime   = t;
+    displayMode = DISPLAY_FIXED;
+}
+
+void cmdSweep(const char* args)
+{
+    char* rest;
+    float daysPerSec = strtof(args, &rest);
+    if (rest == args || daysPerSec == 0) 
     {
-        sun = getSunData();
+        Serial.println("Usage: sweep DAYS_PER_SEC [YYYY-MM-DD]");
+        return;
     }
 
-    // Get current time
-    time_t now;
-    time(&now);
-    struct tm* local_time = localtime(&now);
-    int currentSecond = (local_time->tm_hour * 60 + local_time->tm_min) * 60 + local_time->tm_sec;
-    
+    time_t start = displayTime();
+    while (*rest == ' ') rest++;
+    if (*rest && !parseScrubDate(rest, start)) 
+    {
+        Serial.println("Usage: sweep DAYS_PER_SEC [YYYY-MM-DD]");
+        return;
+    }
+    scrubTime       = start;
+    sweepDaysPerSec = daysPerSec;
+    sweepStartMs    = millis();
+    displayMode     = DISPLAY_SWEEP;
+}
+
+void cmdLive(const char* args)
+{
+    displayMode = DISPLAY_LIVE;
+}
+
+//-----------------------------------------------------------------------------
+// Location Sun Data
+//-----------------------------------------------------------------------------
+// Recompute every location's sun events in one batched pass when the day changes
+void updateLocationBatch(int dayOfYear)
+{
+    if (dayOfYear == locationBatchDay) 
+    {
+        return;
+    }
+
+    unsigned long start = micros();
+    calcSunTimesBatch(locationBatch, dayOfYear);
+    unsigned long elapsed = max(1UL, micros() - start);
+    locationBatchDay = dayOfYear;
+
+    if (displayMode == DISPLAY_LIVE) 
+    {
+        LOG_INFO(LOG_ASTRO, "Sun batch: %d locations in %lu us (%.1f locations/ms)", 
+                 NUM_LOCATIONS, elapsed, NUM_LOCATIONS * 1000.0f / elapsed);
+    }
+}
+
+SunData locationSunData(int location)
+{
+    SunData data = {0};
+    data.sunriseMinutes   = locationSunrise[location];
+    data.sunsetMinutes    = locationSunset[location];
+    data.solarNoonMinutes = locationSolarNoon[location];
+    data.daySeconds       = locationDayMinutes[location] * 60;
+    return data;
+}
+
+//-----------------------------------------------------------------------------
+// Clock Ring
+//-----------------------------------------------------------------------------
+ClockLayers clockLayers;
+
+// Draw one 24-hour dial of segmentLeds LEDs, starting at LED first. The API
+// gives no twilight, so its length always comes from the on-device calculation.
+// nextEventSecond is where the countdown trail ends, -1 for none.
+void renderClock(Compositor& frame, int first, const SunData& sun, int twilightMinutes, int currentSecond, 
+                 int nextEventSecond, bool primary)
+{
     // Calculate LED positions
-    int ledPosition = currentSecond / SECONDS_PER_LED;
-    int sunriseLED = (sun.sunriseMinutes * 60) / SECONDS_PER_LED;
-    int sunsetLED = (sun.sunsetMinutes * 60) / SECONDS_PER_LED;
-    int solarNoonLED = (sun.solarNoonMinutes * 60) / SECONDS_PER_LED;
+    DialContext dial;
+    dial.first         = first;
+    dial.count         = segmentLeds;
+    dial.secondsPerLed = secondsPerLed;
+    dial.sunLED        = currentSecond / secondsPerLed;
+    dial.sunriseLED    = (sun.sunriseMinutes * 60) / secondsPerLed;
+    dial.sunsetLED     = (sun.sunsetMinutes * 60) / secondsPerLed;
+    dial.solarNoonLED  = (sun.solarNoonMinutes * 60) / secondsPerLed;
+    dial.twilightLEDs  = (twilightMinutes * 60) / secondsPerLed;
+    dial.showSolstices = primary;
+    dial.animate       = primary;
+    dial.nextEventLED  = nextEventSecond < 0 ? -1 : nextEventSecond / secondsPerLed;
+    dial.solsticeLEDs[0] = winterSolsticeSunriseLED;
+    dial.solsticeLEDs[1] = winterSolsticeSunsetLED;
+    dial.solsticeLEDs[2] = summerSolsticeSunriseLED;
+    dial.solsticeLEDs[3] = summerSolsticeSunsetLED;
 
-    // Clear all LEDs
-    FastLED.clear();
-    
-    // Current daylight period (blue background)
-    for (int i = sunriseLED; i <= sunsetLED; i++) 
+    PROFILE_STAGE(PROFILE_LAYERS);
+    clockLayers.render(frame, dial);
+}
+
+// An event at second-of-day event was passed between two frames (either may
+// be across midnight), and not too long ago
+bool passedEvent(int event, int previous, int current)
+{
+    int since = current - event;
+    int gap   = current - previous;
+    if (since < 0) since += 24*60*60;
+    if (gap < 0)   gap   += 24*60*60;
+    return since < gap && since < ANIM_TRIGGER_WINDOW_S;
+}
+
+// Start the sunrise and sunset transitions and the hourly chime as the shown
+// time passes them (live display only)
+void triggerAnimations(const SunData& sun, int currentSecond)
+{
+    static int lastSecond = -1;
+    int previous = lastSecond;
+    lastSecond = displayMode == DISPLAY_LIVE ? currentSecond : -1;
+    if (previous < 0 || lastSecond < 0) 
     {
-        if (i != solarNoonLED && leds[i].r == 0) 
-        {
-            leds[i] = CRGB(0, 0, 8);    // Dark blue for daylight period
-        }
+        return;
+    }
+
+    unsigned long now = millis();
+    if (passedEvent(currentSecond - currentSecond % 3600, previous, currentSecond)) 
+    {
+        animStart(ANIM_CHIME, now);
+    }
+
+    // Not on days without a sunrise or a sunset
+    if (sun.daySeconds <= 0 || sun.daySeconds >= 24*60*60) 
+    {
+        return;
+    }
+    if (passedEvent(sun.sunriseMinutes * 60, previous, currentSecond)) 
+    {
+        animStart(ANIM_DAYLIGHT, now, 1);
+        animStart(ANIM_SUN_PULSE, now);
+    }
+    if (passedEvent(sun.sunsetMinutes * 60, previous, currentSecond)) 
+    {
+        animStart(ANIM_DAYLIGHT, now, -1);
+        animStart(ANIM_SUN_PULSE, now);
+    }
+}
+
+//-----------------------------------------------------------------------------
+// Event Timeline
+//-----------------------------------------------------------------------------
+// Seconds until the local DST state next changes, or horizon if it does not
+long secondsToDstChange(time_t now, long horizon)
+{
+    int isDst  = localtime(&now)->tm_isdst;
+    time_t end = now + horizon;
+    if (localtime(&end)->tm_isdst == isDst) 
+    {
+        return horizon;
     }
 
-    // Hour markers (red)
-    for(int hour = 0; hour < 24; hour++) 
+    // Binary search for the first second in the new state
+    long before = 0, after = horizon;
+    while (after - before > 1) 
     {
-        int hourLED = (hour * 3600) / SECONDS_PER_LED;
-        if(hourLED >= 0 && hourLED < NUM_LEDS && hourLED != solarNoonLED) 
+        long middle = before + (after - before) / 2;
+        time_t t = now + middle;
+        if (localtime(&t)->tm_isdst == isDst) 
         {
-            leds[hourLED] = CRGB(32, 0, 0);  // Dark red for hours
+            before = middle;
         }
+        else 
+        {
+            after = middle;
+        }
+    }
+    return after;
+}
+
+// Minutes of the day for an event that may have been pushed past midnight
+long dayMinute(int minutes)
+{
+    return ((minutes % (24*60)) + 24*60) % (24*60);
+}
+
+// Rebuild the timeline when the shown day, its sun data or the refresh
+// outlook changes
+void updateTimeline(time_t shown, const SunData& sun, int twilightMinutes)
+{
+    static SunData builtSun      = {0};
+    static int     builtTwilight = -1;
+    static bool    builtRefresh  = false;
+
+    long day     = shown / (24*60*60);
+    bool refresh = displayMode == DISPLAY_LIVE && sunCache.load()->daysAhead(day + 1) < SUN_PREFETCH_MIN;
+    if (day == timeline.day() && refresh == builtRefresh && twilightMinutes == builtTwilight && 
+        sun.sunriseMinutes == builtSun.sunriseMinutes && sun.sunsetMinutes == builtSun.sunsetMinutes && 
+        sun.solarNoonMinutes == builtSun.solarNoonMinutes && sun.daySeconds == builtSun.daySeconds) 
+    {
+        return;
+    }
+    builtSun      = sun;
+    builtTwilight = twilightMinutes;
+    builtRefresh  = refresh;
+
+    time_t start = (time_t)day * 24*60*60;
+    timeline.clear(day);
+    for (int hour = 1; hour < 24; hour++) 
+    {
+        timeline.add(start + hour * 3600, EVENT_HOUR);
     }
+    timeline.add(start + dayMinute(sun.solarNoonMinutes) * 60, EVENT_SOLAR_NOON);
 
-    // Solstice markers (green)
-    if (winterSolsticeSunriseLED >= 0 && winterSolsticeSunriseLED < NUM_LEDS) 
+    // No sunrise or sunset in polar day or night
+    if (sun.daySeconds > 0 && sun.daySeconds < 24*60*60) 
     {
-        leds[winterSolsticeSunriseLED] = CRGB(0, 255, 0);  // Bright green
+        timeline.add(start + dayMinute(sun.sunriseMinutes - twilightMinutes) * 60, EVENT_DAWN);
+        timeline.add(start + dayMinute(sun.sunriseMinutes) * 60, EVENT_SUNRISE);
+        timeline.add(start + dayMinute(sun.sunsetMinutes) * 60, EVENT_SUNSET);
+        timeline.add(start + dayMinute(sun.sunsetMinutes + twilightMinutes) * 60, EVENT_DUSK);
     }
-    if (winterSolsticeSunsetLED >= 0 && winterSolsticeSunsetLED < NUM_LEDS) 
+
+    long dst = secondsToDstChange(start, 24*60*60);
+    if (dst < 24*60*60) 
     {
-        leds[winterSolsticeSunsetLED] = CRGB(0, 255, 0);
+        timeline.add(start + dst, EVENT_DST);
     }
-    if (summerSolsticeSunriseLED >= 0 && summerSolsticeSunriseLED < NUM_LEDS) 
+    if (refresh) 
     {
-        leds[summerSolsticeSunriseLED] = CRGB(0, 255, 0);
+        timeline.add(start + 24*60*60, EVENT_SUN_REFRESH);
     }
-    if (summerSolsticeSunsetLED >= 0 && summerSolsticeSunsetLED < NUM_LEDS) 
+    timeline.add(start + 24*60*60, EVENT_MIDNIGHT);
+    timeline.sort();
+}
+
+// Second of the day at which the countdown trail ends, -1 without one
+int countdownSecond(time_t shown, int currentSecond)
+{
+    long seconds = timeline.secondsToNext(shown, EVENT_SUN_EVENTS, nullptr);
+    return seconds < 0 ? -1 : (int)((currentSecond + seconds) % (24*60*60));
+}
+
+// Console command: the next sun event and the rest of the day (hours left out)
+void cmdEvents(const char* args)
+{
+    time_t now   = displayTime();
+    time_t start = (time_t)timeline.day() * 24*60*60;
+    char   countdown[16];
+
+    EventKind kind;
+    long seconds = timeline.secondsToNext(now, EVENT_SUN_EVENTS, &kind);
+    if (seconds >= 0) 
     {
-        leds[summerSolsticeSunsetLED] = CRGB(0, 255, 0);
+        formatCountdown(countdown, sizeof(countdown), seconds);
+        Serial.printf("Next: %s in %s\n", eventName(kind), countdown);
     }
 
-    // Current sun position (yellow)
-    if (ledPosition >= 0 && ledPosition < NUM_LEDS && 
-        ledPosition != solarNoonLED && 
-        ledPosition >= sunriseLED && 
-        ledPosition <= sunsetLED) 
+    for (int i = 0; i < timeline.count(); i++) 
     {
-        leds[ledPosition] = CRGB(255, 255, 0);  // Bright yellow
+        const TimelineEvent& event = timeline.event(i);
+        if (event.kind == EVENT_HOUR) 
+        {
+            continue;
+        }
+        long at = event.at - start;
+        if (event.at > now) 
+        {
+            formatCountdown(countdown, sizeof(countdown), event.at - now);
+        }
+        Serial.printf("  %02ld:%02ld  %-16s %s\n", at / 3600, (at / 60) % 60, eventName(event.kind), 
+                     event.at > now ? countdown : "passed");
     }
-    
-    // Debug output
-    Serial.printf("Current LED: %d (Hour: %d, Minute: %d)\n", 
-                 ledPosition, local_time->tm_hour, local_time->tm_min);
-    Serial.printf("Sunrise: %02d:%02d (LED: %d)\n", 
-                 sun.sunriseMinutes/60, sun.sunriseMinutes%60, sunriseLED);
-    Serial.printf("Solar Noon: %02d:%02d (LED: %d)\n", 
-                 sun.solarNoonMinutes/60, sun.solarNoonMinutes%60, solarNoonLED);
-    Serial.printf("Sunset: %02d:%02d (LED: %d)\n", 
-                 sun.sunsetMinutes/60, sun.sunsetMinutes%60, sunsetLED);
-    
-    // Update LED strip
-    FastLED.show();
-    delay(1000);
+}
+
+// Per-frame debug report, binary telemetry or the original text lines
+void reportClock(const SunData& sun, const struct tm* local_time, uint32_t renderMicros)
+{
+    static uint32_t sequence = 0;
+    int currentSecond = (local_time->tm_hour * 60 + local_time->tm_min) * 60 + local_time->tm_sec;
+    int ledPosition   = currentSecond / secondsPerLed;
+    int sunriseLED    = (sun.sunriseMinutes * 60) / secondsPerLed;
+    int solarNoonLED  = (sun.solarNoonMinutes * 60) / secondsPerLed;
+    int sunsetLED     = (sun.sunsetMinutes * 60) / secondsPerLed;
+
+#if TELEMETRY_BINARY
+    // Field order must match CLOCK_FIELDS in tools/telemetry_decode.py
+    struct tm shown = *local_time;
+    TelemetryFrame frame(TELEMETRY_CLOCK);
+    frame.put(sequence++);
+    frame.put(millis());
+    frame.put((uint32_t)mktime(&shown));
+    frame.put(ledPosition);
+    frame.putSigned(sun.sunriseMinutes);
+    frame.put(sunriseLED);
+    frame.putSigned(sun.solarNoonMinutes);
+    frame.put(solarNoonLED);
+    frame.putSigned(sun.sunsetMinutes);
+    frame.put(sunsetLED);
+    frame.put(sun.daySeconds);
+    frame.put(powerLimiter.brightness());
+    frame.put(powerLimiter.currentMa());
+    frame.put(powerLimiter.activations());
+    frame.put(renderMicros);
+    frame.put(telemetryDropped());
+    frame.send();
+#else
+    sequence++;
+    LOG_INFO(LOG_RENDER, "Current LED: %d (Hour: %d, Minute: %d)", 
+             ledPosition, local_time->tm_hour, local_time->tm_min);
+    LOG_INFO(LOG_RENDER, "Sunrise: %02d:%02d (LED: %d)", 
+             sun.sunriseMinutes/60, sun.sunriseMinutes%60, sunriseLED);
+    LOG_INFO(LOG_RENDER, "Solar Noon: %02d:%02d (LED: %d)", 
+             sun.solarNoonMinutes/60, sun.solarNoonMinutes%60, solarNoonLED);
+    LOG_INFO(LOG_RENDER, "Sunset: %02d:%02d (LED: %d)", 
+             sun.sunsetMinutes/60, sun.sunsetMinutes%60, sunsetLED);
+    EventKind nextKind;
+    long nextIn = timeline.secondsToNext((time_t)timeline.day() * 24*60*60 + currentSecond, EVENT_SUN_EVENTS, &nextKind);
+    if (nextIn >= 0) 
+    {
+        LOG_INFO(LOG_RENDER, "Next: %s in %ldh%02ldm", eventName(nextKind), nextIn / 3600, (nextIn / 60) % 60);
+    }
+#endif
+}
+
+//-----------------------------------------------------------------------------
+// Day-of-year Strip
+//-----------------------------------------------------------------------------
+#if YEAR_NUM_LEDS > 0
+// LED showing a given day of the year, scaled for strips with fewer LEDs than days
+int dayToYearLED(int dayOfYear)
+{
+    return (dayOfYear * YEAR_NUM_LEDS) / yearTable.days;
+}
+
+void renderYearStrip(const struct tm* local_time)
+{
+    // Build the yearly table once, the envelope only changes with the year
+    int year = local_time->tm_year + 1900;
+    if (yearTable.year != year)
+    {
+        buildYearTable(yearTable, config.latitude, config.longitude, year);
+    }
+
+    yearFrame.clear();
+
+    // Daylight envelope (blue, brighter for longer days)
+    int range = max(1, yearTable.maxDayMinutes - yearTable.minDayMinutes);
+    for (int day = 0; day < yearTable.days; day++) 
+    {
+        int level = 2 + ((yearTable.dayMinutes[day] - yearTable.minDayMinutes) * 30) / range;
+        yearFrame.set(dayToYearLED(day), CRGB(0, 0, level));
+    }
+
+    // Equinox markers (white)
+    yearFrame.set(dayToYearLED(yearTable.springEquinoxDay), CRGB(32, 32, 32));
+    yearFrame.set(dayToYearLED(yearTable.autumnEquinoxDay), CRGB(32, 32, 32));
+
+    // Solstice markers (green, as on the clock ring)
+    yearFrame.set(dayToYearLED(yearTable.summerSolsticeDay), CRGB(0, 255, 0));
+    yearFrame.set(dayToYearLED(yearTable.winterSolsticeDay), CRGB(0, 255, 0));
+
+    // Today (yellow)
+    yearFrame.set(dayToYearLED(local_time->tm_yday), CRGB(255, 255, 0));
+}
+#endif
+
+//-----------------------------------------------------------------------------
+// Power Limiting
+//-----------------------------------------------------------------------------
+// Total current of everything on the strips at a given brightness
+uint32_t estimateFrameMa(uint8_t brightness)
+{
+    uint32_t total = clockFrame.estimate(brightness).totalMa();
+#if YEAR_NUM_LEDS > 0
+    total += yearFrame.estimate(brightness).totalMa();
+#endif
+    return total;
+}
+
+// Show one strip at the limited brightness. If the limiter had to dim, the
+// other strips are shown again too, so the total never exceeds the budget.
+void showStrip(CLEDController* strip)
+{
+    uint8_t previous   = powerLimiter.brightness();
+    uint8_t brightness = powerLimiter.update(estimateFrameMa);
+    strip->showLeds(brightness);
+
+    if (brightness < previous) 
+    {
+        CLEDController* strips[] = { clockStrip, yearStrip };
+        for (CLEDController* other : strips) 
+        {
+            if (other != nullptr && other != strip) 
+            {
+                other->showLeds(brightness);
+            }
+        }
+    }
+}
+
+void cmdGeometry(const char* args)
+{
+    geometry.report(clockLeds, leds);
+}
+
+void cmdPower(const char* args)
+{
+    CurrentEstimate e = clockFrame.estimate(powerLimiter.brightness());
+#if YEAR_NUM_LEDS > 0
+    CurrentEstimate y = yearFrame.estimate(powerLimiter.brightness());
+    e.redMa += y.redMa;  e.greenMa += y.greenMa;  e.blueMa += y.blueMa;  e.idleMa += y.idleMa;
+#endif
+    Serial.printf("Power: %lu mA of %lu mA budget (R %lu, G %lu, B %lu, idle %lu)\n", 
+                 (unsigned long)e.totalMa(), (unsigned long)powerLimiter.budgetMa(), 
+                 (unsigned long)e.redMa, (unsigned long)e.greenMa, (unsigned long)e.blueMa, (unsigned long)e.idleMa);
+    Serial.printf("Brightness: %d/%d, limiting: %s, activations: %lu\n", 
+                 powerLimiter.brightness(), config.brightness, powerLimiter.limiting() ? "yes" : "no", 
+                 (unsigned long)powerLimiter.activations());
+}
+
+//-----------------------------------------------------------------------------
+// HTTP Status & Metrics
+//-----------------------------------------------------------------------------
+const char* displayModeName()
+{
+    switch (displayMode) 
+    {
+    case DISPLAY_FIXED: return "fixed";
+    case DISPLAY_SWEEP: return "sweep";
+    default:            return "live";
+    }
+}
+
+// GET /status: what the clock is showing, as JSON
+void handleStatus(ResponseWriter& out, const char* query)
+{
+    time_t now = displayTime();
+    struct tm t;
+    localtime_r(&now, &t);
+    int currentSecond = (t.tm_hour * 60 + t.tm_min) * 60 + t.tm_sec;
+    const FetchStats& stats = *fetchStats.load();
+    long fetchAge = stats.lastAttemptMs ? (long)((millis() - stats.lastAttemptMs) / 1000) : -1;
+
+    out.printf("{\"uptime_s\":%lu,\"time\":\"%04d-%02d-%02dT%02d:%02d:%02dZ\",\"mode\":\"%s\",", 
+               millis() / 1000, t.tm_year + 1900, t.tm_mon + 1, t.tm_mday, t.tm_hour, t.tm_min, t.tm_sec, 
+               displayModeName());
+    out.printf("\"sun\":{\"source\":\"%s\",\"sunrise\":\"%02d:%02d\",\"solar_noon\":\"%02d:%02d\","
+               "\"sunset\":\"%02d:%02d\",\"day_seconds\":%d},", 
+               shownLive ? "api" : "calculated", 
+               shownSun.sunriseMinutes / 60, shownSun.sunriseMinutes % 60, 
+               shownSun.solarNoonMinutes / 60, shownSun.solarNoonMinutes % 60, 
+               shownSun.sunsetMinutes / 60, shownSun.sunsetMinutes % 60, shownSun.daySeconds);
+    EventKind nextKind;
+    long nextIn = timeline.secondsToNext(now, EVENT_SUN_EVENTS, &nextKind);
+    if (nextIn >= 0) 
+    {
+        char countdown[16];
+        formatCountdown(countdown, sizeof(countdown), nextIn);
+        out.printf("\"next_event\":{\"name\":\"%s\",\"in_s\":%ld,\"in\":\"%s\"},", 
+                   eventName(nextKind), nextIn, countdown);
+    }
+    out.printf("\"leds\":{\"current\":%d,\"sunrise\":%d,\"solar_noon\":%d,\"sunset\":%d},", 
+               currentSecond / secondsPerLed, (shownSun.sunriseMinutes * 60) / secondsPerLed, 
+               (shownSun.solarNoonMinutes * 60) / secondsPerLed, (shownSun.sunsetMinutes * 60) / secondsPerLed);
+    out.printf("\"power\":{\"brightness\":%u,\"current_ma\":%lu,\"limiting\":%s},", 
+               powerLimiter.brightness(), (unsigned long)powerLimiter.currentMa(), 
+               powerLimiter.limiting() ? "true" : "false");
+    out.printf("\"last_fetch\":{\"ok\":%s,\"http_code\":%d,\"age_s\":%ld,\"latency_ms\":%lu},", 
+               stats.lastOk ? "true" : "false", stats.lastCode, fetchAge, 
+               (unsigned long)stats.lastLatencyMs);
+    long today = time(nullptr) / (24*60*60);
+    out.printf("\"sun_cache\":{\"days_ahead\":%d,\"week_handshakes\":%lu,\"week_bytes\":%lu}}\n", 
+               sunCache.load()->daysAhead(today), (unsigned long)stats.weekHandshakes.total(today), 
+               (unsigned long)stats.weekBytes.total(today));
+}
+
+// GET /metrics: Prometheus text format
+void handleMetrics(ResponseWriter& out, const char* query)
+{
+    out.print("# HELP astroclock_stage_us Main loop stage time in microseconds\n"
+              "# TYPE astroclock_stage_us summary\n");
+    for (int i = 0; i < PROFILE_STAGE_COUNT; i++) 
+    {
+        ProfileSummary p = profileSummary((ProfileStage)i);
+        const char* stage = profileStageName((ProfileStage)i);
+        out.printf("astroclock_stage_us{stage=\"%s\",quantile=\"0\"} %.1f\n",    stage, p.minUs);
+        out.printf("astroclock_stage_us{stage=\"%s\",quantile=\"0.99\"} %.1f\n", stage, p.p99Us);
+        out.printf("astroclock_stage_us{stage=\"%s\",quantile=\"1\"} %.1f\n",    stage, p.maxUs);
+        out.printf("astroclock_stage_us_sum{stage=\"%s\"} %.1f\n", stage, p.avgUs * p.count);
+        out.printf("astroclock_stage_us_count{stage=\"%s\"} %lu\n", stage, (unsigned long)p.count);
+    }
+
+    const FetchStats& stats = *fetchStats.load();
+    out.print("# TYPE astroclock_fetch_latency_ms gauge\n");
+    out.printf("astroclock_fetch_latency_ms %lu\n", (unsigned long)stats.lastLatencyMs);
+    out.print("# TYPE astroclock_fetch_total counter\n");
+    out.printf("astroclock_fetch_total{result=\"ok\"} %lu\n",    (unsigned long)stats.successes);
+    out.printf("astroclock_fetch_total{result=\"error\"} %lu\n", (unsigned long)stats.failures);
+    out.print("# TYPE astroclock_fetch_handshakes_total counter\n");
+    out.printf("astroclock_fetch_handshakes_total %lu\n", (unsigned long)stats.handshakes);
+    out.print("# TYPE astroclock_fetch_bytes_total counter\n");
+    out.printf("astroclock_fetch_bytes_total %lu\n", (unsigned long)stats.bytes);
+    long today = time(nullptr) / (24*60*60);
+    out.print("# TYPE astroclock_fetch_week_handshakes gauge\n");
+    out.printf("astroclock_fetch_week_handshakes %lu\n", (unsigned long)stats.weekHandshakes.total(today));
+    out.print("# TYPE astroclock_fetch_week_bytes gauge\n");
+    out.printf("astroclock_fetch_week_bytes %lu\n", (unsigned long)stats.weekBytes.total(today));
+    out.print("# TYPE astroclock_sun_days_cached gauge\n");
+    out.printf("astroclock_sun_days_cached %d\n", sunCache.load()->daysAhead(today));
+    out.print("# HELP astroclock_frame_interval_max_ms Longest gap between clock frames while awake\n"
+              "# TYPE astroclock_frame_interval_max_ms gauge\n");
+    out.printf("astroclock_frame_interval_max_ms %lu\n", (unsigned long)frameIntervalMaxMs);
+
+    const AnimationStats& anim = animStats();
+    out.print("# TYPE astroclock_animations_active gauge\n");
+    out.printf("astroclock_animations_active %d\n", animActiveCount());
+    out.print("# HELP astroclock_render_us_avg Average clock render time, with and without animations running\n"
+              "# TYPE astroclock_render_us_avg gauge\n");
+    out.printf("astroclock_render_us_avg{animating=\"0\"} %.1f\n", anim.idleFrames ? (float)anim.idleUs / anim.idleFrames : 0.0f);
+    out.printf("astroclock_render_us_avg{animating=\"1\"} %.1f\n", anim.activeFrames ? (float)anim.activeUs / anim.activeFrames : 0.0f);
+
+    out.print("# TYPE astroclock_heap_free_bytes gauge\n");
+    out.printf("astroclock_heap_free_bytes %lu\n", (unsigned long)ESP.getFreeHeap());
+    out.print("# TYPE astroclock_heap_min_free_bytes gauge\n");
+    out.printf("astroclock_heap_min_free_bytes %lu\n", (unsigned long)ESP.getMinFreeHeap());
+    const MemorySample& memory = memoryLatest();
+    out.print("# TYPE astroclock_heap_largest_block_bytes gauge\n");
+    out.printf("astroclock_heap_largest_block_bytes %lu\n", (unsigned long)memory.largestBlock);
+    out.print("# HELP astroclock_task_stack_free_bytes Stack never used by each task since boot\n"
+              "# TYPE astroclock_task_stack_free_bytes gauge\n");
+    for (int i = 0; i < MEMORY_TASKS; i++) 
+    {
+        if (memory.stackFree[i] != MEMORY_NO_TASK) 
+        {
+            out.printf("astroclock_task_stack_free_bytes{task=\"%s\"} %d\n", memoryTaskName(i), (int)memory.stackFree[i]);
+        }
+    }
+    const HealthCounts& health = healthCounts();
+    out.print("# HELP astroclock_resets_total Resets by reason, kept in NVS\n"
+              "# TYPE astroclock_resets_total counter\n");
+    for (int i = 0; i < HEALTH_RESET_REASONS; i++) 
+    {
+        if (health.resets[i] != 0) 
+        {
+            out.printf("astroclock_resets_total{reason=\"%s\"} %u\n", healthResetName(i), (unsigned)health.resets[i]);
+        }
+    }
+    out.print("# HELP astroclock_recoveries_total Recoveries by stalled stage and action\n"
+              "# TYPE astroclock_recoveries_total counter\n");
+    for (int i = 0; i < HEALTH_STAGE_COUNT; i++) 
+    {
+        out.printf("astroclock_recoveries_total{stage=\"%s\",action=\"network_restart\"} %u\n", 
+                   healthStageName(i), (unsigned)health.networkRestarts[i]);
+        out.printf("astroclock_recoveries_total{stage=\"%s\",action=\"reset\"} %u\n", 
+                   healthStageName(i), (unsigned)health.softResets[i]);
+    }
+    out.print("# HELP astroclock_boot_step_ms Time from app start to each boot milestone\n"
+              "# TYPE astroclock_boot_step_ms gauge\n");
+    for (int i = 0; i < BOOT_STEP_COUNT; i++) 
+    {
+        uint32_t us = bootStepUs((BootStep)i);
+        if (us != 0) 
+        {
+            out.printf("astroclock_boot_step_ms{step=\"%s\"} %.1f\n", bootStepName((BootStep)i), us / 1000.0f);
+        }
+    }
+    TimeSyncStats timeSync = timeSyncStats();
+    out.print("# TYPE astroclock_time_syncs_total counter\n");
+    out.printf("astroclock_time_syncs_total{action=\"step\"} %lu\n", (unsigned long)timeSync.steps);
+    out.printf("astroclock_time_syncs_total{action=\"slew\"} %lu\n", (unsigned long)timeSync.slews);
+    out.print("# HELP astroclock_time_offset_ms Server minus local time at the last SNTP sync\n"
+              "# TYPE astroclock_time_offset_ms gauge\n");
+    out.printf("astroclock_time_offset_ms %ld\n", (long)timeSync.lastOffsetMs);
+    if (timeSync.driftKnown) 
+    {
+        out.print("# HELP astroclock_time_drift_ppm Local clock rate error, positive when fast\n"
+                  "# TYPE astroclock_time_drift_ppm gauge\n");
+        out.printf("astroclock_time_drift_ppm %.3f\n", timeSync.driftPpm);
+    }
+    out.print("# TYPE astroclock_time_sync_interval_seconds gauge\n");
+    out.printf("astroclock_time_sync_interval_seconds %lu\n", (unsigned long)(timeSync.intervalMs / 1000));
+    out.print("# TYPE astroclock_wifi_rssi_dbm gauge\n");
+    out.printf("astroclock_wifi_rssi_dbm %d\n", (int)WiFi.RSSI());
+    out.print("# TYPE astroclock_uptime_seconds counter\n");
+    out.printf("astroclock_uptime_seconds %lu\n", millis() / 1000);
+
+    out.print("# TYPE astroclock_led_current_ma gauge\n");
+    out.printf("astroclock_led_current_ma %lu\n", (unsigned long)powerLimiter.currentMa());
+    out.print("# TYPE astroclock_brightness gauge\n");
+    out.printf("astroclock_brightness %u\n", powerLimiter.brightness());
+    out.print("# TYPE astroclock_limiter_activations_total counter\n");
+    out.printf("astroclock_limiter_activations_total %lu\n", (unsigned long)powerLimiter.activations());
+
+    out.print("# TYPE astroclock_dropped_total counter\n");
+    out.printf("astroclock_dropped_total{stream=\"telemetry\"} %lu\n", (unsigned long)telemetryDropped());
+    out.printf("astroclock_dropped_total{stream=\"log\"} %lu\n",       (unsigned long)logDropped());
+    out.print("# HELP astroclock_http_too_large_total Responses replaced by a 500 because they did not fit\n"
+              "# TYPE astroclock_http_too_large_total counter\n");
+    out.printf("astroclock_http_too_large_total %lu\n", (unsigned long)webTooLargeResponses());
+}
+
+//-----------------------------------------------------------------------------
+// Runtime Configuration
+//-----------------------------------------------------------------------------
+// Serial commands:
+//   config                         show the settings
+//   config KEY VALUE               change one setting, saved at once
+//   config reset                   back to the compiled-in defaults
+// HTTP: GET /config shows them, POST /config?token=TOKEN&KEY=VALUE&...
+// changes them. The token is made at boot and only shown by the serial
+// config command, so a page in a browser on the network cannot make changes.
+// The network and the LED count take effect at the next restart.
+static char configToken[17];
+
+void makeConfigToken()
+{
+    snprintf(configToken, sizeof(configToken), "%08lx%08lx", 
+             (unsigned long)esp_random(), (unsigned long)esp_random());
+}
+
+Config defaultConfig()
+{
+    Config defaults;
+    memset(&defaults, 0, sizeof(defaults));
+    strncpy(defaults.ssid,     ssid,     sizeof(defaults.ssid) - 1);
+    strncpy(defaults.password, password, sizeof(defaults.password) - 1);
+    defaults.latitude   = LOCATIONS[0].latitude;
+    defaults.longitude  = LOCATIONS[0].longitude;
+    defaults.brightness = BRIGHTNESS;
+    defaults.numLeds    = NUM_LEDS;
+    strcpy(defaults.winterSunrise, WINTER_SOLSTICE_SUNRISE);
+    strcpy(defaults.winterSunset,  WINTER_SOLSTICE_SUNSET);
+    strcpy(defaults.summerSunrise, SUMMER_SOLSTICE_SUNRISE);
+    strcpy(defaults.summerSunset,  SUMMER_SOLSTICE_SUNSET);
+    return defaults;
+}
+
+// Recompute what depends on the config, only where its inputs changed
+// (everything when previous is null)
+void applyConfig(const Config* previous)
+{
+    if (previous == nullptr || previous->brightness != config.brightness) 
+    {
+        powerLimiter.setMaxBrightness(config.brightness);
+        FastLED.setBrightness(config.brightness);
+    }
+
+    if (previous == nullptr || 
+        strcmp(previous->winterSunrise, config.winterSunrise) != 0 || 
+        strcmp(previous->winterSunset,  config.winterSunset)  != 0 || 
+        strcmp(previous->summerSunrise, config.summerSunrise) != 0 || 
+        strcmp(previous->summerSunset,  config.summerSunset)  != 0) 
+    {
+        winterSolsticeSunrise = convertTimeToMinutes(config.winterSunrise);
+        winterSolsticeSunset  = convertTimeToMinutes(config.winterSunset);
+        summerSolsticeSunrise = convertTimeToMinutes(config.summerSunrise);
+        summerSolsticeSunset  = convertTimeToMinutes(config.summerSunset);
+
+        winterSolsticeSunriseLED = minutesToLED(winterSolsticeSunrise);
+        winterSolsticeSunsetLED  = minutesToLED(winterSolsticeSunset);
+        summerSolsticeSunriseLED = minutesToLED(summerSolsticeSunrise);
+        summerSolsticeSunsetLED  = minutesToLED(summerSolsticeSunset);
+    }
+
+    if (previous == nullptr || 
+        previous->latitude != config.latitude || previous->longitude != config.longitude) 
+    {
+        locationLatitude[0]  = (float)config.latitude;
+        locationLongitude[0] = (float)config.longitude;
+        locationBatchDay     = -1;
+        yearTable.year       = 0;
+        sunLocationChanged   = previous != nullptr;
+        buildSunRequestPath();
+    }
+}
+
+bool configAcceptable(const Config& candidate)
+{
+    return candidate.numLeds <= NUM_LEDS && candidate.numLeds >= NUM_LOCATIONS * 24;
+}
+
+// Save and apply a changed config
+void commitConfig(const Config& updated)
+{
+    Config previous = config;
+    config = updated;
+    if (!configSave(config)) 
+    {
+        LOG_ERROR(LOG_NET, "Config could not be saved");
+    }
+    applyConfig(&previous);
+
+    if (strcmp(previous.ssid, config.ssid) != 0 || strcmp(previous.password, config.password) != 0 || 
+        previous.numLeds != config.numLeds) 
+    {
+        LOG_INFO(LOG_NET, "Network and LED count changes apply after a restart");
+    }
+}
+
+void cmdConfig(const char* args)
+{
+    if (*args == '\0') 
+    {
+        char value[72];
+        for (int i = 0; i < configFieldCount(); i++) 
+        {
+            configFieldValue(config, i, value, sizeof(value));
+            Serial.printf("  %-14s %s\n", configFieldKey(i), value);
+        }
+        Serial.printf("HTTP token for POST /config: %s\n", configToken);
+        return;
+    }
+    if (strcmp(args, "reset") == 0) 
+    {
+        configErase();
+        Config previous = config;
+        config = defaultConfig();
+        applyConfig(&previous);
+        Serial.println("Config reset to defaults");
+        return;
+    }
+
+    char key[16];
+    const char* value = strchr(args, ' ');
+    size_t keyLength = value ? (size_t)(value - args) : strlen(args);
+    if (value == nullptr || keyLength >= sizeof(key)) 
+    {
+        Serial.println("Usage: config [KEY VALUE | reset]");
+        return;
+    }
+    memcpy(key, args, keyLength);
+    key[keyLength] = '\0';
+    while (*value == ' ') value++;
+
+    Config updated = config;
+    if (!configSet(updated, key, value) || !configAcceptable(updated)) 
+    {
+        Serial.printf("Invalid setting: %s\n", args);
+        return;
+    }
+    commitConfig(updated);
+}
+
+void printConfigJson(ResponseWriter& out)
+{
+    char value[72];
+    out.printf("{\"version\":%d", CONFIG_VERSION);
+    for (int i = 0; i < configFieldCount(); i++) 
+    {
+        bool quoted = configFieldValue(config, i, value, sizeof(value));
+        out.printf(",\"%s\":", configFieldKey(i));
+        if (quoted) 
+        {
+            out.printJson(value);
+        }
+        else 
+        {
+            out.print(value);
+        }
+    }
+    out.print("}\n");
+}
+
+// GET /config: the settings as JSON
+void handleConfig(ResponseWriter& out, const char* query)
+{
+    if (*query != '\0') 
+    {
+        out.print("{\"error\":\"changes need POST /config with the token from the serial config command\"}\n");
+        return;
+    }
+    printConfigJson(out);
+}
+
+// POST /config?token=TOKEN&KEY=VALUE&...: change settings, then show them
+void handleConfigPost(ResponseWriter& out, const char* query)
+{
+    Config updated = config;
+    char key[16], value[72];
+    bool authorised = false, changed = false;
+    while (webQueryParam(query, key, sizeof(key), value, sizeof(value))) 
+    {
+        if (strcmp(key, "token") == 0) 
+        {
+            authorised = configToken[0] != '\0' && strcmp(value, configToken) == 0;
+            continue;
+        }
+        if (!configSet(updated, key, value) || !configAcceptable(updated)) 
+        {
+            out.print("{\"error\":\"invalid setting\",\"key\":");
+            out.printJson(key);
+            out.print("}\n");
+            return;
+        }
+        changed = true;
+    }
+    if (!authorised) 
+    {
+        LOG_WARN(LOG_NET, "Config change refused, wrong or missing token");
+        out.print("{\"error\":\"wrong or missing token\"}\n");
+        return;
+    }
+    if (changed) 
+    {
+        commitConfig(updated);
+    }
+    printConfigJson(out);
+}
+
+//-----------------------------------------------------------------------------
+// Wake Scheduling
+//-----------------------------------------------------------------------------
+#if LOW_POWER_MODE
+// Milliseconds until the display next has to change: the next LED boundary,
+// the next timeline event (hour chime, sun events, DST, midnight) or a sun
+// data retry
+uint32_t nextWakeMs(uint32_t refreshInMs)
+{
+    struct timeval tv;
+    gettimeofday(&tv, nullptr);
+    time_t now = tv.tv_sec;
+    struct tm* local_time = localtime(&now);
+    int currentSecond = (local_time->tm_hour * 60 + local_time->tm_min) * 60 + local_time->tm_sec;
+
+    long seconds = secondsPerLed - currentSecond % secondsPerLed;
+    const TimelineEvent* next = timeline.next(now);
+    seconds = min(seconds, next ? (long)(next->at - now) : (long)(24*60*60 - currentSecond));
+
+    uint32_t ms = seconds * 1000 - tv.tv_usec / 1000 + LOW_POWER_WAKE_GUARD_MS;
+    ms = min(ms, refreshInMs);
+    return min(ms, (uint32_t)LOW_POWER_MAX_SLEEP_MS);
+}
+
+void cmdSleep(const char* args)
+{
+    const SleepStats& stats = lowPowerStats();
+    uint64_t total = stats.sleepMs + stats.awakeMs;
+    Serial.printf("Low power: %lu wakes (%lu by the console), asleep %.1f%% of the time\n", 
+                 (unsigned long)stats.wakeCount, (unsigned long)stats.consoleWakes, 
+                 total ? 100.0f * stats.sleepMs / total : 0.0f);
+    Serial.printf("Average current: MCU %lu mA, LEDs now %lu mA\n", 
+                 (unsigned long)lowPowerAverageMa(), (unsigned long)powerLimiter.currentMa());
+}
+#endif
+
+//-----------------------------------------------------------------------------
+// Network Start & Recovery
+//-----------------------------------------------------------------------------
+// First SNTP sync, for the boot timeline (runs in the SNTP task)
+void onTimeSync()
+{
+    bootMark(BOOT_NTP_SYNC);
+}
+
+// Everything the first frame does not need. Deferred from setup() until a
+// frame is on the strip; WiFi connects in the background from here.
+void startNetwork()
+{
+    bootMark(BOOT_WIFI_BEGIN);
+    LOG_INFO(LOG_NET, "Connecting to %s", config.ssid);
+    WiFi.begin(config.ssid, config.password);
+    healthWatch(HEALTH_NETWORK, NETWORK_STALL_MS);
+
+    // Status, metrics, config and preview servers
+    makeConfigToken();      // The radio is on, so esp_random() is truly random
+    webRegister("/status",  "application/json", handleStatus);
+    webRegister("/metrics", "text/plain; version=0.0.4", handleMetrics);
+    webRegister("/preview", "text/html", handlePreviewPage);
+    webRegister("/config",  "application/json", handleConfig);
+    webRegisterPost("/config", "application/json", handleConfigPost);
+    webRegister("/memory",  "application/json", handleMemory);
+    webBegin(HTTP_PORT);
+    previewBegin(PREVIEW_PORT, activeLeds);
+    
+    // Initialize time, sun data is fetched in the background once it is known
+    timeSyncBegin(ntpServer, onTimeSync);
+    bootMark(BOOT_CONFIG_TIME);
+    sunFetchBegin();
+    LOG_INFO(LOG_TIME, "Time server %s", ntpServer);
+#if LOW_POWER_MODE
+    lowPowerBegin();
+#endif
+}
+
+// The health supervisor asks for a restart when WiFi stays down or a fetch
+// wedges in the network stack. The WiFi calls are not safe from its task,
+// so it only posts the request and the loop carries it out: open sockets
+// fail and the WiFi driver starts afresh.
+#define NETWORK_RESTART_GAP_MS  200     // Between disconnect and reconnect
+
+std::atomic<bool> networkRestartRequested(false);
+unsigned long     networkRestartMs = 0;     // Disconnected at, 0 = no restart under way
+
+void restartNetwork()
+{
+    networkRestartRequested = true;
+}
+
+void serviceNetworkRestart()
+{
+    if (networkRestartRequested.exchange(false)) 
+    {
+        WiFi.disconnect(true);
+        networkRestartMs = max(millis(), 1UL);
+    }
+    else if (networkRestartMs != 0 && millis() - networkRestartMs >= NETWORK_RESTART_GAP_MS) 
+    {
+        networkRestartMs = 0;
+        WiFi.mode(WIFI_STA);
+        WiFi.begin(config.ssid, config.password);
+    }
+}
+
+//-----------------------------------------------------------------------------
+// Setup & Loop
+//-----------------------------------------------------------------------------
+void setup() 
+{
+    // Initialize serial communication
+    Serial.begin(115200);
+    logBegin();
+    bootMark(BOOT_SERIAL);
+    memoryBegin();
+
+    // Site settings from NVS, and the layout that follows from them
+    bool stored = configLoad(config, defaultConfig());
+    if (!configAcceptable(config)) 
+    {
+        config = defaultConfig();
+        stored = false;
+    }
+    LOG_INFO(LOG_NET, "Config: %s", stored ? "loaded from NVS" : "defaults");
+    bootMark(BOOT_CONFIG);
+    activeLeds    = config.numLeds;
+    segmentLeds   = activeLeds / NUM_LOCATIONS;
+    secondsPerLed = (24*60*60) / segmentLeds;
+    clockFrame.resize(activeLeds);
+    geometry.begin(ClockGeometry::table(), NUM_LEDS, ClockGeometry::physicalCount);
+    physicalLeds  = geometry.extent(activeLeds);
+    if (int overlaps = geometry.overlaps()) 
+    {
+        LOG_ERROR(LOG_RENDER, "LED geometry: %d strip LEDs claimed twice", overlaps);
+    }
+    
+    // Initialize LED strip
+    clockStrip = &FastLED.addLeds<LED_TYPE, LED_PIN, COLOR_ORDER>(leds, physicalLeds).setCorrection(TypicalLEDStrip);
+#if YEAR_NUM_LEDS > 0
+    yearStrip  = &FastLED.addLeds<LED_TYPE, YEAR_LED_PIN, COLOR_ORDER>(yearLeds, YEAR_NUM_LEDS).setCorrection(TypicalLEDStrip);
+#endif
+    bootMark(BOOT_LEDS);
+    
+    // Location arrays for the batched sun calculation
+    for (int location = 0; location < NUM_LOCATIONS; location++) 
+    {
+        locationLatitude[location]  = (float)LOCATIONS[location].latitude;
+        locationLongitude[location] = (float)LOCATIONS[location].longitude;
+    }
+    applyConfig(nullptr);
+
+    // After a reset, the last frame goes straight back on while the rest
+    // starts. It is restored into the compositor so the power limit holds.
+    if (healthRestore(clockLeds, activeLeds, CLOCK_VALID_AFTER)) 
+    {
+        clockFrame.rescan();
+        geometry.remap(clockLeds, leds);
+        showStrip(clockStrip);
+    }
+    
+#if TELEMETRY_BINARY
+    telemetryBegin();
+#endif
+
+    // Serial commands
+    consoleRegister("date",  cmdDate,  "[YYYY-MM-DD [HH:MM]]  show a fixed UTC date");
+    consoleRegister("sweep", cmdSweep, "DAYS_PER_SEC [YYYY-MM-DD]  replay dates");
+    consoleRegister("live",  cmdLive,  "return to the real clock");
+    consoleRegister("power", cmdPower, "current estimate and limiter status");
+    consoleRegister("logbench", logBenchmark, "cost of disabled and enabled log statements");
+    consoleRegister("parsebench", parseBenchmark, "timestamp parser against strptime");
+    consoleRegister("layerbench", layerBenchmark, "layer pipeline against virtual dispatch");
+    consoleRegister("geometry", cmdGeometry, "LED layout and remap cost");
+    consoleRegister("colorbench", colorBenchmark, "OKLab gradient cost and accuracy");
+    consoleRegister("events", cmdEvents, "next sun event and the rest of the day");
+    consoleRegister("anim",  cmdAnimation, "[sunrise | sunset | chime]  animation status and cost");
+    consoleRegister("prof",  cmdProfile, "[reset]  per-stage loop timings");
+    consoleRegister("config", cmdConfig, "[KEY VALUE | reset]  site settings");
+    consoleRegister("fetch", cmdFetch, "[now | cancel]  sun data fetch status");
+    consoleRegister("mem",   cmdMemory, "heap, stack marks and memory history");
+    consoleRegister("health", cmdHealth, "heartbeats, recoveries and reset counts");
+    consoleRegister("boot",  cmdBoot,  "boot timeline");
+    consoleRegister("time",  cmdTime,  "SNTP offset, drift and sync interval");
+#if LOW_POWER_MODE
+    consoleRegister("sleep", cmdSleep, "wake count and average current");
+#endif
+
+    // Supervise the loop from here on, the network once it is started
+    healthWatch(HEALTH_RENDER, RENDER_STALL_MS);
+    healthBegin(restartNetwork);
+
+    // Print initial solstice times for debugging
+    LOG_INFO(LOG_ASTRO, "Winter Solstice - Sunrise: %d minutes (%02d:%02d), Sunset: %d minutes (%02d:%02d)", 
+             winterSolsticeSunrise, winterSolsticeSunrise/60, winterSolsticeSunrise%60,
+             winterSolsticeSunset, winterSolsticeSunset/60, winterSolsticeSunset%60);
+    LOG_INFO(LOG_ASTRO, "Summer Solstice - Sunrise: %d minutes (%02d:%02d), Sunset: %d minutes (%02d:%02d)", 
+             summerSolsticeSunrise, summerSolsticeSunrise/60, summerSolsticeSunrise%60,
+             summerSolsticeSunset, summerSolsticeSunset/60, summerSolsticeSunset%60);
+    bootMark(BOOT_SETUP_DONE);
+}
+
+void loop() 
+{
+    static StripRefresh clockRefresh = {CLOCK_REFRESH_MS, 0, false};
+#if YEAR_NUM_LEDS > 0
+    static StripRefresh yearRefresh  = {YEAR_REFRESH_MS,  0, false};
+#endif
+    
+    static unsigned long lastFetchAttempt = 0;
+#if LOW_POWER_MODE
+    static unsigned long consoleWakeMs    = 0;
+    static bool          consoleAwake     = false;
+#endif
+
+    static bool networkStarted = false;
+    static bool wifiConnected  = false;
+
+    healthBeat(HEALTH_RENDER);
+    bool connected = WiFi.status() == WL_CONNECTED;
+    if (connected) 
+    {
+        healthBeat(HEALTH_NETWORK);
+    }
+    if (connected != wifiConnected) 
+    {
+        wifiConnected = connected;
+        if (connected) 
+        {
+            bootMark(BOOT_WIFI_CONNECTED);
+            LOG_INFO(LOG_NET, "WiFi connected, RSSI %d dBm", (int)WiFi.RSSI());
+        }
+        else 
+        {
+            LOG_WARN(LOG_NET, "WiFi disconnected");
+        }
+    }
+
+    // A new primary location invalidates the fetched data
+    if (sunLocationChanged) 
+    {
+        sunFetchReset();
+        lastFetchAttempt   = 0;
+        sunLocationChanged = false;
+    }
+    
+    // Refill the sun data window in the background when it runs low, retrying
+    // failures at a limited rate (needs WiFi and the real date, not needed
+    // while scrubbing)
+    time_t realNow = time(nullptr);
+    long   today   = realNow / (24*60*60);
+    bool low   = sunCache.load()->daysAhead(today) < SUN_PREFETCH_MIN;
+    bool retry = lastFetchAttempt == 0 || millis() - lastFetchAttempt > SUN_RETRY_MS;
+    if (low && retry && connected && realNow > CLOCK_VALID_AFTER && displayMode == DISPLAY_LIVE && !fetchBusy) 
+    {
+        if (lastFetchAttempt != 0) 
+        {
+            LOG_WARN(LOG_NET, "Sun data still missing, fetching again");
+        }
+        lastFetchAttempt = millis();
+        sunFetchRequest(today);
+    }
+
+    // Serial commands and HTTP requests
+    consolePoll();
+    webPoll();
+    memoryPoll();
+
+    // Get current time (real or scrubbed)
+    struct tm local_tm;
+    time_t shownTime;
+    {
+        PROFILE_STAGE(PROFILE_TIME_LOOKUP);
+        shownTime = displayTime();
+        localtime_r(&shownTime, &local_tm);
+    }
+    const struct tm* local_time = &local_tm;
+
+    // Sweeps and running animations redraw at animation rate
+    bool sweeping  = displayMode == DISPLAY_SWEEP;
+    bool animating = animActiveCount() > 0;
+    clockRefresh.intervalMs = sweeping ? SWEEP_CLOCK_REFRESH_MS : animating ? ANIM_REFRESH_MS : CLOCK_REFRESH_MS;
+#if YEAR_NUM_LEDS > 0
+    yearRefresh.intervalMs  = sweeping ? SWEEP_YEAR_REFRESH_MS  : YEAR_REFRESH_MS;
+#endif
+
+    if (clockRefresh.due(millis()))
+    {
+        unsigned long renderStart = micros();
+        {
+            PROFILE_STAGE(PROFILE_SUN_REFRESH);
+            updateLocationBatch(local_time->tm_yday);
+        }
+        int currentSecond = (local_time->tm_hour * 60 + local_time->tm_min) * 60 + local_time->tm_sec;
+
+        // Clear clock LEDs (FastLED.clear() would also blank the other strips)
+        {
+            PROFILE_STAGE(PROFILE_CLEAR);
+            clockFrame.clear();
+        }
+
+        // One dial per location, the primary prefers live API data
+        const SunData* fetched = sunCache.load()->find(shownTime / (24*60*60));
+        bool live = displayMode == DISPLAY_LIVE && fetched != nullptr;
+        shownSun  = live ? *fetched : locationSunData(0);
+        shownLive = live;
+
+        updateTimeline(shownTime, shownSun, locationTwilight[0]);
+        triggerAnimations(shownSun, currentSecond);
+        animUpdate(millis());
+        for (int location = 0; location < NUM_LOCATIONS; location++) 
+        {
+            bool primary = location == 0;
+            SunData dialSun = primary ? shownSun : locationSunData(location);
+            renderClock(clockFrame, location * segmentLeds, dialSun, locationTwilight[location], currentSecond, 
+                        primary ? countdownSecond(shownTime, currentSecond) : -1, primary);
+        }
+
+        uint32_t renderMicros = micros() - renderStart;
+        animRecordFrame(renderMicros);
+
+        // Debug output (text is too slow to print while sweeping)
+        if (TELEMETRY_BINARY || !sweeping) 
+        {
+            PROFILE_STAGE(PROFILE_DEBUG);
+            reportClock(shownSun, local_time, renderMicros);
+        }
+
+        {
+            PROFILE_STAGE(PROFILE_REMAP);
+            geometry.remap(clockLeds, leds);
+        }
+        {
+            PROFILE_STAGE(PROFILE_SHOW);
+            showStrip(clockStrip);
+        }
+        previewPublish(clockLeds);
+        healthSaveFrame(clockLeds, activeLeds);
+        bootMark(BOOT_FIRST_SHOW);
+        if (displayMode == DISPLAY_LIVE && realNow > CLOCK_VALID_AFTER && bootStepUs(BOOT_CORRECT_FRAME) == 0) 
+        {
+            bootMark(BOOT_CORRECT_FRAME);
+            LOG_INFO(LOG_SYSTEM, "First correct frame %lu ms after start", 
+                     (unsigned long)(bootStepUs(BOOT_CORRECT_FRAME) / 1000));
+        }
+
+        unsigned long frameMs = millis();
+        if (lastFrameMs != 0 && !sweeping) 
+        {
+            frameIntervalMaxMs = max(frameIntervalMaxMs, (uint32_t)(frameMs - lastFrameMs));
+        }
+        lastFrameMs = frameMs;
+        clockRefresh.markShown(frameMs);
+    }
+
+    // The first frame is out, now bring up the rest
+    if (!networkStarted) 
+    {
+        networkStarted = true;
+        startNetwork();
+    }
+    serviceNetworkRestart();
+
+#if YEAR_NUM_LEDS > 0
+    if (yearRefresh.due(millis()))
+    {
+        renderYearStrip(local_time);
+        showStrip(yearStrip);
+        yearRefresh.markShown(millis());
+    }
+#endif
+
+#if LOW_POWER_MODE
+    // Hold the frame and light sleep until the display next has to change
+    // (not while the fetch task is using the network or an animation runs,
+    // nor before WiFi has first connected, nor while someone is typing)
+    if (consoleAwake && millis() - consoleWakeMs >= LOW_POWER_CONSOLE_AWAKE_MS) 
+    {
+        consoleAwake = false;
+    }
+    if (displayMode == DISPLAY_LIVE && !fetchBusy && animActiveCount() == 0 && !consoleAwake &&
+        bootStepUs(BOOT_WIFI_CONNECTED) != 0) 
+    {
+        // A refill is only due at midnight (always a wake) or when retrying
+        unsigned long sinceFetch = millis() - lastFetchAttempt;
+        uint32_t refreshInMs = LOW_POWER_MAX_SLEEP_MS;
+        if (low) 
+        {
+            refreshInMs = sinceFetch < SUN_RETRY_MS ? SUN_RETRY_MS - sinceFetch : 0;
+        }
+
+        uint32_t sleepMs = nextWakeMs(refreshInMs);
+        if (sleepMs > CONSOLE_POLL_MS) 
+        {
+            telemetryWaitEmpty(100);
+            healthPause(sleepMs);
+            if (lowPowerSleep(sleepMs)) 
+            {
+                // The wake edges ate the first characters; give time to retype
+                consoleAwake  = true;
+                consoleWakeMs = millis();
+                Serial.println("Console wake, type the command again");
+            }
+
+            // Redraw straight away on waking
+            clockRefresh.shown = false;
+            lastFrameMs        = 0;
+#if YEAR_NUM_LEDS > 0
+            yearRefresh.shown  = false;
+#endif
+            return;
+        }
+    }
+#endif
+
+    // Sleep until the next strip is due, waking regularly for serial commands
+    unsigned long wait = min(clockRefresh.remaining(millis()), (unsigned long)CONSOLE_POLL_MS);
+#if YEAR_NUM_LEDS > 0
+    wait = min(wait, yearRefresh.remaining(millis()));
+#endif
+    delay(wait);
 }
@@ -0,0 +1,277 @@
+#include "memory_monitor.h"
+
+#include <Arduino.h>
+#include <esp_heap_caps.h>
+#include <esp_attr.h>
+#include <esp_system.h>
+#include "log.h"
+
+//-----------------------------------------------------------------------------
+// Tasks
+//-----------------------------------------------------------------------------
+// Looked up by name once they exist; the handles stay valid as none of
+// these tasks ever ends
+static const char* const TASK_NAMES[MEMORY_TASKS] = 
+{
+    "loopTask", "sunfetch", "preview", "log", "telemetry", "health", "tiT"
+};
+
+static TaskHandle_t taskHandles[MEMORY_TASKS];
+
+const char* memoryTaskName(int task)
+{
+    return (task >= 0 && task < MEMORY_TASKS) ? TASK_NAMES[task] : "-";
+}
+
+//-----------------------------------------------------------------------------
+// RTC History
+//-----------------------------------------------------------------------------
+// Ring of per-period worst samples. The slot at head holds the period in
+// progress and is updated on every sample, so a reset loses nothing.
+#define MEMORY_MAGIC    0x4D454D31      // "MEM1"
+
+struct MemoryHistory
+{
+    uint32_t     magic;
+    uint16_t     boot;
+    uint16_t     head;
+    uint16_t     count;
+    MemorySample samples[MEMORY_HISTORY];
+};
+
+RTC_NOINIT_ATTR static MemoryHistory history;
+
+static MemorySample  latest;
+static unsigned long lastSampleMs  = 0;
+static unsigned long periodStartMs = 0;
+static uint64_t      sampleUs      = 0;     // Total time spent sampling
+static uint8_t       activeAlerts  = 0;
+
+#define ALERT_FREE      0x01
+#define ALERT_FRAGMENT  0x02
+#define ALERT_STACK     0x04
+
+static bool historyValid()
+{
+    return history.magic == MEMORY_MAGIC && history.head < MEMORY_HISTORY && 
+           history.count <= MEMORY_HISTORY && history.count > 0;
+}
+
+// Start a new period in the next slot
+static void historyAdvance(const MemorySample& sample)
+{
+    history.head = (history.head + 1) % MEMORY_HISTORY;
+    if (history.count < MEMORY_HISTORY) history.count++;
+    history.samples[history.head] = sample;
+}
+
+// Fold a sample into the period in progress, keeping the worst of each value
+static void historyMerge(const MemorySample& sample)
+{
+    MemorySample& slot = history.samples[history.head];
+    slot.uptimeS      = sample.uptimeS;
+    slot.fragmentPct  = max(slot.fragmentPct, sample.fragmentPct);
+    slot.alerts      |= sample.alerts;
+    slot.freeHeap     = min(slot.freeHeap, sample.freeHeap);
+    slot.largestBlock = min(slot.largestBlock, sample.largestBlock);
+    slot.minFreeHeap  = min(slot.minFreeHeap, sample.minFreeHeap);
+    for (int i = 0; i < MEMORY_TASKS; i++) 
+    {
+        if (slot.stackFree[i] == MEMORY_NO_TASK || sample.stackFree[i] < slot.stackFree[i]) 
+        {
+            slot.stackFree[i] = sample.stackFree[i];
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------
+// Sampling
+//-----------------------------------------------------------------------------
+static void takeSample(MemorySample& sample)
+{
+    sample.uptimeS      = millis() / 1000;
+    sample.boot         = history.boot;
+    sample.freeHeap     = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+    sample.largestBlock = heap_caps_get_largest_free_block(MALLOC_CAP_8BIT);
+    sample.minFreeHeap  = heap_caps_get_minimum_free_size(MALLOC_CAP_8BIT);
+    sample.fragmentPct  = sample.freeHeap ? 100 - (uint64_t)sample.largestBlock * 100 / sample.freeHeap : 0;
+
+    for (int i = 0; i < MEMORY_TASKS; i++) 
+    {
+        if (taskHandles[i] == nullptr) 
+        {
+            taskHandles[i] = xTaskGetHandle(TASK_NAMES[i]);
+        }
+        // ESP-IDF reports the high-water mark in bytes
+        sample.stackFree[i] = taskHandles[i] ? 
+                              (uint16_t)min((UBaseType_t)uxTaskGetStackHighWaterMark(taskHandles[i]), 
+                                            (UBaseType_t)(MEMORY_NO_TASK - 1)) : 
+                              MEMORY_NO_TASK;
+    }
+
+    uint8_t alerts = 0;
+    if (sample.freeHeap < MEMORY_ALERT_FREE)           alerts |= ALERT_FREE;
+    if (sample.fragmentPct > MEMORY_ALERT_FRAGMENT)    alerts |= ALERT_FRAGMENT;
+    for (int i = 0; i < MEMORY_TASKS; i++) 
+    {
+        if (sample.stackFree[i] < MEMORY_ALERT_STACK) alerts |= ALERT_STACK;
+    }
+    sample.alerts = alerts;
+}
+
+// Log alerts as they start and end, not on every sample
+static void reportAlerts(const MemorySample& sample)
+{
+    uint8_t raised  = sample.alerts & ~activeAlerts;
+    uint8_t cleared = activeAlerts & ~sample.alerts;
+    activeAlerts = sample.alerts;
+
+    if (raised & ALERT_FREE) 
+    {
+        LOG_WARN(LOG_SYSTEM, "Low heap: %lu bytes free", (unsigned long)sample.freeHeap);
+    }
+    if (raised & ALERT_FRAGMENT) 
+    {
+        LOG_WARN(LOG_SYSTEM, "Heap fragmented: %d%% of %lu free bytes outside the largest block (%lu)", 
+                 (int)sample.fragmentPct, (unsigned long)sample.freeHeap, (unsigned long)sample.largestBlock);
+    }
+    if (raised & ALERT_STACK) 
+    {
+        for (int i = 0; i < MEMORY_TASKS; i++) 
+        {
+            if (sample.stackFree[i] < MEMORY_ALERT_STACK) 
+            {
+                LOG_WARN(LOG_SYSTEM, "Task %s stack nearly full: %d bytes never used", 
+                         TASK_NAMES[i], (int)sample.stackFree[i]);
+            }
+        }
+    }
+    if (cleared) 
+    {
+        LOG_INFO(LOG_SYSTEM, "Memory alerts cleared (0x%02x)", (unsigned)cleared);
+    }
+}
+
+void memoryBegin()
+{
+    // Power-on leaves RTC memory undefined; other resets keep the history
+    if (esp_reset_reason() == ESP_RST_POWERON || !historyValid()) 
+    {
+        memset(&history, 0, sizeof(history));
+        history.magic = MEMORY_MAGIC;
+        history.head  = MEMORY_HISTORY - 1;
+    }
+    history.boot++;
+
+    takeSample(latest);
+    historyAdvance(latest);
+    lastSampleMs = periodStartMs = millis();
+    LOG_INFO(LOG_SYSTEM, "Boot %d, %d memory history periods kept", (int)history.boot, (int)history.count - 1);
+}
+
+void memoryPoll()
+{
+    unsigned long now = millis();
+    if (now - lastSampleMs < MEMORY_SAMPLE_MS) 
+    {
+        return;
+    }
+    lastSampleMs = now;
+
+    uint32_t start = micros();
+    takeSample(latest);
+    if (now - periodStartMs >= MEMORY_HISTORY_MS) 
+    {
+        periodStartMs = now;
+        historyAdvance(latest);
+    }
+    else 
+    {
+        historyMerge(latest);
+    }
+    sampleUs += micros() - start;
+
+    reportAlerts(latest);
+}
+
+const MemorySample& memoryLatest()
+{
+    return latest;
+}
+
+uint32_t memoryOverheadPpm()
+{
+    uint64_t elapsedUs = (uint64_t)millis() * 1000;
+    return elapsedUs ? (uint32_t)(sampleUs * 1000000 / elapsedUs) : 0;
+}
+
+//-----------------------------------------------------------------------------
+// Reports
+//-----------------------------------------------------------------------------
+// Oldest first
+static const MemorySample& historyAt(int index)
+{
+    return history.samples[(history.head + MEMORY_HISTORY - history.count + 1 + index) % MEMORY_HISTORY];
+}
+
+// Smallest spare stack of any task in a sample
+static int minStackFree(const MemorySample& s)
+{
+    uint16_t stack = MEMORY_NO_TASK;
+    for (int t = 0; t < MEMORY_TASKS; t++) stack = min(stack, s.stackFree[t]);
+    return stack;
+}
+
+void cmdMemory(const char* args)
+{
+    Serial.printf("Heap: %lu free, largest block %lu (%d%% fragmented), lowest %lu; sampling %lu ppm\n", 
+                 (unsigned long)latest.freeHeap, (unsigned long)latest.largestBlock, (int)latest.fragmentPct, 
+                 (unsigned long)latest.minFreeHeap, (unsigned long)memoryOverheadPpm());
+    for (int i = 0; i < MEMORY_TASKS; i++) 
+    {
+        if (latest.stackFree[i] != MEMORY_NO_TASK) 
+        {
+            Serial.printf("  %-10s %5d bytes of stack never used\n", TASK_NAMES[i], (int)latest.stackFree[i]);
+        }
+    }
+
+    Serial.printf("History (worst per %lu min):\n boot  uptime     free  largest   lowest frag min-stack alerts\n", 
+                 MEMORY_HISTORY_MS / 60000);
+    for (int i = 0; i < history.count; i++) 
+    {
+        const MemorySample& s = historyAt(i);
+        Serial.printf("%5d %6lus %8lu %8lu %8lu %3d%% %9d   0x%02x\n", (int)s.boot, (unsigned long)s.uptimeS, 
+                     (unsigned long)s.freeHeap, (unsigned long)s.largestBlock, (unsigned long)s.minFreeHeap, 
+                     (int)s.fragmentPct, minStackFree(s), (unsigned)s.alerts);
+    }
+}
+
+void handleMemory(ResponseWriter& out, const char* query)
+{
+    out.printf("{\"free\":%lu,\"largest_block\":%lu,\"min_free\":%lu,\"fragment_pct\":%d,\"alerts\":%d,"
+               "\"overhead_ppm\":%lu,\"stack_free\":{", 
+               (unsigned long)latest.freeHeap, (unsigned long)latest.largestBlock, (unsigned long)latest.minFreeHeap, 
+               (int)latest.fragmentPct, (int)latest.alerts, (unsigned long)memoryOverheadPpm());
+    bool first = true;
+    for (int i = 0; i < MEMORY_TASKS; i++) 
+    {
+        if (latest.stackFree[i] != MEMORY_NO_TASK) 
+        {
+            out.printf("%s\"%s\":%d", first ? "" : ",", TASK_NAMES[i], (int)latest.stackFree[i]);
+            first = false;
+        }
+    }
+
+    // History rows are arrays to keep the response small
+    out.printf("},\"period_s\":%lu,\"columns\":[\"boot\",\"uptime_s\",\"free\",\"largest_block\","
+               "\"min_free\",\"fragment_pct\",\"min_stack_free\",\"alerts\"],\"history\":[", 
+               MEMORY_HISTORY_MS / 1000);
+    for (int i = 0; i < history.count; i++) 
+    {
+        const MemorySample& s = historyAt(i);
+        out.printf("%s[%d,%lu,%lu,%lu,%lu,%d,%d,%d]", i > 0 ? "," : "", (int)s.boot, (unsigned long)s.uptimeS, 
+                   (unsigned long)s.freeHeap, (unsigned long)s.largestBlock, (unsigned long)s.minFreeHeap, 
+                   (int)s.fragmentPct, minStackFree(s), (int)s.alerts);
+    }
+    out.print("]}\n");
+}
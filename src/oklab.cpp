@@ -0,0 +1,202 @@
+#include "oklab.h"
+
+#include <Arduino.h>
+#include <math.h>
+#include "const_table.h"
+
+//-----------------------------------------------------------------------------
+// Cube Root Table
+//-----------------------------------------------------------------------------
+// cbrt(i / CBRT_STEPS) for i = 0..CBRT_STEPS, built by the compiler with
+// Newton's method. Inputs are scaled by 8 (halving the root) until they are
+// at least 1/8, where the curve is gentle enough for linear interpolation
+// between entries to stay within 1e-4.
+#define CBRT_STEPS      128
+
+static constexpr double cbrtNewton(double x, double y, int rounds)
+{
+    return rounds == 0 ? y : cbrtNewton(x, y - (y * y * y - x) / (3 * y * y), rounds - 1);
+}
+
+static constexpr float cbrtEntry(int i)
+{
+    return i == 0 ? 0.0f : (float)cbrtNewton((double)i / CBRT_STEPS, 1.0, 24);
+}
+
+struct CbrtEntries
+{
+    typedef float value_type;
+    static constexpr float at(int i) { return cbrtEntry(i); }
+};
+
+typedef ConstTable<CbrtEntries, CBRT_STEPS + 1> Cbrt;
+
+static_assert(Cbrt::values[CBRT_STEPS] > 0.99999f && Cbrt::values[CBRT_STEPS] < 1.00001f, "cbrt(1) != 1");
+static_assert(Cbrt::values[CBRT_STEPS / 8] > 0.49999f && Cbrt::values[CBRT_STEPS / 8] < 0.50001f, "cbrt(1/8) != 1/2");
+
+static inline float cbrtTable(float x)
+{
+    if (x <= 0.0f)
+    {
+        return 0.0f;
+    }
+
+    // Each doubling of the root takes x eight times further from zero
+    float scale = 1.0f;
+    for (int n = 0; x < 0.125f && n < 8; n++)
+    {
+        x     *= 8.0f;
+        scale *= 0.5f;
+    }
+
+    float pos = x * CBRT_STEPS;
+    int   i   = (int)pos;
+    if (i >= CBRT_STEPS)
+    {
+        return scale * Cbrt::values[CBRT_STEPS];
+    }
+    float frac = pos - i;
+    return scale * (Cbrt::values[i] + (Cbrt::values[i + 1] - Cbrt::values[i]) * frac);
+}
+
+//-----------------------------------------------------------------------------
+// Conversion
+//-----------------------------------------------------------------------------
+// Matrices from Björn Ottosson's OKLab reference implementation
+OkLab oklabFromRgb(const CRGB& color)
+{
+    const float k = 1.0f / 255.0f;
+    float r = color.r * k, g = color.g * k, b = color.b * k;
+
+    float l = cbrtTable(0.4122214708f * r + 0.5363325363f * g + 0.0514459929f * b);
+    float m = cbrtTable(0.2119034982f * r + 0.6806995451f * g + 0.1073969566f * b);
+    float s = cbrtTable(0.0883024619f * r + 0.2817188376f * g + 0.6299787005f * b);
+
+    OkLab lab;
+    lab.L = 0.2104542553f * l + 0.7936177850f * m - 0.0040720468f * s;
+    lab.a = 1.9779984951f * l - 2.4285922050f * m + 0.4505937099f * s;
+    lab.b = 0.0259040371f * l + 0.7827717662f * m - 0.8086757660f * s;
+    return lab;
+}
+
+static inline uint8_t toChannel(float v)
+{
+    v = v * 255.0f + 0.5f;
+    return v <= 0.0f ? 0 : v >= 255.0f ? 255 : (uint8_t)v;
+}
+
+CRGB oklabToRgb(const OkLab& color)
+{
+    float l = color.L + 0.3963377774f * color.a + 0.2158037573f * color.b;
+    float m = color.L - 0.1055613458f * color.a - 0.0638541728f * color.b;
+    float s = color.L - 0.0894841775f * color.a - 1.2914855480f * color.b;
+    l = l * l * l;
+    m = m * m * m;
+    s = s * s * s;
+
+    return CRGB(toChannel( 4.0767416621f * l - 3.3077115913f * m + 0.2309699292f * s),
+                toChannel(-1.2684380046f * l + 2.6097574011f * m - 0.3413193965f * s),
+                toChannel(-0.0041960863f * l - 0.7034186147f * m + 1.7076147010f * s));
+}
+
+//-----------------------------------------------------------------------------
+// Blending
+//-----------------------------------------------------------------------------
+static inline OkLab mix(const OkLab& from, const OkLab& to, float t)
+{
+    OkLab lab;
+    lab.L = from.L + (to.L - from.L) * t;
+    lab.a = from.a + (to.a - from.a) * t;
+    lab.b = from.b + (to.b - from.b) * t;
+    return lab;
+}
+
+CRGB oklabBlend(const CRGB& from, const CRGB& to, uint8_t t)
+{
+    if (t == 0)   return from;
+    if (t == 255) return to;
+    return oklabToRgb(mix(oklabFromRgb(from), oklabFromRgb(to), t / 255.0f));
+}
+
+void oklabGradient(CRGB* out, int count, const CRGB& from, const CRGB& to)
+{
+    if (count <= 0)
+    {
+        return;
+    }
+    out[0] = from;
+    if (count == 1)
+    {
+        return;
+    }
+
+    OkLab a = oklabFromRgb(from);
+    OkLab b = oklabFromRgb(to);
+    float step = 1.0f / (count - 1);
+    for (int i = 1; i < count - 1; i++)
+    {
+        out[i] = oklabToRgb(mix(a, b, i * step));
+    }
+    out[count - 1] = to;
+}
+
+//-----------------------------------------------------------------------------
+// Benchmark
+//-----------------------------------------------------------------------------
+// A full-strip gradient against a plain RGB blend, and the table cube root
+// against cbrtf over every colour on the grey axis and the primaries
+#define COLOR_BENCH_LEDS    332
+
+static OkLab oklabExact(const CRGB& color)
+{
+    const float k = 1.0f / 255.0f;
+    float r = color.r * k, g = color.g * k, b = color.b * k;
+    float l = cbrtf(0.4122214708f * r + 0.5363325363f * g + 0.0514459929f * b);
+    float m = cbrtf(0.2119034982f * r + 0.6806995451f * g + 0.1073969566f * b);
+    float s = cbrtf(0.0883024619f * r + 0.2817188376f * g + 0.6299787005f * b);
+
+    OkLab lab;
+    lab.L = 0.2104542553f * l + 0.7936177850f * m - 0.0040720468f * s;
+    lab.a = 1.9779984951f * l - 2.4285922050f * m + 0.4505937099f * s;
+    lab.b = 0.0259040371f * l + 0.7827717662f * m - 0.8086757660f * s;
+    return lab;
+}
+
+void colorBenchmark(const char* args)
+{
+    static CRGB strip[COLOR_BENCH_LEDS];
+    const CRGB night(12, 2, 6), day(0, 0, 8);
+
+    uint32_t start = ESP.getCycleCount();
+    oklabGradient(strip, COLOR_BENCH_LEDS, night, day);
+    uint32_t oklabCycles = ESP.getCycleCount() - start;
+
+    start = ESP.getCycleCount();
+    for (int i = 0; i < COLOR_BENCH_LEDS; i++)
+    {
+        strip[i] = blend(night, day, (uint8_t)(i * 255 / (COLOR_BENCH_LEDS - 1)));
+    }
+    uint32_t rgbCycles = ESP.getCycleCount() - start;
+
+    float worst = 0.0f;
+    int   worstChannel = 0;
+    for (int v = 1; v < 256; v++)
+    {
+        const CRGB samples[] = { CRGB(v, v, v), CRGB(v, 0, 0), CRGB(0, v, 0), CRGB(0, 0, v) };
+        for (const CRGB& c : samples)
+        {
+            OkLab fast = oklabFromRgb(c), exact = oklabExact(c);
+            worst = fmaxf(worst, fmaxf(fabsf(fast.L - exact.L), fmaxf(fabsf(fast.a - exact.a), fabsf(fast.b - exact.b))));
+            CRGB back = oklabToRgb(fast);
+            for (int ch = 0; ch < 3; ch++)
+            {
+                worstChannel = max(worstChannel, abs((int)back[ch] - (int)c[ch]));
+            }
+        }
+    }
+
+    uint32_t mhz = ESP.getCpuFreqMHz();
+    Serial.printf("Gradient, %d LEDs: OKLab %.1f us, RGB %.1f us\n", COLOR_BENCH_LEDS,
+                 (float)oklabCycles / mhz, (float)rgbCycles / mhz);
+    Serial.printf("Table cube root: max OKLab error %.5f, round trip within %d of the input\n", worst, worstChannel);
+}
@@ -0,0 +1,44 @@
+#include "power_limiter.h"
+
+PowerLimiter::PowerLimiter(uint32_t budgetMa, uint8_t maxBrightness, uint8_t rampStep)
+    : budget(budgetMa), maxBrightness(maxBrightness), rampStep(rampStep),
+      current(maxBrightness), limited(false), activationCount(0), lastMa(0)
+{
+}
+
+uint8_t PowerLimiter::update(CurrentEstimator estimateMa)
+{
+    // Highest brightness within budget. Current is linear in brightness above
+    // the idle draw; the estimate rounds up, so step down until it fits.
+    uint32_t target = maxBrightness;
+    uint32_t fullMa = estimateMa(maxBrightness);
+    if (fullMa > budget) 
+    {
+        uint32_t idleMa = estimateMa(0);
+        target = budget > idleMa ? ((budget - idleMa) * maxBrightness) / (fullMa - idleMa) : 0;
+        while (target > 0 && estimateMa(target) > budget) 
+        {
+            target--;
+        }
+    }
+
+    bool nowLimited = target < maxBrightness;
+    if (nowLimited && !limited) 
+    {
+        activationCount++;
+    }
+    limited = nowLimited;
+
+    // Drop immediately, recover smoothly
+    if (target <= current) 
+    {
+        current = target;
+    }
+    else 
+    {
+        current = (uint8_t)(current + rampStep < target ? current + rampStep : target);
+    }
+
+    lastMa = estimateMa(current);
+    return current;
+}
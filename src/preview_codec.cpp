@@ -0,0 +1,80 @@
+#include "preview_codec.h"
+
+static uint16_t readU16(const uint8_t* in)
+{
+    return in[0] | (in[1] << 8);
+}
+
+bool previewNextRun(const CRGB* frame, const CRGB* sent, int count, int& index, int& runLength, bool all)
+{
+    if (all) 
+    {
+        if (index > 0) return false;
+        runLength = count;
+        return true;
+    }
+    while (index < count && frame[index] == sent[index]) index++;
+    if (index >= count) 
+    {
+        return false;
+    }
+    int end = index + 1;
+    int lastChanged = index;
+    while (end < count && end - lastChanged <= PREVIEW_RUN_GAP) 
+    {
+        if (frame[end] != sent[end]) lastChanged = end;
+        end++;
+    }
+    runLength = lastChanged - index + 1;
+    return true;
+}
+
+size_t previewMessageSize(const CRGB* frame, const CRGB* sent, int count, bool keyframe)
+{
+    size_t size = 3;
+    int index = 0, runLength = 0, runs = 0;
+    while (previewNextRun(frame, sent, count, index, runLength, keyframe)) 
+    {
+        size += 4 + runLength * sizeof(CRGB);
+        index += runLength;
+        runs++;
+    }
+    return runs > 0 ? size : 0;
+}
+
+int previewDecode(const uint8_t* message, size_t length, CRGB* pixels, int capacity)
+{
+    if (length < 3 || message[0] > PREVIEW_DELTA) 
+    {
+        return -1;
+    }
+    int count = readU16(&message[1]);
+    if (count > capacity) 
+    {
+        return -1;
+    }
+    if (message[0] == PREVIEW_KEYFRAME) 
+    {
+        fill_solid(pixels, count, CRGB::Black);
+    }
+
+    size_t p = 3;
+    while (p < length) 
+    {
+        if (length - p < 4) 
+        {
+            return -1;
+        }
+        int start = readU16(&message[p]);
+        int runLength = readU16(&message[p + 2]);
+        size_t bytes = runLength * sizeof(CRGB);
+        p += 4;
+        if (start + runLength > count || length - p < bytes) 
+        {
+            return -1;
+        }
+        memcpy(&pixels[start], &message[p], bytes);
+        p += bytes;
+    }
+    return count;
+}
@@ -0,0 +1,131 @@
+#include "profiler.h"
+
+#include <Arduino.h>
+
+//-----------------------------------------------------------------------------
+// Statistics
+//-----------------------------------------------------------------------------
+// Log-linear histogram: four sub-buckets per power of two, which keeps the
+// percentile error under 25% with a fixed 128 buckets per stage
+#define PROFILE_BUCKETS     128
+
+struct StageStats
+{
+    uint32_t count;
+    uint32_t minTicks;
+    uint32_t maxTicks;
+    uint64_t totalTicks;
+    uint32_t buckets[PROFILE_BUCKETS];
+};
+
+static StageStats stats[PROFILE_STAGE_COUNT];
+
+static const char* const STAGE_NAMES[PROFILE_STAGE_COUNT] = 
+{
+    "sun refresh", "time lookup", "clear", "layers", "debug", "remap", "show"
+};
+
+static int bucketIndex(uint32_t ticks)
+{
+    if (ticks < 4) 
+    {
+        return ticks;
+    }
+    int msb = 31 - __builtin_clz(ticks);
+    return msb * 4 + ((ticks >> (msb - 2)) & 3);
+}
+
+// Largest value that falls in a bucket
+static uint32_t bucketLimit(int index)
+{
+    if (index < 4) 
+    {
+        return index;
+    }
+    int msb = index / 4;
+    int sub = index % 4;
+    return (uint32_t)((((uint64_t)(4 + sub + 1)) << (msb - 2)) - 1);
+}
+
+void profileRecord(ProfileStage stage, uint32_t ticks)
+{
+    StageStats& s = stats[stage];
+    if (s.count == 0 || ticks < s.minTicks) s.minTicks = ticks;
+    if (ticks > s.maxTicks) s.maxTicks = ticks;
+    s.totalTicks += ticks;
+    s.count++;
+    s.buckets[bucketIndex(ticks)]++;
+}
+
+void profileReset()
+{
+    memset(stats, 0, sizeof(stats));
+}
+
+//-----------------------------------------------------------------------------
+// Report
+//-----------------------------------------------------------------------------
+static uint32_t percentile(const StageStats& s, uint32_t permille)
+{
+    uint64_t target = ((uint64_t)s.count * permille + 999) / 1000;
+    uint64_t seen = 0;
+    for (int i = 0; i < PROFILE_BUCKETS; i++) 
+    {
+        seen += s.buckets[i];
+        if (seen >= target) 
+        {
+            return min(bucketLimit(i), s.maxTicks);
+        }
+    }
+    return s.maxTicks;
+}
+
+ProfileSummary profileSummary(ProfileStage stage)
+{
+#if defined(__XTENSA__)
+    const float ticksPerUs = getCpuFrequencyMhz();
+#else
+    const float ticksPerUs = 1000.0f;
+#endif
+    const StageStats& s = stats[stage];
+    ProfileSummary summary = { s.count, 0, 0, 0, 0 };
+    if (s.count > 0) 
+    {
+        summary.minUs = s.minTicks / ticksPerUs;
+        summary.avgUs = (float)(s.totalTicks / s.count) / ticksPerUs;
+        summary.p99Us = percentile(s, 990) / ticksPerUs;
+        summary.maxUs = s.maxTicks / ticksPerUs;
+    }
+    return summary;
+}
+
+const char* profileStageName(ProfileStage stage)
+{
+    return STAGE_NAMES[stage];
+}
+
+void profileDump()
+{
+    Serial.println("Stage          count      min      avg      p99      max  (us)");
+    for (int i = 0; i < PROFILE_STAGE_COUNT; i++) 
+    {
+        ProfileSummary s = profileSummary((ProfileStage)i);
+        if (s.count == 0) 
+        {
+            continue;
+        }
+        Serial.printf("%-12s %7lu %8.1f %8.1f %8.1f %8.1f\n", STAGE_NAMES[i], (unsigned long)s.count, 
+                     s.minUs, s.avgUs, s.p99Us, s.maxUs);
+    }
+}
+
+void cmdProfile(const char* args)
+{
+    if (strcmp(args, "reset") == 0) 
+    {
+        profileReset();
+        Serial.println("Profile reset");
+        return;
+    }
+    profileDump();
+}
@@ -0,0 +1,150 @@
+#include "sun_calc.h"
+
+#include <math.h>
+
+//-----------------------------------------------------------------------------
+// Solar Geometry
+//-----------------------------------------------------------------------------
+static const float DEG_TO_RAD_F   = 0.017453292f;
+static const float RAD_TO_DEG_F   = 57.29577951f;
+static const float SUNRISE_ZENITH = 90.833f * DEG_TO_RAD_F;    // Includes refraction and solar disc
+static const float CIVIL_ZENITH   = 96.0f * DEG_TO_RAD_F;      // Civil dawn and dusk
+
+// Fractional year in radians, evaluated at solar noon
+static float fractionalYear(int dayOfYear)
+{
+    return (2.0f * (float)M_PI / 365.0f) * (float)dayOfYear;
+}
+
+// Equation of time in minutes
+static float equationOfTime(float gamma)
+{
+    return 229.18f * (0.000075f + 0.001868f * cosf(gamma) - 0.032077f * sinf(gamma)
+                      - 0.014615f * cosf(2 * gamma) - 0.040849f * sinf(2 * gamma));
+}
+
+// Solar declination in radians
+static float declination(float gamma)
+{
+    return 0.006918f - 0.399912f * cosf(gamma) + 0.070257f * sinf(gamma)
+           - 0.006758f * cosf(2 * gamma) + 0.000907f * sinf(2 * gamma)
+           - 0.002697f * cosf(3 * gamma) + 0.00148f  * sinf(3 * gamma);
+}
+
+static int16_t wrapMinutes(float minutes)
+{
+    int m = (int)lroundf(minutes) % 1440;
+    return (int16_t)(m < 0 ? m + 1440 : m);
+}
+
+SunTimes calcSunTimes(float latitude, float longitude, int dayOfYear)
+{
+    float gamma  = fractionalYear(dayOfYear);
+    float eqTime = equationOfTime(gamma);
+    float decl   = declination(gamma);
+    float lat    = latitude * DEG_TO_RAD_F;
+
+    SunTimes t;
+    float noon = 720.0f - 4.0f * longitude - eqTime;
+    t.solarNoonMinutes = wrapMinutes(noon);
+
+    float cosHa = cosf(SUNRISE_ZENITH) / (cosf(lat) * cosf(decl)) - tanf(lat) * tanf(decl);
+    if (cosHa >= 1.0f)
+    {
+        // Polar night: sun never rises, collapse the day onto solar noon
+        t.sunriseMinutes = t.sunsetMinutes = t.solarNoonMinutes;
+        t.dayMinutes = 0;
+    }
+    else if (cosHa <= -1.0f)
+    {
+        // Midnight sun: daylight covers the whole dial
+        t.sunriseMinutes = 0;
+        t.sunsetMinutes  = 1439;
+        t.dayMinutes     = 1440;
+    }
+    else
+    {
+        float haMinutes = 4.0f * acosf(cosHa) * RAD_TO_DEG_F;
+        t.sunriseMinutes = wrapMinutes(noon - haMinutes);
+        t.sunsetMinutes  = wrapMinutes(noon + haMinutes);
+        t.dayMinutes     = (int16_t)lroundf(2.0f * haMinutes);
+    }
+    return t;
+}
+
+//-----------------------------------------------------------------------------
+// Batched Calculation
+//-----------------------------------------------------------------------------
+void calcSunTimesBatch(const SunBatch& batch, int dayOfYear)
+{
+    // Date terms shared by every location
+    float gamma    = fractionalYear(dayOfYear);
+    float eqTime   = equationOfTime(gamma);
+    float decl     = declination(gamma);
+    float cosZen   = cosf(SUNRISE_ZENITH) / cosf(decl);
+    float cosCivil = cosf(CIVIL_ZENITH) / cosf(decl);
+    float tanDecl  = tanf(decl);
+    const float minutesPerRad = 4.0f * RAD_TO_DEG_F;
+
+    for (int i = 0; i < batch.count; i++)
+    {
+        float lat      = batch.latitude[i] * DEG_TO_RAD_F;
+        float noon     = 720.0f - 4.0f * batch.longitude[i] - eqTime;
+        float cosLat   = cosf(lat);
+        float tanLat   = tanf(lat);
+        float cosHa    = cosZen / cosLat - tanLat * tanDecl;
+        float cosHaCiv = cosCivil / cosLat - tanLat * tanDecl;
+
+        // Clamping covers polar night (ha = 0) and midnight sun (ha = pi)
+        cosHa    = fminf(1.0f, fmaxf(-1.0f, cosHa));
+        cosHaCiv = fminf(1.0f, fmaxf(-1.0f, cosHaCiv));
+        float haMinutes  = minutesPerRad * acosf(cosHa);
+        float civMinutes = minutesPerRad * acosf(cosHaCiv);
+        float dayLength  = 2.0f * haMinutes;
+        bool  fullDay    = dayLength >= 1439.5f;
+
+        batch.solarNoonMinutes[i] = wrapMinutes(noon);
+        batch.sunriseMinutes[i]   = fullDay ? 0    : wrapMinutes(noon - haMinutes);
+        batch.sunsetMinutes[i]    = fullDay ? 1439 : wrapMinutes(noon + haMinutes);
+        batch.dayMinutes[i]       = (int16_t)lroundf(dayLength);
+        batch.twilightMinutes[i]  = (int16_t)lroundf(civMinutes - haMinutes);
+    }
+}
+
+//-----------------------------------------------------------------------------
+// Yearly Daylight Table
+//-----------------------------------------------------------------------------
+static bool isLeapYear(int year)
+{
+    return (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+}
+
+void buildYearTable(YearTable& table, float latitude, float longitude, int year)
+{
+    table.year = year;
+    table.days = isLeapYear(year) ? 366 : 365;
+    table.minDayMinutes = 1440;
+    table.maxDayMinutes = 0;
+    table.springEquinoxDay = table.autumnEquinoxDay = 0;
+    table.summerSolsticeDay = table.winterSolsticeDay = 0;
+
+    float maxDecl = -1.0f, minDecl = 1.0f;
+    float prevDecl = declination(fractionalYear(0));
+
+    for (int day = 0; day < table.days; day++)
+    {
+        uint16_t minutes = (uint16_t)calcSunTimes(latitude, longitude, day).dayMinutes;
+        table.dayMinutes[day] = minutes;
+        if (minutes < table.minDayMinutes) table.minDayMinutes = minutes;
+        if (minutes > table.maxDayMinutes) table.maxDayMinutes = minutes;
+
+        // Solstices and equinoxes are defined by the declination, not by
+        // local day length, so they stay correct at any latitude
+        float decl = declination(fractionalYear(day));
+        if (decl > maxDecl) { maxDecl = decl; table.summerSolsticeDay = day; }
+        if (decl < minDecl) { minDecl = decl; table.winterSolsticeDay = day; }
+        if (prevDecl < 0 && decl >= 0) table.springEquinoxDay = day;
+        if (prevDecl > 0 && decl <= 0) table.autumnEquinoxDay = day;
+        prevDecl = decl;
+    }
+}
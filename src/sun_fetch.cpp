@@ -0,0 +1,149 @@
+#include "sun_fetch.h"
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include "log.h"
+#include "time_parse.h"
+
+#define SUN_BODY_LENGTH     1024    // A response is about 300 bytes
+#define SUN_JSON_POOL       3072
+
+//-----------------------------------------------------------------------------
+// JSON Pool
+//-----------------------------------------------------------------------------
+// Bump allocator over a static buffer for the response document. Blocks
+// keep their size in a header so the document can grow or shrink its last
+// block in place; reset() releases everything before the next parse.
+class JsonPool : public ArduinoJson::Allocator
+{
+public:
+    void* allocate(size_t size) override
+    {
+        size = align(size);
+        if (used + HEADER + size > sizeof(pool)) 
+        {
+            return nullptr;
+        }
+        uint8_t* block = pool + used + HEADER;
+        setSize(block, size);
+        used += HEADER + size;
+        peak  = max(peak, used);
+        last  = block;
+        return block;
+    }
+
+    void deallocate(void* ptr) override
+    {
+        if (ptr != nullptr && ptr == last) 
+        {
+            used = (uint8_t*)ptr - HEADER - pool;
+            last = nullptr;
+        }
+    }
+
+    void* reallocate(void* ptr, size_t size) override
+    {
+        if (ptr == nullptr) 
+        {
+            return allocate(size);
+        }
+        size = align(size);
+        size_t current = getSize(ptr);
+        if (ptr == last) 
+        {
+            size_t start = (uint8_t*)ptr - pool;
+            if (start + size > sizeof(pool)) 
+            {
+                return nullptr;
+            }
+            setSize(ptr, size);
+            used = start + size;
+            peak = max(peak, used);
+            return ptr;
+        }
+        if (size <= current) 
+        {
+            return ptr;
+        }
+        void* moved = allocate(size);
+        if (moved != nullptr) 
+        {
+            memcpy(moved, ptr, current);
+        }
+        return moved;
+    }
+
+    void   reset()          { used = 0; last = nullptr; }
+    size_t peakUsed() const { return peak; }
+    size_t capacity() const { return sizeof(pool); }
+
+private:
+    static const size_t HEADER = 8;     // Keeps blocks 8-byte aligned for doubles
+
+    static size_t align(size_t size)             { return (size + 7) & ~(size_t)7; }
+    static size_t getSize(void* block)           { return *(size_t*)((uint8_t*)block - HEADER); }
+    static void   setSize(void* block, size_t n) { *(size_t*)((uint8_t*)block - HEADER) = n; }
+
+    alignas(8) uint8_t pool[SUN_JSON_POOL];
+    size_t   used = 0;
+    size_t   peak = 0;
+    void*    last = nullptr;
+};
+
+static char     sunResponse[SUN_BODY_LENGTH];
+static JsonPool sunJsonPool;
+
+size_t sunJsonPoolPeak()     { return sunJsonPool.peakUsed(); }
+size_t sunJsonPoolCapacity() { return sunJsonPool.capacity(); }
+
+//-----------------------------------------------------------------------------
+// Fetch and Parse
+//-----------------------------------------------------------------------------
+SunParseResult sunParseResponse(const char* body, size_t length, SunData& data)
+{
+    data = SunData();
+    sunJsonPool.reset();
+    JsonDocument doc(&sunJsonPool);
+    if (deserializeJson(doc, body, length)) 
+    {
+        return SUN_PARSE_INVALID_JSON;
+    }
+
+    // Every field must be present and well formed, or the day is not used
+    JsonObject results = doc["results"];
+    int daySeconds     = results["day_length"] | -1;
+    if (!parseIsoUtcMinutes(results["sunrise"].as<const char*>(), data.sunriseMinutes) || 
+        !parseIsoUtcMinutes(results["sunset"].as<const char*>(), data.sunsetMinutes) || 
+        !parseIsoUtcMinutes(results["solar_noon"].as<const char*>(), data.solarNoonMinutes) || 
+        daySeconds < 0 || daySeconds > 24*60*60) 
+    {
+        return SUN_PARSE_MALFORMED;
+    }
+    data.daySeconds = daySeconds;
+    data.lastUpdate = millis();
+    return SUN_PARSE_OK;
+}
+
+int sunFetchDay(WiFiClient& client, const HttpTarget& api, const char* pathAndQuery, long day,
+                SunData& data, size_t& length, uint32_t timeoutMs)
+{
+    data = SunData();
+    int code = httpFetch(client, api, pathAndQuery, sunResponse, sizeof(sunResponse), length, timeoutMs);
+    if (code != 200) 
+    {
+        return code;
+    }
+
+    switch (sunParseResponse(sunResponse, length, data)) 
+    {
+    case SUN_PARSE_INVALID_JSON:
+        LOG_WARN(LOG_NET, "Sun data for day %ld rejected: invalid JSON", day);
+        break;
+    case SUN_PARSE_MALFORMED:
+        LOG_WARN(LOG_NET, "Sun data for day %ld rejected: malformed fields", day);
+        break;
+    default:
+        break;
+    }
+    return code;
+}
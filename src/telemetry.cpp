@@ -0,0 +1,228 @@
+#include "telemetry.h"
+
+#include <Arduino.h>
+#include <atomic>
+#include "log.h"
+
+//-----------------------------------------------------------------------------
+// Ring Buffer
+//-----------------------------------------------------------------------------
+// Single producer (render loop), single consumer (drain task). Indices only
+// ever grow; the producer owns head, the consumer owns tail.
+#define TELEMETRY_RING_SIZE     1024    // Power of two
+#define TELEMETRY_DRAIN_MS      10      // Drain task idle poll interval
+
+static uint8_t               ring[TELEMETRY_RING_SIZE];
+static std::atomic<uint32_t> ringHead(0);
+static std::atomic<uint32_t> ringTail(0);
+static std::atomic<uint32_t> droppedFrames(0);
+
+static bool ringWrite(const uint8_t* data, size_t length)
+{
+    uint32_t head = ringHead.load(std::memory_order_relaxed);
+    uint32_t tail = ringTail.load(std::memory_order_acquire);
+    if (TELEMETRY_RING_SIZE - (head - tail) < length) 
+    {
+        return false;
+    }
+    for (size_t i = 0; i < length; i++) 
+    {
+        ring[(head + i) & (TELEMETRY_RING_SIZE - 1)] = data[i];
+    }
+    ringHead.store(head + length, std::memory_order_release);
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+// Frame Encoding
+//-----------------------------------------------------------------------------
+static uint8_t crc8(const uint8_t* data, size_t length)
+{
+    uint8_t crc = 0;
+    for (size_t i = 0; i < length; i++) 
+    {
+        crc ^= data[i];
+        for (int bit = 0; bit < 8; bit++) 
+        {
+            crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x07) : (uint8_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+// Consistent Overhead Byte Stuffing: removes every 0x00 from the data
+static size_t cobsEncode(const uint8_t* in, size_t length, uint8_t* out)
+{
+    size_t  written  = 1;
+    size_t  codeAt   = 0;
+    uint8_t code     = 1;
+    for (size_t i = 0; i < length; i++) 
+    {
+        if (in[i] == 0) 
+        {
+            out[codeAt] = code;
+            codeAt = written++;
+            code = 1;
+        }
+        else 
+        {
+            out[written++] = in[i];
+            if (++code == 0xFF) 
+            {
+                out[codeAt] = code;
+                codeAt = written++;
+                code = 1;
+            }
+        }
+    }
+    out[codeAt] = code;
+    return written;
+}
+
+static size_t cobsDecode(const uint8_t* in, size_t length, uint8_t* out, size_t size)
+{
+    size_t written = 0;
+    size_t i = 0;
+    while (i < length) 
+    {
+        uint8_t code = in[i];
+        if (code == 0 || i + code > length || written + code > size + 1) 
+        {
+            return SIZE_MAX;
+        }
+        for (size_t k = 1; k < code; k++) 
+        {
+            out[written++] = in[i + k];
+        }
+        i += code;
+        if (code != 0xFF && i < length) 
+        {
+            if (written == size) 
+            {
+                return SIZE_MAX;
+            }
+            out[written++] = 0;
+        }
+    }
+    return written;
+}
+
+size_t telemetryEncode(const uint8_t* payload, size_t length, uint8_t* frame)
+{
+    if (length == 0 || length > TELEMETRY_MAX_PAYLOAD - 1) 
+    {
+        return 0;
+    }
+    uint8_t block[TELEMETRY_MAX_PAYLOAD];
+    memcpy(block, payload, length);
+    block[length] = crc8(payload, length);
+
+    // Delimiter, COBS block, delimiter
+    frame[0] = 0;
+    size_t size = 1 + cobsEncode(block, length + 1, &frame[1]);
+    frame[size++] = 0;
+    return size;
+}
+
+int telemetryDecode(const uint8_t* block, size_t length, uint8_t* payload, size_t size)
+{
+    uint8_t decoded[TELEMETRY_MAX_PAYLOAD];
+    size_t count = cobsDecode(block, length, decoded, sizeof(decoded));
+    if (count == SIZE_MAX || count < 2 || count - 1 > size || crc8(decoded, count - 1) != decoded[count - 1]) 
+    {
+        return -1;
+    }
+    memcpy(payload, decoded, count - 1);
+    return (int)(count - 1);
+}
+
+TelemetryFrame::TelemetryFrame(TelemetryType type) : length(0), overflow(false)
+{
+    payload[length++] = type;
+}
+
+void TelemetryFrame::put(uint32_t value)
+{
+    do 
+    {
+        if (length >= TELEMETRY_MAX_PAYLOAD - 1)    // Keep room for the CRC
+        {
+            overflow = true;
+            return;
+        }
+        uint8_t byte = value & 0x7F;
+        value >>= 7;
+        payload[length++] = value ? (byte | 0x80) : byte;
+    } while (value);
+}
+
+void TelemetryFrame::putSigned(int32_t value)
+{
+    put(((uint32_t)value << 1) ^ (uint32_t)(value >> 31));
+}
+
+bool TelemetryFrame::send()
+{
+    if (overflow) 
+    {
+        droppedFrames++;
+        return false;
+    }
+    uint8_t encoded[TELEMETRY_MAX_FRAME];
+    size_t size = telemetryEncode(payload, length, encoded);
+    if (!ringWrite(encoded, size)) 
+    {
+        droppedFrames++;
+        return false;
+    }
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+// Drain Task
+//-----------------------------------------------------------------------------
+// The ring only ever holds whole frames, so writing everything pending under
+// the serial lock keeps each frame in one piece on the wire
+static void drainTask(void* param)
+{
+    for (;;) 
+    {
+        uint32_t tail  = ringTail.load(std::memory_order_relaxed);
+        uint32_t head  = ringHead.load(std::memory_order_acquire);
+        if (head == tail) 
+        {
+            vTaskDelay(pdMS_TO_TICKS(TELEMETRY_DRAIN_MS));
+            continue;
+        }
+
+        logLockSerial();
+        while (tail != head) 
+        {
+            size_t offset = tail & (TELEMETRY_RING_SIZE - 1);
+            size_t count  = min((size_t)(head - tail), (size_t)(TELEMETRY_RING_SIZE - offset));
+            Serial.write(&ring[offset], count);
+            tail += count;
+        }
+        logUnlockSerial();
+        ringTail.store(tail, std::memory_order_release);
+    }
+}
+
+void telemetryBegin()
+{
+    xTaskCreatePinnedToCore(drainTask, "telemetry", 2048, nullptr, 1, nullptr, 0);
+}
+
+void telemetryWaitEmpty(uint32_t timeoutMs)
+{
+    unsigned long start = millis();
+    while (ringTail.load() != ringHead.load() && millis() - start < timeoutMs) 
+    {
+        delay(1);
+    }
+}
+
+uint32_t telemetryDropped()
+{
+    return droppedFrames.load();
+}
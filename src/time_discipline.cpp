@@ -0,0 +1,71 @@
+#include "time_discipline.h"
+
+#include <math.h>
+#include <stdlib.h>
+
+TimeDiscipline::TimeDiscipline()
+    : driftRefUs(0), leadUs(0), drift(0.0f), known(false), interval(TIME_SYNC_INITIAL_MS)
+{
+}
+
+uint32_t TimeDiscipline::intervalForDrift(float ppm)
+{
+    float magnitude = fabsf(ppm);
+    if (magnitude < 0.1f) 
+    {
+        return TIME_SYNC_MAX_MS;
+    }
+    float ms = TIME_TARGET_ERROR_MS * 1e6f / magnitude;
+    if (ms < TIME_SYNC_MIN_MS) return TIME_SYNC_MIN_MS;
+    if (ms > TIME_SYNC_MAX_MS) return TIME_SYNC_MAX_MS;
+    return (uint32_t)ms;
+}
+
+TimeCorrection TimeDiscipline::sync(int64_t serverUs, int64_t localUs, int64_t outstandingUs)
+{
+    TimeCorrection correction;
+    correction.offsetUs = serverUs - localUs;
+    correction.step     = llabs(correction.offsetUs) > (int64_t)TIME_SLEW_LIMIT_MS * 1000;
+    correction.slewUs   = 0;
+
+    if (correction.step) 
+    {
+        // Also ends any slew in progress
+        leadUs = 0;
+    }
+    else 
+    {
+        // What is still being slewed in, and the lead, are our own doing
+        int64_t driftUs = correction.offsetUs - outstandingUs + leadUs;
+        int64_t spanUs  = serverUs - driftRefUs;
+        if (driftRefUs != 0 && spanUs >= (int64_t)TIME_DRIFT_MIN_SPAN_S * 1000000) 
+        {
+            float measured = -(float)driftUs * 1e6f / (float)spanUs;
+            drift    = known ? (1.0f - TIME_DRIFT_WEIGHT) * drift + TIME_DRIFT_WEIGHT * measured : measured;
+            known    = true;
+            interval = intervalForDrift(drift);
+        }
+
+        // Half the drift expected by the next sync, in advance
+        leadUs = known ? -(int64_t)(drift * (float)interval / 2000.0f) : 0;
+        correction.slewUs = correction.offsetUs + leadUs;
+    }
+    driftRefUs = serverUs;
+    return correction;
+}
+
+time_t DisplayClock::show(time_t now)
+{
+    if (now < shown && shown - now <= TIME_HOLD_LIMIT_S) 
+    {
+        if (!holding) 
+        {
+            holding = true;
+            holdCount++;
+        }
+        return shown;
+    }
+    holding = false;
+    shown   = now;
+    return now;
+}
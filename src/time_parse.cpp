@@ -0,0 +1,161 @@
+#include "time_parse.h"
+
+#include <Arduino.h>
+#include <time.h>
+
+//-----------------------------------------------------------------------------
+// Field Readers
+//-----------------------------------------------------------------------------
+// Exactly count decimal digits
+static bool readDigits(const char*& p, int count, int& value)
+{
+    value = 0;
+    for (int i = 0; i < count; i++) 
+    {
+        if (p[i] < '0' || p[i] > '9') 
+        {
+            return false;
+        }
+        value = value * 10 + (p[i] - '0');
+    }
+    p += count;
+    return true;
+}
+
+static bool expect(const char*& p, char c)
+{
+    if (*p != c) 
+    {
+        return false;
+    }
+    p++;
+    return true;
+}
+
+static int daysInMonth(int year, int month)
+{
+    static const uint8_t DAYS[12] = { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+    bool leap = (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+    return (month == 2 && leap) ? 29 : DAYS[month - 1];
+}
+
+//-----------------------------------------------------------------------------
+// Parsers
+//-----------------------------------------------------------------------------
+bool parseIsoTimestamp(const char* text, IsoTimestamp& out)
+{
+    if (text == nullptr) 
+    {
+        return false;
+    }
+    const char* p = text;
+    IsoTimestamp t;
+    if (!readDigits(p, 4, t.year)   || !expect(p, '-') || 
+        !readDigits(p, 2, t.month)  || !expect(p, '-') || 
+        !readDigits(p, 2, t.day)    || !expect(p, 'T') || 
+        !readDigits(p, 2, t.hour)   || !expect(p, ':') || 
+        !readDigits(p, 2, t.minute) || !expect(p, ':') || 
+        !readDigits(p, 2, t.second)) 
+    {
+        return false;
+    }
+
+    // Fractional seconds are allowed and ignored
+    if (*p == '.') 
+    {
+        p++;
+        if (*p < '0' || *p > '9') return false;
+        while (*p >= '0' && *p <= '9') p++;
+    }
+
+    t.offsetMinutes = 0;
+    if (*p == 'Z') 
+    {
+        p++;
+    }
+    else if (*p == '+' || *p == '-') 
+    {
+        int sign = *p++ == '-' ? -1 : 1;
+        int hours, minutes;
+        if (!readDigits(p, 2, hours) || !expect(p, ':') || !readDigits(p, 2, minutes) || 
+            hours > 23 || minutes > 59) 
+        {
+            return false;
+        }
+        t.offsetMinutes = sign * (hours * 60 + minutes);
+    }
+    else 
+    {
+        return false;
+    }
+
+    if (*p != '\0' || t.month < 1 || t.month > 12 || t.day < 1 || t.day > daysInMonth(t.year, t.month) || 
+        t.hour > 23 || t.minute > 59 || t.second > 60) 
+    {
+        return false;
+    }
+    out = t;
+    return true;
+}
+
+bool parseIsoUtcMinutes(const char* text, int& minutes)
+{
+    IsoTimestamp t;
+    if (!parseIsoTimestamp(text, t)) 
+    {
+        return false;
+    }
+    int utc = (t.hour * 60 + t.minute - t.offsetMinutes) % 1440;
+    minutes = utc < 0 ? utc + 1440 : utc;
+    return true;
+}
+
+bool parseClockTime(const char* text, int& minutes)
+{
+    if (text == nullptr) 
+    {
+        return false;
+    }
+    const char* p = text;
+    int hours, mins;
+    bool twoDigits = text[0] != '\0' && text[1] != ':';
+    if (!readDigits(p, twoDigits ? 2 : 1, hours) || !expect(p, ':') || !readDigits(p, 2, mins) || 
+        *p != '\0' || hours > 23 || mins > 59) 
+    {
+        return false;
+    }
+    minutes = hours * 60 + mins;
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+// Benchmark
+//-----------------------------------------------------------------------------
+#define PARSE_BENCH_RUNS    200
+
+void parseBenchmark(const char* args)
+{
+    static const char SAMPLE[] = "2024-06-21T03:43:27+00:00";
+    volatile int sink = 0;
+
+    uint32_t start = ESP.getCycleCount();
+    for (int i = 0; i < PARSE_BENCH_RUNS; i++) 
+    {
+        struct tm t = {0};
+        strptime(SAMPLE, "%Y-%m-%dT%H:%M:%S+00:00", &t);
+        sink = sink + t.tm_hour * 60 + t.tm_min;
+    }
+    uint32_t strptimeCycles = ESP.getCycleCount() - start;
+
+    start = ESP.getCycleCount();
+    for (int i = 0; i < PARSE_BENCH_RUNS; i++) 
+    {
+        int minutes = 0;
+        parseIsoUtcMinutes(SAMPLE, minutes);
+        sink = sink + minutes;
+    }
+    uint32_t parseCycles = ESP.getCycleCount() - start;
+
+    Serial.printf("Timestamp parse: strptime %lu cycles, parseIsoUtcMinutes %lu cycles per call\n", 
+                 (unsigned long)(strptimeCycles / PARSE_BENCH_RUNS), (unsigned long)(parseCycles / PARSE_BENCH_RUNS));
+}
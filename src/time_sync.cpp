@@ -0,0 +1,138 @@
+#include "time_sync.h"
+
+#include <Arduino.h>
+#include <esp_sntp.h>
+#include <stdlib.h>
+#include <sys/time.h>
+#include "log.h"
+
+static TimeSyncStats   stats      = { 0, 0, 0, 0, 0, 0.0f, false, TIME_SYNC_INITIAL_MS, 0 };
+static portMUX_TYPE    statsLock  = portMUX_INITIALIZER_UNLOCKED;
+static TimeDiscipline  discipline;          // Only the SNTP task uses it
+static DisplayClock    displayClock;        // Only the render loop uses it
+static void          (*syncHandler)() = nullptr;
+
+static int64_t toUs(const struct timeval& tv)
+{
+    return (int64_t)tv.tv_sec * 1000000 + tv.tv_usec;
+}
+
+static struct timeval fromUs(int64_t us)
+{
+    struct timeval tv;
+    tv.tv_sec  = (time_t)(us / 1000000);
+    tv.tv_usec = (suseconds_t)(us % 1000000);
+    if (tv.tv_usec < 0) 
+    {
+        tv.tv_sec--;
+        tv.tv_usec += 1000000;
+    }
+    return tv;
+}
+
+//-----------------------------------------------------------------------------
+// SNTP Hook
+//-----------------------------------------------------------------------------
+// Replaces ESP-IDF's weak default, runs in the lwIP task with the server time
+extern "C" void sntp_sync_time(struct timeval* tv)
+{
+    struct timeval local;
+    struct timeval outstanding = { 0, 0 };
+    gettimeofday(&local, nullptr);
+    adjtime(nullptr, &outstanding);
+
+    TimeCorrection correction = discipline.sync(toUs(*tv), toUs(local), toUs(outstanding));
+    bool    step     = correction.step;
+    int64_t offsetUs = correction.offsetUs;
+    if (step) 
+    {
+        settimeofday(tv, nullptr);          // Also ends any slew in progress
+    }
+    else 
+    {
+        struct timeval delta = fromUs(correction.slewUs);
+        adjtime(&delta, nullptr);
+    }
+
+    portENTER_CRITICAL(&statsLock);
+    stats.syncs++;
+    if (step) stats.steps++; else stats.slews++;
+    stats.lastOffsetMs = (int32_t)constrain(offsetUs / 1000, (int64_t)INT32_MIN, (int64_t)INT32_MAX);
+    stats.lastSyncMs   = max(millis(), 1UL);
+    stats.driftPpm     = discipline.driftPpm();
+    stats.driftKnown   = discipline.driftKnown();
+    stats.intervalMs   = discipline.intervalMs();
+    portEXIT_CRITICAL(&statsLock);
+    uint32_t interval = discipline.intervalMs();
+    float    drift    = discipline.driftPpm();
+
+    sntp_set_sync_interval(interval);
+    sntp_set_sync_status(SNTP_SYNC_STATUS_COMPLETED);
+    LOG_INFO(LOG_TIME, "SNTP %s by %ld ms, drift %.2f ppm, next sync in %lu s", step ? "stepped" : "slewing", 
+             (long)(offsetUs / 1000), drift, (unsigned long)(interval / 1000));
+
+    if (syncHandler != nullptr) 
+    {
+        syncHandler();
+    }
+}
+
+void timeSyncBegin(const char* server, void (*onSync)())
+{
+    syncHandler = onSync;
+    sntp_set_sync_interval(TIME_SYNC_INITIAL_MS);
+    configTime(0, 0, server);
+}
+
+//-----------------------------------------------------------------------------
+// Display Clock
+//-----------------------------------------------------------------------------
+// Only called from the render loop's task
+time_t timeSyncNow()
+{
+    uint32_t held = displayClock.holds();
+    time_t shown = displayClock.show(time(nullptr));
+    if (displayClock.holds() != held) 
+    {
+        portENTER_CRITICAL(&statsLock);
+        stats.holds++;
+        portEXIT_CRITICAL(&statsLock);
+    }
+    return shown;
+}
+
+TimeSyncStats timeSyncStats()
+{
+    portENTER_CRITICAL(&statsLock);
+    TimeSyncStats copy = stats;
+    portEXIT_CRITICAL(&statsLock);
+    return copy;
+}
+
+void cmdTime(const char* args)
+{
+    TimeSyncStats s = timeSyncStats();
+    struct timeval outstanding = { 0, 0 };
+    adjtime(nullptr, &outstanding);
+    if (s.lastSyncMs == 0) 
+    {
+        Serial.println("No SNTP sync yet");
+    }
+    else 
+    {
+        Serial.printf("Last sync %lu s ago, offset %ld ms, %ld ms still slewing\n", 
+                     (millis() - s.lastSyncMs) / 1000, (long)s.lastOffsetMs, 
+                     (long)(toUs(outstanding) / 1000));
+    }
+    if (s.driftKnown) 
+    {
+        Serial.printf("Drift %.2f ppm (%s), ", s.driftPpm, s.driftPpm >= 0 ? "fast" : "slow");
+    }
+    else 
+    {
+        Serial.print("Drift not measured yet, ");
+    }
+    Serial.printf("sync every %lu s\n", (unsigned long)(s.intervalMs / 1000));
+    Serial.printf("%lu syncs: %lu stepped, %lu slewed; display held %lu times\n", (unsigned long)s.syncs, 
+                 (unsigned long)s.steps, (unsigned long)s.slews, (unsigned long)s.holds);
+}
@@ -0,0 +1,306 @@
+#include "web_server.h"
+#include "log.h"
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include <stdarg.h>
+
+//-----------------------------------------------------------------------------
+// Response Writer
+//-----------------------------------------------------------------------------
+ResponseWriter::ResponseWriter(char* buffer, size_t size)
+    : buffer(buffer), size(size), used(0), truncated(false)
+{
+    buffer[0] = '\0';
+}
+
+void ResponseWriter::print(const char* text)
+{
+    size_t length = strlen(text);
+    if (used + length >= size) 
+    {
+        length = size - used - 1;
+        truncated = true;
+    }
+    memcpy(&buffer[used], text, length);
+    used += length;
+    buffer[used] = '\0';
+}
+
+void ResponseWriter::printf(const char* format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    int written = vsnprintf(&buffer[used], size - used, format, args);
+    va_end(args);
+
+    if (written < 0 || used + written >= size) 
+    {
+        used = size - 1;
+        truncated = true;
+    }
+    else 
+    {
+        used += written;
+    }
+}
+
+void ResponseWriter::printJson(const char* text)
+{
+    print("\"");
+    for (const char* p = text; *p; p++) 
+    {
+        unsigned char c = *p;
+        if (c == '"' || c == '\\') 
+        {
+            char escaped[3] = { '\\', (char)c, '\0' };
+            print(escaped);
+        }
+        else if (c < 0x20) 
+        {
+            printf("\\u%04x", c);
+        }
+        else 
+        {
+            char plain[2] = { (char)c, '\0' };
+            print(plain);
+        }
+    }
+    print("\"");
+}
+
+//-----------------------------------------------------------------------------
+// Routing
+//-----------------------------------------------------------------------------
+#define WEB_MAX_ROUTES      8
+#define WEB_REQUEST_LENGTH  256
+#define WEB_RESPONSE_SIZE   8192
+#define WEB_HEADER_SIZE     160
+#define WEB_READ_DEADLINE_MS 20     // Give up on clients slower than this
+
+struct WebRoute
+{
+    const char* path;
+    const char* contentType;
+    WebHandler  handler;
+    bool        post;
+};
+
+static WebRoute routes[WEB_MAX_ROUTES];
+static int      routeCount = 0;
+static uint32_t tooLargeCount = 0;
+
+static void addRoute(const char* path, const char* contentType, WebHandler handler, bool post)
+{
+    if (routeCount == WEB_MAX_ROUTES) 
+    {
+        LOG_ERROR(LOG_NET, "Web server full, %s not registered (raise WEB_MAX_ROUTES)", path);
+        return;
+    }
+    routes[routeCount++] = { path, contentType, handler, post };
+}
+
+void webRegister(const char* path, const char* contentType, WebHandler handler)
+{
+    addRoute(path, contentType, handler, false);
+}
+
+void webRegisterPost(const char* path, const char* contentType, WebHandler handler)
+{
+    addRoute(path, contentType, handler, true);
+}
+
+size_t webHandleRequest(const char* request, char* response, size_t size)
+{
+    // Request line: "GET /path?query HTTP/1.1", or the same with POST
+    char path[64] = "";
+    char query[192] = "";
+    bool post = strncmp(request, "POST ", 5) == 0;
+    if (post || strncmp(request, "GET ", 4) == 0) 
+    {
+        const char* p = request + (post ? 5 : 4);
+        size_t n = 0;
+        while (*p && *p != ' ' && *p != '?' && n < sizeof(path) - 1) path[n++] = *p++;
+        path[n] = '\0';
+        if (*p == '?') 
+        {
+            p++;
+            n = 0;
+            while (*p && *p != ' ' && n < sizeof(query) - 1) query[n++] = *p++;
+            query[n] = '\0';
+        }
+    }
+
+    const WebRoute* route = nullptr;
+    bool pathKnown = false;
+    for (int i = 0; i < routeCount; i++) 
+    {
+        if (strcmp(path, routes[i].path) == 0) 
+        {
+            pathKnown = true;
+            if (routes[i].post == post) 
+            {
+                route = &routes[i];
+                break;
+            }
+        }
+    }
+
+    // Body first, after room reserved for the headers
+    if (size <= WEB_HEADER_SIZE) 
+    {
+        return 0;
+    }
+    ResponseWriter body(response + WEB_HEADER_SIZE, size - WEB_HEADER_SIZE);
+    const char* status      = "200 OK";
+    const char* contentType = "text/plain";
+    if (route != nullptr) 
+    {
+        route->handler(body, query);
+        contentType = route->contentType;
+    }
+    else if (pathKnown) 
+    {
+        status = "405 Method Not Allowed";
+        body.print("Method not allowed\n");
+    }
+    else 
+    {
+        status = "404 Not Found";
+        body.print("Not found\n");
+    }
+
+    // Never send a body that was cut short
+    if (body.overflow()) 
+    {
+        // The log line is formatted later, so the path needs to outlive this
+        // call; there may be no route to take it from (404 and 405)
+        static char tooLargePath[sizeof(path)];
+        memcpy(tooLargePath, path, sizeof(path));
+        tooLargeCount++;
+        LOG_WARN(LOG_NET, "Response for %s is over %u bytes, sent 500 instead", 
+                 tooLargePath, (unsigned)(size - WEB_HEADER_SIZE));
+        body        = ResponseWriter(response + WEB_HEADER_SIZE, size - WEB_HEADER_SIZE);
+        status      = "500 Internal Server Error";
+        contentType = "text/plain";
+        body.print("Response too large\n");
+    }
+
+    // Headers, then slide the body up against them
+    char header[WEB_HEADER_SIZE];
+    int headerLength = snprintf(header, sizeof(header), 
+                                "HTTP/1.0 %s\r\nContent-Type: %s\r\nContent-Length: %u\r\n"
+                                "Cache-Control: no-store\r\nConnection: close\r\n\r\n",
+                                status, contentType, (unsigned)body.length());
+    if (headerLength <= 0 || headerLength >= WEB_HEADER_SIZE) 
+    {
+        return 0;
+    }
+    memmove(response + headerLength, response + WEB_HEADER_SIZE, body.length());
+    memcpy(response, header, headerLength);
+    return headerLength + body.length();
+}
+
+uint32_t webTooLargeResponses()
+{
+    return tooLargeCount;
+}
+
+//-----------------------------------------------------------------------------
+// Query Parameters
+//-----------------------------------------------------------------------------
+static int hexValue(char c)
+{
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+// Copy and percent-decode up to the next stop character
+static const char* decodeUntil(const char* p, char stop, char* out, size_t size)
+{
+    size_t n = 0;
+    while (*p && *p != stop && *p != '&') 
+    {
+        char c = *p++;
+        if (c == '+') 
+        {
+            c = ' ';
+        }
+        else if (c == '%' && hexValue(p[0]) >= 0 && hexValue(p[1]) >= 0) 
+        {
+            c = (char)(hexValue(p[0]) * 16 + hexValue(p[1]));
+            p += 2;
+        }
+        if (n < size - 1) out[n++] = c;
+    }
+    out[n] = '\0';
+    return p;
+}
+
+bool webQueryParam(const char*& query, char* key, size_t keySize, char* value, size_t valueSize)
+{
+    while (*query == '&') query++;
+    if (*query == '\0') 
+    {
+        return false;
+    }
+    query = decodeUntil(query, '=', key, keySize);
+    value[0] = '\0';
+    if (*query == '=') 
+    {
+        query = decodeUntil(query + 1, '&', value, valueSize);
+    }
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+// Socket Layer
+//-----------------------------------------------------------------------------
+static WiFiServer* server = nullptr;
+static char        requestBuffer[WEB_REQUEST_LENGTH];
+static char        responseBuffer[WEB_RESPONSE_SIZE];
+
+void webBegin(uint16_t port)
+{
+    static WiFiServer instance(port);
+    server = &instance;
+    server->begin();
+    server->setNoDelay(true);
+}
+
+void webPoll()
+{
+    if (server == nullptr) 
+    {
+        return;
+    }
+    WiFiClient client = server->available();
+    if (!client) 
+    {
+        return;
+    }
+
+    // Only the request line matters, read it with a hard deadline
+    size_t length = 0;
+    unsigned long start = millis();
+    while (client.connected() && millis() - start < WEB_READ_DEADLINE_MS && length < sizeof(requestBuffer) - 1) 
+    {
+        int c = client.read();
+        if (c < 0) 
+        {
+            continue;
+        }
+        if (c == '\n') 
+        {
+            break;
+        }
+        requestBuffer[length++] = (char)c;
+    }
+    requestBuffer[length] = '\0';
+
+    size_t responseLength = webHandleRequest(requestBuffer, responseBuffer, sizeof(responseBuffer));
+    client.write((const uint8_t*)responseBuffer, responseLength);
+    client.stop();
+}
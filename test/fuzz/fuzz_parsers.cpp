@@ -0,0 +1,114 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sun_fetch.h"
+#include "time_parse.h"
+
+//-----------------------------------------------------------------------------
+// libFuzzer Targets for the Parsers of Network Text
+//-----------------------------------------------------------------------------
+// The first input byte picks the parser, the rest is its input, so one
+// binary covers all three and libFuzzer learns the selector on its own.
+// Input goes into a buffer of exactly its own size, so AddressSanitizer
+// catches a parser reading one byte too far. A parse that succeeds must
+// also give values in range.
+//
+//     pio run -e fuzz
+//     .pio/build/fuzz/program -dict=test/fuzz/parsers.dict -max_total_time=600
+
+enum FuzzTarget
+{
+    FUZZ_ISO_TIMESTAMP,
+    FUZZ_CLOCK_TIME,
+    FUZZ_SUN_RESPONSE,
+    FUZZ_TARGET_COUNT
+};
+
+static void check(bool condition)
+{
+    if (!condition)
+    {
+        abort();
+    }
+}
+
+// As text from the API or the config: null-terminated, nothing after it
+static char* terminatedCopy(const uint8_t* data, size_t size)
+{
+    char* text = (char*)malloc(size + 1);
+    memcpy(text, data, size);
+    text[size] = '\0';
+    return text;
+}
+
+static void fuzzIsoTimestamp(const uint8_t* data, size_t size)
+{
+    char* text = terminatedCopy(data, size);
+    IsoTimestamp t;
+    if (parseIsoTimestamp(text, t))
+    {
+        check(t.month >= 1 && t.month <= 12 && t.day >= 1 && t.day <= 31);
+        check(t.hour >= 0 && t.hour <= 23 && t.minute >= 0 && t.minute <= 59 && t.second >= 0 && t.second <= 60);
+        check(t.offsetMinutes > -24 * 60 && t.offsetMinutes < 24 * 60);
+    }
+    int minutes;
+    if (parseIsoUtcMinutes(text, minutes))
+    {
+        check(minutes >= 0 && minutes < 24 * 60);
+    }
+    free(text);
+}
+
+static void fuzzClockTime(const uint8_t* data, size_t size)
+{
+    char* text = terminatedCopy(data, size);
+    int minutes;
+    if (parseClockTime(text, minutes))
+    {
+        check(minutes >= 0 && minutes < 24 * 60);
+    }
+    free(text);
+}
+
+// The response body as httpFetch() hands it over, down the same path as
+// doc["results"]["sunrise"] and the other fields
+static void fuzzSunResponse(const uint8_t* data, size_t size)
+{
+    char* body = (char*)malloc(size ? size : 1);
+    memcpy(body, data, size);
+    SunData sun;
+    if (sunParseResponse(body, size, sun) == SUN_PARSE_OK)
+    {
+        check(sun.sunriseMinutes >= 0 && sun.sunriseMinutes < 24 * 60);
+        check(sun.sunsetMinutes >= 0 && sun.sunsetMinutes < 24 * 60);
+        check(sun.solarNoonMinutes >= 0 && sun.solarNoonMinutes < 24 * 60);
+        check(sun.daySeconds >= 0 && sun.daySeconds <= 24 * 60 * 60);
+    }
+    else
+    {
+        check(sun.lastUpdate == 0);
+    }
+    check(sunJsonPoolPeak() <= sunJsonPoolCapacity());
+    free(body);
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size)
+{
+    if (size == 0)
+    {
+        return 0;
+    }
+    switch (data[0] % FUZZ_TARGET_COUNT)
+    {
+    case FUZZ_ISO_TIMESTAMP:
+        fuzzIsoTimestamp(data + 1, size - 1);
+        break;
+    case FUZZ_CLOCK_TIME:
+        fuzzClockTime(data + 1, size - 1);
+        break;
+    default:
+        fuzzSunResponse(data + 1, size - 1);
+        break;
+    }
+    return 0;
+}
@@ -0,0 +1,5 @@
+# libFuzzer ships with clang, while the native platform builds with gcc
+Import("env")
+
+env.Replace(CC="clang", CXX="clang++", LINK="clang++")
+env.Append(LINKFLAGS=["-fsanitize=fuzzer,address"])
@@ -0,0 +1,91 @@
+#pragma once
+
+//-----------------------------------------------------------------------------
+// Host Stand-in for the Arduino Core
+//-----------------------------------------------------------------------------
+// Just enough of the ESP32 Arduino API for the modules built by the native
+// test environment. millis() and delay() run on a fake clock that only moves
+// when a test (or delay()) advances it; the cycle counter is the host's
+// steady clock in nanoseconds, so benchmarks report real host timings.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <math.h>
+#include <time.h>
+#include <algorithm>
+#include <chrono>
+
+#include "freertos/FreeRTOS.h"
+
+using std::min;
+using std::max;
+
+typedef uint8_t byte;
+
+#define PROGMEM
+#define IRAM_ATTR
+#define RTC_DATA_ATTR
+#define RTC_NOINIT_ATTR
+
+template<class T> T constrain(T x, T low, T high) { return x < low ? low : (x > high ? high : x); }
+
+//-----------------------------------------------------------------------------
+// Fake Clock
+//-----------------------------------------------------------------------------
+inline unsigned long& stubClockMs()
+{
+    static unsigned long now = 0;
+    return now;
+}
+
+inline void stubAdvanceMs(unsigned long ms) { stubClockMs() += ms; }
+
+inline unsigned long millis() { return stubClockMs(); }
+inline unsigned long micros() { return stubClockMs() * 1000UL; }
+inline void delay(unsigned long ms) { stubAdvanceMs(ms); }
+
+//-----------------------------------------------------------------------------
+// Serial and ESP
+//-----------------------------------------------------------------------------
+class HardwareSerial
+{
+public:
+    void   begin(unsigned long) {}
+    size_t print(const char* text) { return fputs(text, stdout) < 0 ? 0 : strlen(text); }
+    size_t println(const char* text = "") { return print(text) + print("\n"); }
+    size_t write(const uint8_t* data, size_t length) { return fwrite(data, 1, length, stdout); }
+    size_t write(uint8_t c) { return fputc(c, stdout) < 0 ? 0 : 1; }
+    int    available() { return 0; }
+    int    read() { return -1; }
+    void   flush() { fflush(stdout); }
+
+    size_t printf(const char* format, ...) __attribute__((format(printf, 2, 3)))
+    {
+        va_list args;
+        va_start(args, format);
+        int length = vprintf(format, args);
+        va_end(args);
+        return length < 0 ? 0 : length;
+    }
+};
+
+class EspClass
+{
+public:
+    // One "cycle" per host nanosecond
+    uint32_t getCycleCount()
+    {
+        return (uint32_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+    uint32_t getCpuFreqMHz() { return 1000; }
+    uint32_t getFreeHeap()   { return 200000; }
+};
+
+// Stateless, so a copy per translation unit is fine
+static HardwareSerial Serial __attribute__((unused));
+static EspClass       ESP __attribute__((unused));
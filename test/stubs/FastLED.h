@@ -0,0 +1,93 @@
+#pragma once
+
+//-----------------------------------------------------------------------------
+// Host Stand-in for FastLED
+//-----------------------------------------------------------------------------
+// The pixel type and the few 8-bit helpers the tested modules use, with the
+// same arithmetic as FastLED so frame contents match the board.
+
+#include <Arduino.h>
+
+inline uint8_t scale8(uint8_t i, uint8_t scale) { return (uint8_t)(((uint16_t)i * scale) >> 8); }
+
+inline uint8_t scale8_video(uint8_t i, uint8_t scale)
+{
+    return (uint8_t)((((uint16_t)i * scale) >> 8) + ((i && scale) ? 1 : 0));
+}
+
+inline uint8_t qadd8(uint8_t a, uint8_t b) { return a + b > 255 ? 255 : a + b; }
+inline uint8_t qsub8(uint8_t a, uint8_t b) { return a > b ? a - b : 0; }
+
+inline uint8_t blend8(uint8_t a, uint8_t b, uint8_t amountOfB)
+{
+    uint16_t partial = (uint16_t)((a << 8) | b);
+    partial += b * amountOfB;
+    partial -= a * amountOfB;
+    return partial >> 8;
+}
+
+struct CRGB
+{
+    union
+    {
+        struct { uint8_t r, g, b; };
+        uint8_t raw[3];
+    };
+
+    enum HTMLColorCode
+    {
+        Black = 0x000000,
+        White = 0xFFFFFF,
+        Red   = 0xFF0000,
+        Green = 0x008000,
+        Blue  = 0x0000FF
+    };
+
+    CRGB() {}
+    CRGB(uint8_t r, uint8_t g, uint8_t b) : r(r), g(g), b(b) {}
+    CRGB(uint32_t code) : r(code >> 16), g(code >> 8), b(code) {}
+    CRGB(HTMLColorCode code) : CRGB((uint32_t)code) {}
+
+    uint8_t&       operator[](int i)       { return raw[i]; }
+    const uint8_t& operator[](int i) const { return raw[i]; }
+
+    bool operator==(const CRGB& o) const { return r == o.r && g == o.g && b == o.b; }
+    bool operator!=(const CRGB& o) const { return !(*this == o); }
+
+    CRGB& operator+=(const CRGB& o)
+    {
+        r = qadd8(r, o.r);
+        g = qadd8(g, o.g);
+        b = qadd8(b, o.b);
+        return *this;
+    }
+
+    CRGB& nscale8_video(uint8_t scale)
+    {
+        r = scale8_video(r, scale);
+        g = scale8_video(g, scale);
+        b = scale8_video(b, scale);
+        return *this;
+    }
+
+    CRGB& nscale8(uint8_t scale)
+    {
+        r = scale8(r, scale);
+        g = scale8(g, scale);
+        b = scale8(b, scale);
+        return *this;
+    }
+};
+
+inline CRGB blend(const CRGB& a, const CRGB& b, uint8_t amountOfB)
+{
+    return CRGB(blend8(a.r, b.r, amountOfB), blend8(a.g, b.g, amountOfB), blend8(a.b, b.b, amountOfB));
+}
+
+inline void fill_solid(CRGB* leds, int count, const CRGB& color)
+{
+    for (int i = 0; i < count; i++) 
+    {
+        leds[i] = color;
+    }
+}
@@ -0,0 +1,165 @@
+#pragma once
+
+//-----------------------------------------------------------------------------
+// Host Stand-in for the WiFi Sockets
+//-----------------------------------------------------------------------------
+// A WiFiClient talks to a scripted peer: the bytes it will send, how fast
+// they arrive on the fake clock, where it goes quiet and whether it closes
+// afterwards. Everything the client writes is captured. Nothing here
+// allocates, so heap checks around the code under test stay exact.
+
+#include <Arduino.h>
+
+struct StubPeer
+{
+    const char*   incoming;         // Everything the peer will send
+    size_t        incomingLength;
+    size_t        readPos;
+    uint32_t      msPerByte;        // Arrival rate, 0 for all at once
+    uint32_t      delayMs;          // Silence before the first byte
+    size_t        stallAt;          // Bytes sent before the peer goes quiet
+    bool          closeWhenSent;    // Peer closes once everything is sent
+    bool          refuse;           // connect() fails
+    bool          open;
+    unsigned long openedMs;
+    int           connects;
+    char          sent[10240];      // What the client wrote
+    size_t        sentLength;
+};
+
+inline void stubPeerInit(StubPeer& peer, const char* incoming, bool closeWhenSent = true)
+{
+    memset(&peer, 0, sizeof(peer));
+    peer.incoming       = incoming;
+    peer.incomingLength = strlen(incoming);
+    peer.stallAt        = (size_t)-1;
+    peer.closeWhenSent  = closeWhenSent;
+}
+
+class WiFiClient
+{
+public:
+    WiFiClient() : peer(nullptr) {}
+    explicit WiFiClient(StubPeer* peer) : peer(peer) {}
+
+    int connect(const char* host, uint16_t port)
+    {
+        if (peer == nullptr || peer->refuse) 
+        {
+            return 0;
+        }
+        peer->open     = true;
+        peer->openedMs = millis();
+        peer->connects++;
+        return 1;
+    }
+
+    uint8_t connected()
+    {
+        if (peer == nullptr || !peer->open) 
+        {
+            return 0;
+        }
+        bool peerClosed = peer->closeWhenSent && arrived() == peer->incomingLength;
+        return !peerClosed || available() > 0;
+    }
+
+    int available()
+    {
+        return peer != nullptr && peer->open ? (int)(arrived() - peer->readPos) : 0;
+    }
+
+    // Polling an idle socket takes time
+    int read()
+    {
+        if (available() <= 0) 
+        {
+            stubAdvanceMs(1);
+            return -1;
+        }
+        return (uint8_t)peer->incoming[peer->readPos++];
+    }
+
+    int read(uint8_t* buffer, size_t size)
+    {
+        size_t n = min((size_t)max(available(), 0), size);
+        if (n == 0) 
+        {
+            stubAdvanceMs(1);
+            return -1;
+        }
+        memcpy(buffer, &peer->incoming[peer->readPos], n);
+        peer->readPos += n;
+        return (int)n;
+    }
+
+    size_t write(const uint8_t* data, size_t length)
+    {
+        if (peer == nullptr || !peer->open) 
+        {
+            return 0;
+        }
+        size_t n = min(length, sizeof(peer->sent) - 1 - peer->sentLength);
+        memcpy(&peer->sent[peer->sentLength], data, n);
+        peer->sentLength += n;
+        peer->sent[peer->sentLength] = '\0';
+        return length;
+    }
+
+    void stop()
+    {
+        if (peer != nullptr) 
+        {
+            peer->open = false;
+        }
+    }
+
+    operator bool() { return peer != nullptr && peer->open; }
+
+private:
+    StubPeer* peer;
+
+    size_t arrived() const
+    {
+        unsigned long since = millis() - peer->openedMs;
+        if (since < peer->delayMs) 
+        {
+            return 0;
+        }
+        size_t n = peer->incomingLength;
+        if (peer->msPerByte > 0) 
+        {
+            n = min(n, (size_t)((since - peer->delayMs) / peer->msPerByte));
+        }
+        return min(n, peer->stallAt);
+    }
+};
+
+// The next connection a WiFiServer accepts
+inline StubPeer*& stubPendingPeer()
+{
+    static StubPeer* pending = nullptr;
+    return pending;
+}
+
+inline void stubAccept(StubPeer& peer)
+{
+    peer.open     = true;
+    peer.openedMs = millis();
+    stubPendingPeer() = &peer;
+}
+
+class WiFiServer
+{
+public:
+    WiFiServer(uint16_t port) {}
+    void begin() {}
+    void setNoDelay(bool) {}
+
+    WiFiClient available()
+    {
+        StubPeer* peer = stubPendingPeer();
+        stubPendingPeer() = nullptr;
+        return WiFiClient(peer);
+    }
+};
@@ -0,0 +1,96 @@
+#pragma once
+
+//-----------------------------------------------------------------------------
+// Host Stand-in for FreeRTOS
+//-----------------------------------------------------------------------------
+// Queues are plain ring buffers and mutexes are counters. Tasks are never
+// started, so anything queued stays queued until the test reads it.
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef int           BaseType_t;
+typedef unsigned int  UBaseType_t;
+typedef uint32_t      TickType_t;
+typedef void*         TaskHandle_t;
+typedef void (*TaskFunction_t)(void*);
+
+#define pdTRUE              1
+#define pdFALSE             0
+#define pdPASS              pdTRUE
+#define portMAX_DELAY       0xFFFFFFFFUL
+#define portTICK_PERIOD_MS  1
+#define pdMS_TO_TICKS(ms)   ((TickType_t)(ms))
+
+struct StubQueue
+{
+    UBaseType_t length;
+    UBaseType_t itemSize;
+    UBaseType_t head;
+    UBaseType_t count;
+    uint8_t*    items;
+};
+
+typedef StubQueue* QueueHandle_t;
+
+inline QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t itemSize)
+{
+    QueueHandle_t queue = new StubQueue();
+    queue->length   = length;
+    queue->itemSize = itemSize;
+    queue->items    = new uint8_t[length * itemSize];
+    return queue;
+}
+
+inline BaseType_t xQueueSend(QueueHandle_t queue, const void* item, TickType_t)
+{
+    if (queue->count == queue->length) 
+    {
+        return pdFALSE;
+    }
+    UBaseType_t slot = (queue->head + queue->count++) % queue->length;
+    memcpy(&queue->items[slot * queue->itemSize], item, queue->itemSize);
+    return pdTRUE;
+}
+
+inline BaseType_t xQueueReceive(QueueHandle_t queue, void* item, TickType_t)
+{
+    if (queue->count == 0) 
+    {
+        return pdFALSE;
+    }
+    memcpy(item, &queue->items[queue->head * queue->itemSize], queue->itemSize);
+    queue->head = (queue->head + 1) % queue->length;
+    queue->count--;
+    return pdTRUE;
+}
+
+// Mutexes: nothing runs concurrently, so a count is enough to catch misuse
+typedef int* SemaphoreHandle_t;
+
+inline SemaphoreHandle_t xSemaphoreCreateMutex() { return new int(0); }
+
+inline BaseType_t xSemaphoreTake(SemaphoreHandle_t mutex, TickType_t)
+{
+    return (*mutex)++ == 0 ? pdTRUE : pdFALSE;
+}
+
+inline BaseType_t xSemaphoreGive(SemaphoreHandle_t mutex)
+{
+    return (*mutex)-- == 1 ? pdTRUE : pdFALSE;
+}
+
+inline UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue) { return queue->count; }
+
+inline BaseType_t xTaskCreatePinnedToCore(TaskFunction_t, const char*, uint32_t, void*, UBaseType_t, 
+                                          TaskHandle_t* handle, BaseType_t)
+{
+    if (handle != nullptr) 
+    {
+        *handle = nullptr;
+    }
+    return pdPASS;
+}
+
+inline void vTaskDelay(TickType_t) {}
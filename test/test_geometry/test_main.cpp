@@ -0,0 +1,182 @@
+#include <unity.h>
+#include <stdio.h>
+#include "geometry.h"
+
+//-----------------------------------------------------------------------------
+// Span remap against the per-LED table
+//-----------------------------------------------------------------------------
+// Each example layout from geometry.h is built into its compile-time table,
+// split into spans by LedGeometry::begin() and remapped both ways; every
+// strip LED, gaps included, must come out the same.
+
+#define TEST_LEDS           332
+#define UNTOUCHED           CRGB(1, 2, 3)
+
+constexpr LedRun IDENTITY[]       = { { 0, 332, 0, 0, 1 } };
+constexpr LedRun ROTATED[]        = { { 0, 332, 0, 83, -1 } };
+constexpr LedRun GAP[]            = { { 0, 166, 0, 0, 1 }, { 166, 166, 170, 0, 1 } };
+constexpr LedRun TWO_RINGS[]      = { { 0, 166, 0, 0, 1 }, { 166, 166, 166, 83, -1 } };
+constexpr LedRun OVERLAPPING[]    = { { 0, 200, 0, 0, 1 }, { 200, 132, 150, 0, 1 } };
+constexpr LedRun SHORT_STRIP[]    = { { 0, 300, 0, 0, 1 } };       // Last 32 logical LEDs not shown
+
+// Twenty-one segments in alternating directions, more spans than
+// GEOMETRY_MAX_SPANS
+constexpr LedRun ZIGZAG[] =
+{
+    {   0, 16,   0, 0, 1 }, {  16, 16,  16, 15, -1 }, {  32, 16,  32, 0, 1 }, {  48, 16,  48, 15, -1 },
+    {  64, 16,  64, 0, 1 }, {  80, 16,  80, 15, -1 }, {  96, 16,  96, 0, 1 }, { 112, 16, 112, 15, -1 },
+    { 128, 16, 128, 0, 1 }, { 144, 16, 144, 15, -1 }, { 160, 16, 160, 0, 1 }, { 176, 16, 176, 15, -1 },
+    { 192, 16, 192, 0, 1 }, { 208, 16, 208, 15, -1 }, { 224, 16, 224, 0, 1 }, { 240, 16, 240, 15, -1 },
+    { 256, 16, 256, 0, 1 }, { 272, 16, 272, 15, -1 }, { 288, 16, 288, 0, 1 }, { 304, 16, 304, 15, -1 },
+    { 320, 12, 320, 0, 1 }
+};
+
+#define RUNS(layout) layout, sizeof(layout) / sizeof(layout[0])
+
+typedef GeometryTable<RUNS(IDENTITY), TEST_LEDS>    IdentityGeometry;
+typedef GeometryTable<RUNS(ROTATED), TEST_LEDS>     RotatedGeometry;
+typedef GeometryTable<RUNS(GAP), TEST_LEDS>         GapGeometry;
+typedef GeometryTable<RUNS(TWO_RINGS), TEST_LEDS>   TwoRingGeometry;
+typedef GeometryTable<RUNS(OVERLAPPING), TEST_LEDS> OverlappingGeometry;
+typedef GeometryTable<RUNS(SHORT_STRIP), TEST_LEDS> ShortStripGeometry;
+typedef GeometryTable<RUNS(ZIGZAG), TEST_LEDS>      ZigzagGeometry;
+
+#define MAX_STRIP           (TEST_LEDS + 8)
+
+static CRGB        logical[TEST_LEDS];
+static CRGB        spanStrip[MAX_STRIP + 1];
+static CRGB        tableStrip[MAX_STRIP + 1];
+static LedGeometry geometry;
+
+// Remaps a frame of distinct colours both ways and compares every strip LED
+template<typename Geometry>
+static void checkRemap()
+{
+    const uint16_t* table = Geometry::table();
+    const int strip = Geometry::physicalCount;
+    TEST_ASSERT_TRUE(strip <= MAX_STRIP);
+
+    for (int i = 0; i < TEST_LEDS; i++)
+    {
+        logical[i] = CRGB(i & 0xFF, i >> 8, 0x80 | (i % 7));
+    }
+    fill_solid(spanStrip, MAX_STRIP + 1, UNTOUCHED);
+    fill_solid(tableStrip, MAX_STRIP + 1, UNTOUCHED);
+
+    geometry.begin(table, TEST_LEDS, strip);
+    geometry.remap(logical, spanStrip);
+    for (int i = 0; i < TEST_LEDS; i++)
+    {
+        tableStrip[table[i]] = logical[i];
+    }
+
+    for (int p = 0; p < strip; p++)
+    {
+        if (spanStrip[p] != tableStrip[p])
+        {
+            char message[64];
+            snprintf(message, sizeof(message), "strip LED %d differs from the table remap", p);
+            TEST_FAIL_MESSAGE(message);
+        }
+    }
+
+    // Nothing is written past the discard slot
+    for (int p = strip + 1; p <= MAX_STRIP; p++)
+    {
+        TEST_ASSERT_TRUE(spanStrip[p] == UNTOUCHED);
+    }
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_identity()
+{
+    checkRemap<IdentityGeometry>();
+    TEST_ASSERT_EQUAL(332, IdentityGeometry::physicalCount);
+    TEST_ASSERT_TRUE(spanStrip[0] == logical[0]);
+    TEST_ASSERT_TRUE(spanStrip[331] == logical[331]);
+    TEST_ASSERT_EQUAL(0, geometry.overlaps());
+    TEST_ASSERT_EQUAL(166, geometry.extent(166));
+    TEST_ASSERT_EQUAL(332, geometry.extent(TEST_LEDS));
+}
+
+void test_rotated_and_reversed()
+{
+    checkRemap<RotatedGeometry>();
+
+    // Midnight 83 LEDs in, running back towards the strip start and on
+    // round from its far end
+    TEST_ASSERT_TRUE(spanStrip[83] == logical[0]);
+    TEST_ASSERT_TRUE(spanStrip[82] == logical[1]);
+    TEST_ASSERT_TRUE(spanStrip[0] == logical[83]);
+    TEST_ASSERT_TRUE(spanStrip[331] == logical[84]);
+    TEST_ASSERT_TRUE(spanStrip[84] == logical[331]);
+    TEST_ASSERT_EQUAL(0, geometry.overlaps());
+    TEST_ASSERT_EQUAL(332, geometry.extent(TEST_LEDS));
+}
+
+void test_gap_at_join()
+{
+    checkRemap<GapGeometry>();
+    TEST_ASSERT_EQUAL(336, GapGeometry::physicalCount);
+    for (int p = 166; p < 170; p++)
+    {
+        TEST_ASSERT_TRUE(spanStrip[p] == UNTOUCHED);
+    }
+    TEST_ASSERT_TRUE(spanStrip[165] == logical[165]);
+    TEST_ASSERT_TRUE(spanStrip[170] == logical[166]);
+    TEST_ASSERT_EQUAL(0, geometry.overlaps());
+    TEST_ASSERT_EQUAL(166, geometry.extent(166));
+    TEST_ASSERT_EQUAL(336, geometry.extent(TEST_LEDS));
+}
+
+void test_two_rings_mirrored()
+{
+    checkRemap<TwoRingGeometry>();
+    TEST_ASSERT_TRUE(spanStrip[0] == logical[0]);
+    TEST_ASSERT_TRUE(spanStrip[166 + 83] == logical[166]);
+    TEST_ASSERT_TRUE(spanStrip[166 + 82] == logical[167]);
+    TEST_ASSERT_TRUE(spanStrip[166 + 84] == logical[331]);
+    TEST_ASSERT_EQUAL(0, geometry.overlaps());
+
+    // With only the first dial active, the second ring stays off the strip
+    TEST_ASSERT_EQUAL(166, geometry.extent(166));
+}
+
+void test_unmapped_logical_leds()
+{
+    checkRemap<ShortStripGeometry>();
+    TEST_ASSERT_EQUAL(300, ShortStripGeometry::physicalCount);
+    TEST_ASSERT_TRUE(ShortStripGeometry::table()[300] == 300);
+    TEST_ASSERT_EQUAL(300, geometry.extent(TEST_LEDS));
+}
+
+void test_overlap_is_counted()
+{
+    checkRemap<OverlappingGeometry>();
+    TEST_ASSERT_EQUAL(50, geometry.overlaps());
+    TEST_ASSERT_EQUAL(282, geometry.extent(TEST_LEDS));
+}
+
+void test_too_many_spans_falls_back_to_table()
+{
+    checkRemap<ZigzagGeometry>();
+    TEST_ASSERT_TRUE(spanStrip[16] == logical[31]);
+    TEST_ASSERT_TRUE(spanStrip[31] == logical[16]);
+    TEST_ASSERT_TRUE(spanStrip[331] == logical[331]);
+    TEST_ASSERT_EQUAL(0, geometry.overlaps());
+}
+
+int main(int argc, char** argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_identity);
+    RUN_TEST(test_rotated_and_reversed);
+    RUN_TEST(test_gap_at_join);
+    RUN_TEST(test_two_rings_mirrored);
+    RUN_TEST(test_unmapped_logical_leds);
+    RUN_TEST(test_overlap_is_counted);
+    RUN_TEST(test_too_many_spans_falls_back_to_table);
+    return UNITY_END();
+}
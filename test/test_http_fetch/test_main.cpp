@@ -0,0 +1,262 @@
+#include <unity.h>
+#include <new>
+#include <stdint.h>
+#include <WiFi.h>
+#include "http_fetch.h"
+
+//-----------------------------------------------------------------------------
+// HTTP client (http_fetch.cpp) against scripted servers on the fake clock:
+// every body framing, and slow or stalled servers must not hold a fetch
+// past its deadline
+//-----------------------------------------------------------------------------
+#define TEST_TIMEOUT_MS     1000
+
+// Every heap allocation in the test program is counted
+static size_t allocations = 0;
+
+void* operator new(size_t size)
+{
+    allocations++;
+    void* block = malloc(size ? size : 1);
+    if (block == nullptr) throw std::bad_alloc();
+    return block;
+}
+
+void* operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void* block) noexcept { free(block); }
+void operator delete[](void* block) noexcept { free(block); }
+void operator delete(void* block, size_t) noexcept { free(block); }
+void operator delete[](void* block, size_t) noexcept { free(block); }
+
+static StubPeer   peer;
+static HttpTarget target;
+static char       body[256];
+static size_t     length;
+
+static int fetch(const char* pathAndQuery = "/json?date=2025-06-21")
+{
+    WiFiClient client(&peer);
+    return httpFetch(client, target, pathAndQuery, body, sizeof(body), length, TEST_TIMEOUT_MS);
+}
+
+// Fetch and check it gave up on time
+static void expectTimeout()
+{
+    unsigned long start = millis();
+    TEST_ASSERT_EQUAL(HTTP_FETCH_ERROR_TIMEOUT, fetch());
+    unsigned long elapsed = millis() - start;
+    TEST_ASSERT_TRUE(elapsed >= TEST_TIMEOUT_MS);
+    TEST_ASSERT_TRUE(elapsed <= TEST_TIMEOUT_MS + 5);
+    TEST_ASSERT_FALSE(peer.open);
+}
+
+void setUp()
+{
+    TEST_ASSERT_TRUE(httpParseUrl("http://api.example:8080/json", target));
+}
+
+void tearDown() {}
+
+void test_parse_url()
+{
+    HttpTarget t;
+    TEST_ASSERT_TRUE(httpParseUrl("https://api.sunrise-sunset.org/json", t));
+    TEST_ASSERT_EQUAL_STRING("api.sunrise-sunset.org", t.host);
+    TEST_ASSERT_EQUAL(443, t.port);
+    TEST_ASSERT_TRUE(t.secure);
+    TEST_ASSERT_EQUAL_STRING("/json", t.path);
+
+    TEST_ASSERT_TRUE(httpParseUrl("http://192.168.1.10:8000", t));
+    TEST_ASSERT_EQUAL(8000, t.port);
+    TEST_ASSERT_EQUAL_STRING("/", t.path);
+
+    TEST_ASSERT_FALSE(httpParseUrl("ftp://host/file", t));
+    TEST_ASSERT_FALSE(httpParseUrl("http:///path", t));
+}
+
+void test_content_length_body()
+{
+    stubPeerInit(peer, "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\nContent-Length: 11\r\n\r\n"
+                       "{\"ok\":true}", false);
+    TEST_ASSERT_EQUAL(200, fetch());
+    TEST_ASSERT_EQUAL(11, length);
+    TEST_ASSERT_EQUAL_STRING("{\"ok\":true}", body);
+    TEST_ASSERT_EQUAL_STRING("GET /json?date=2025-06-21 HTTP/1.1\r\nHost: api.example:8080\r\n"
+                             "Connection: keep-alive\r\n\r\n", peer.sent);
+    TEST_ASSERT_TRUE(peer.open);
+}
+
+void test_chunked_body()
+{
+    stubPeerInit(peer, "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n"
+                       "5\r\nhello\r\n1;name=value\r\n \r\nA\r\n0123456789\r\n0\r\nX-Trailer: 1\r\n\r\n", false);
+    TEST_ASSERT_EQUAL(200, fetch());
+    TEST_ASSERT_EQUAL(16, length);
+    TEST_ASSERT_EQUAL_STRING("hello 0123456789", body);
+    TEST_ASSERT_EQUAL(peer.incomingLength, peer.readPos);
+}
+
+void test_body_to_close()
+{
+    stubPeerInit(peer, "HTTP/1.0 503 Service Unavailable\r\n\r\ntry later", true);
+    TEST_ASSERT_EQUAL(503, fetch());
+    TEST_ASSERT_EQUAL_STRING("try later", body);
+    TEST_ASSERT_FALSE(peer.open);
+}
+
+void test_connection_close_header()
+{
+    stubPeerInit(peer, "HTTP/1.1 200 OK\r\nConnection: close\r\nContent-Length: 2\r\n\r\nok", false);
+    TEST_ASSERT_EQUAL(200, fetch());
+    TEST_ASSERT_FALSE(peer.open);
+}
+
+void test_keep_alive_reuses_connection()
+{
+    stubPeerInit(peer, "HTTP/1.1 200 OK\r\nContent-Length: 3\r\n\r\none"
+                       "HTTP/1.1 200 OK\r\nContent-Length: 3\r\n\r\ntwo", false);
+    TEST_ASSERT_EQUAL(200, fetch());
+    TEST_ASSERT_EQUAL_STRING("one", body);
+    TEST_ASSERT_EQUAL(200, fetch("/json?date=2025-06-22"));
+    TEST_ASSERT_EQUAL_STRING("two", body);
+    TEST_ASSERT_EQUAL(1, peer.connects);
+    TEST_ASSERT_NOT_NULL(strstr(peer.sent, "GET /json?date=2025-06-22 "));
+}
+
+void test_errors()
+{
+    stubPeerInit(peer, "");
+    peer.refuse = true;
+    TEST_ASSERT_EQUAL(HTTP_FETCH_ERROR_CONNECT, fetch());
+
+    stubPeerInit(peer, "SSH-2.0-OpenSSH\r\n\r\n", false);
+    TEST_ASSERT_EQUAL(HTTP_FETCH_ERROR_HEADER, fetch());
+    TEST_ASSERT_FALSE(peer.open);
+
+    stubPeerInit(peer, "HTTP/1.1 200 OK\r\nContent-Length: 256\r\n\r\n", false);
+    TEST_ASSERT_EQUAL(HTTP_FETCH_ERROR_TOO_LARGE, fetch());
+
+    stubPeerInit(peer, "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n100\r\n", false);
+    TEST_ASSERT_EQUAL(HTTP_FETCH_ERROR_TOO_LARGE, fetch());
+
+    // Closed part way through a Content-Length body
+    stubPeerInit(peer, "HTTP/1.1 200 OK\r\nContent-Length: 50\r\n\r\nshort", true);
+    TEST_ASSERT_EQUAL(HTTP_FETCH_ERROR_TIMEOUT, fetch());
+}
+
+void test_silent_server_times_out()
+{
+    stubPeerInit(peer, "HTTP/1.1 200 OK\r\n", false);
+    peer.stallAt = 0;
+    expectTimeout();
+}
+
+void test_stall_in_headers_times_out()
+{
+    stubPeerInit(peer, "HTTP/1.1 200 OK\r\nContent-Length: 10\r\n\r\n0123456789", false);
+    peer.stallAt = 20;
+    expectTimeout();
+}
+
+void test_stall_in_body_times_out()
+{
+    stubPeerInit(peer, "HTTP/1.1 200 OK\r\nContent-Length: 10\r\n\r\n0123456789", false);
+    peer.stallAt = peer.incomingLength - 3;
+    expectTimeout();
+
+    stubPeerInit(peer, "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n5\r\nhello\r\n5\r\nwor", false);
+    expectTimeout();
+
+    stubPeerInit(peer, "HTTP/1.1 200 OK\r\n\r\nno length, never closed", false);
+    expectTimeout();
+}
+
+void test_slow_drip_bounded_by_deadline()
+{
+    // Every byte arrives in time for the next, but the whole response does not
+    stubPeerInit(peer, "HTTP/1.1 200 OK\r\nContent-Length: 60\r\n\r\n"
+                       "012345678901234567890123456789012345678901234567890123456789", false);
+    peer.msPerByte = 12;
+    expectTimeout();
+
+    // The same drip a little faster finishes inside the deadline
+    stubPeerInit(peer, "HTTP/1.1 200 OK\r\nContent-Length: 60\r\n\r\n"
+                       "012345678901234567890123456789012345678901234567890123456789", false);
+    peer.msPerByte = 9;
+    TEST_ASSERT_EQUAL(200, fetch());
+    TEST_ASSERT_EQUAL(60, length);
+}
+
+void test_huge_chunk_size_is_rejected()
+{
+    // A size that wraps length + chunk past zero must not get through
+    static char response[160];
+    snprintf(response, sizeof(response), "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n"
+             "5\r\nhello\r\n%zx\r\nxx", SIZE_MAX - 2);
+    stubPeerInit(peer, response, false);
+    TEST_ASSERT_EQUAL(HTTP_FETCH_ERROR_TOO_LARGE, fetch());
+
+    stubPeerInit(peer, "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\nffffffff\r\nxx", false);
+    TEST_ASSERT_EQUAL(HTTP_FETCH_ERROR_TOO_LARGE, fetch());
+
+    // The largest chunk that fits still leaves room for the terminator
+    stubPeerInit(peer, "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n100\r\n", false);
+    TEST_ASSERT_EQUAL(HTTP_FETCH_ERROR_TOO_LARGE, fetch());
+    stubPeerInit(peer, "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\nfa\r\n", false);
+    peer.stallAt = peer.incomingLength;
+    TEST_ASSERT_EQUAL(HTTP_FETCH_ERROR_TIMEOUT, fetch());
+}
+
+void test_fetches_never_allocate()
+{
+    static const char RESPONSES[] = 
+        "HTTP/1.1 200 OK\r\nContent-Length: 11\r\n\r\n{\"ok\":true}"
+        "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n5\r\nhello\r\n0\r\n\r\n"
+        "HTTP/1.1 404 Not Found\r\nContent-Length: 3\r\n\r\nnop";
+    static const int EXPECTED[] = { 200, 200, 404 };
+
+    allocations = 0;
+    for (int pass = 0; pass < 200; pass++) 
+    {
+        stubPeerInit(peer, RESPONSES, false);
+        for (int status : EXPECTED) 
+        {
+            TEST_ASSERT_EQUAL(status, fetch());
+        }
+
+        // Error paths too
+        stubPeerInit(peer, "HTTP/1.1 200 OK\r\nContent-Length: 9999\r\n\r\n", false);
+        TEST_ASSERT_EQUAL(HTTP_FETCH_ERROR_TOO_LARGE, fetch());
+        stubPeerInit(peer, "HTTP/1.1 200 OK\r\n", false);
+        peer.stallAt = 4;
+        TEST_ASSERT_EQUAL(HTTP_FETCH_ERROR_TIMEOUT, fetch());
+    }
+    TEST_ASSERT_EQUAL(0, allocations);
+
+    // The counter does see allocations
+    delete new int(1);
+    TEST_ASSERT_EQUAL(1, allocations);
+}
+
+int main(int argc, char** argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_parse_url);
+    RUN_TEST(test_content_length_body);
+    RUN_TEST(test_chunked_body);
+    RUN_TEST(test_body_to_close);
+    RUN_TEST(test_connection_close_header);
+    RUN_TEST(test_keep_alive_reuses_connection);
+    RUN_TEST(test_errors);
+    RUN_TEST(test_silent_server_times_out);
+    RUN_TEST(test_stall_in_headers_times_out);
+    RUN_TEST(test_stall_in_body_times_out);
+    RUN_TEST(test_slow_drip_bounded_by_deadline);
+    RUN_TEST(test_huge_chunk_size_is_rejected);
+    RUN_TEST(test_fetches_never_allocate);
+    return UNITY_END();
+}
@@ -0,0 +1,290 @@
+#include <unity.h>
+#include <chrono>
+#include <stdio.h>
+#include "layers.h"
+
+//-----------------------------------------------------------------------------
+// The clock layer pipeline against the same layers behind virtual calls
+//-----------------------------------------------------------------------------
+// Every dial below is drawn by ClockLayers and by a virtual stack of the
+// same layers in the same order; the frames must match LED for LED. The
+// virtual stack mirrors the one layerBenchmark() times on the board.
+
+#define TEST_LEDS           332
+#define BENCH_FRAMES        2000
+
+static CRGB       staticLeds[TEST_LEDS];
+static CRGB       virtualLeds[TEST_LEDS];
+static Compositor staticFrame(staticLeds, TEST_LEDS);
+static Compositor virtualFrame(virtualLeds, TEST_LEDS);
+
+struct VirtualLayer
+{
+    virtual ~VirtualLayer() {}
+    virtual void begin(const DialContext& dial) = 0;
+    virtual void shade(const DialContext& dial, int i, CRGB& color) = 0;
+};
+
+template<typename T>
+struct VirtualAdapter : VirtualLayer
+{
+    T layer;
+
+    void begin(const DialContext& dial) override { layer.begin(dial); }
+    void shade(const DialContext& dial, int i, CRGB& color) override { layer.apply(dial, i, color); }
+};
+
+struct VirtualClock
+{
+    VirtualAdapter<DaylightLayer>     daylight;
+    VirtualAdapter<TwilightLayer>     twilight;
+    VirtualAdapter<DaylightFadeLayer> fade;
+    VirtualAdapter<CountdownLayer>    countdown;
+    VirtualAdapter<HourTickLayer>     ticks;
+    VirtualAdapter<SolsticeLayer>     solstices;
+    VirtualAdapter<SunLayer>          sun;
+    VirtualAdapter<SunPulseLayer>     pulse;
+    VirtualAdapter<ChimeLayer>        chime;
+
+    void render(Compositor& frame, const DialContext& dial)
+    {
+        // Behind a volatile pointer so the calls cannot be devirtualised
+        VirtualLayer* layers[] = { &daylight, &twilight, &fade, &countdown, &ticks, &solstices, &sun, &pulse, &chime };
+        VirtualLayer* const* volatile table = layers;
+        const int count = sizeof(layers) / sizeof(layers[0]);
+
+        for (int n = 0; n < count; n++)
+        {
+            table[n]->begin(dial);
+        }
+        for (int i = 0; i < dial.count; i++)
+        {
+            CRGB color = CRGB::Black;
+            for (int n = 0; n < count; n++)
+            {
+                table[n]->shade(dial, i, color);
+            }
+            frame.set(dial.first + i, color);
+        }
+    }
+};
+
+static int ledAt(const DialContext& dial, int hours, int minutes)
+{
+    return (hours * 3600 + minutes * 60) / dial.secondsPerLed;
+}
+
+// A June day in the northern hemisphere, as layerBenchmark() draws it
+static DialContext summerDay()
+{
+    DialContext dial;
+    dial.first           = 0;
+    dial.count           = TEST_LEDS;
+    dial.secondsPerLed   = (24*60*60) / TEST_LEDS;
+    dial.sunLED          = ledAt(dial, 13, 0);
+    dial.sunriseLED      = ledAt(dial, 4, 0);
+    dial.sunsetLED       = ledAt(dial, 20, 0);
+    dial.solarNoonLED    = ledAt(dial, 12, 0);
+    dial.twilightLEDs    = (35 * 60) / dial.secondsPerLed;
+    dial.showSolstices   = true;
+    dial.solsticeLEDs[0] = ledAt(dial, 8, 0);
+    dial.solsticeLEDs[1] = ledAt(dial, 16, 0);
+    dial.solsticeLEDs[2] = ledAt(dial, 3, 30);
+    dial.solsticeLEDs[3] = ledAt(dial, 21, 0);
+    dial.animate         = false;
+    dial.nextEventLED    = dial.sunsetLED;
+    return dial;
+}
+
+// Daylight wrapping past midnight UTC, as far east or west of Greenwich
+static DialContext wrappedDay()
+{
+    DialContext dial = summerDay();
+    dial.sunriseLED    = ledAt(dial, 19, 10);
+    dial.sunsetLED     = ledAt(dial, 7, 40);
+    dial.solarNoonLED  = ledAt(dial, 1, 25);
+    dial.sunLED        = ledAt(dial, 23, 50);
+    dial.nextEventLED  = -1;
+    dial.showSolstices = false;
+    return dial;
+}
+
+// The second of two dials sharing the strip
+static DialContext secondDial()
+{
+    DialContext dial = summerDay();
+    dial.first         = TEST_LEDS / 2;
+    dial.count         = TEST_LEDS / 2;
+    dial.secondsPerLed = (24*60*60) / dial.count;
+    dial.sunLED        = ledAt(dial, 9, 15);
+    dial.sunriseLED    = ledAt(dial, 7, 0);
+    dial.sunsetLED     = ledAt(dial, 17, 0);
+    dial.solarNoonLED  = ledAt(dial, 12, 0);
+    dial.twilightLEDs  = 2;
+    dial.showSolstices = false;
+    dial.nextEventLED  = dial.solarNoonLED;
+    return dial;
+}
+
+// Every animation here starts at 0 ms, and all are over within a minute
+static void settleAnimations()
+{
+    animUpdate(60000);
+}
+
+static void checkSameFrame(const DialContext& dial, ClockLayers& pipeline, VirtualClock& virtualClock)
+{
+    staticFrame.clear();
+    virtualFrame.clear();
+    pipeline.render(staticFrame, dial);
+    virtualClock.render(virtualFrame, dial);
+
+    for (int i = 0; i < TEST_LEDS; i++)
+    {
+        if (staticLeds[i] != virtualLeds[i])
+        {
+            char message[96];
+            snprintf(message, sizeof(message), "LED %d: static %u,%u,%u virtual %u,%u,%u", i,
+                     staticLeds[i].r, staticLeds[i].g, staticLeds[i].b,
+                     virtualLeds[i].r, virtualLeds[i].g, virtualLeds[i].b);
+            TEST_FAIL_MESSAGE(message);
+        }
+    }
+    TEST_ASSERT_EQUAL_UINT32(virtualFrame.estimate(255).totalMa(), staticFrame.estimate(255).totalMa());
+}
+
+static void checkSameFrame(const DialContext& dial)
+{
+    ClockLayers  pipeline;
+    VirtualClock virtualClock;
+    checkSameFrame(dial, pipeline, virtualClock);
+}
+
+void setUp()
+{
+    settleAnimations();
+}
+
+void tearDown() {}
+
+void test_summer_day_colors()
+{
+    DialContext dial = summerDay();
+    ClockLayers pipeline;
+    staticFrame.clear();
+    pipeline.render(staticFrame, dial);
+
+    // Back to front: ticks over daylight, the sun over its tick, noon left dark
+    TEST_ASSERT_TRUE(staticLeds[dial.solarNoonLED] == CRGB(CRGB::Black));
+    TEST_ASSERT_TRUE(staticLeds[dial.sunLED] == CRGB(255, 255, 0));
+    TEST_ASSERT_TRUE(staticLeds[ledAt(dial, 10, 0)] == CRGB(32, 0, 0));
+    TEST_ASSERT_TRUE(staticLeds[ledAt(dial, 16, 0)] == CRGB(0, 255, 0));
+    TEST_ASSERT_TRUE(staticLeds[ledAt(dial, 11, 30)] == CRGB(0, 0, 8));
+
+    // The countdown trail adds to the daylight ahead of the sun only
+    TEST_ASSERT_TRUE(staticLeds[dial.sunLED + 3] == CRGB(4, 3, 8));
+    TEST_ASSERT_TRUE(staticLeds[dial.sunLED - 3] == CRGB(0, 0, 8));
+
+    // Twilight fades from the night colour at its far edge
+    TEST_ASSERT_TRUE(staticLeds[dial.sunriseLED - dial.twilightLEDs] == CRGB(12, 2, 6));
+    TEST_ASSERT_TRUE(staticLeds[ledAt(dial, 1, 30)] == CRGB(CRGB::Black));
+}
+
+void test_static_matches_virtual()
+{
+    checkSameFrame(summerDay());
+    checkSameFrame(wrappedDay());
+    checkSameFrame(secondDial());
+
+    DialContext polar = summerDay();
+    polar.twilightLEDs = 0;
+    polar.sunriseLED   = 0;
+    polar.sunsetLED    = TEST_LEDS - 1;
+    checkSameFrame(polar);
+}
+
+void test_static_matches_virtual_while_animating()
+{
+    DialContext dial = summerDay();
+    dial.animate = true;
+
+    // Sunrise, then sunset, sampled across the transitions
+    for (int direction = 1; direction >= -1; direction -= 2)
+    {
+        animStart(ANIM_DAYLIGHT, 0, direction);
+        animStart(ANIM_SUN_PULSE, 0);
+        animStart(ANIM_CHIME, 0);
+        for (uint32_t ms = 0; ms <= 3000; ms += 125)
+        {
+            animUpdate(ms);
+            checkSameFrame(dial);
+        }
+        settleAnimations();
+    }
+}
+
+void test_static_matches_virtual_with_layers_off()
+{
+    DialContext  dial = summerDay();
+    ClockLayers  pipeline;
+    VirtualClock virtualClock;
+
+    pipeline.layer<HourTickLayer>().enabled = false;
+    pipeline.layer<SunLayer>().enabled      = false;
+    pipeline.layer<TwilightLayer>().dayColor = CRGB(0, 8, 8);
+    virtualClock.ticks.layer.enabled        = false;
+    virtualClock.sun.layer.enabled          = false;
+    virtualClock.twilight.layer.dayColor    = CRGB(0, 8, 8);
+    checkSameFrame(dial, pipeline, virtualClock);
+
+    TEST_ASSERT_TRUE(staticLeds[ledAt(dial, 10, 0)] == CRGB(0, 0, 8));
+    TEST_ASSERT_TRUE(staticLeds[dial.sunLED] == CRGB(0, 0, 8));
+}
+
+//-----------------------------------------------------------------------------
+// Benchmark
+//-----------------------------------------------------------------------------
+template<typename Render>
+static double usPerFrame(Render render)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (int f = 0; f < BENCH_FRAMES; f++)
+    {
+        render();
+    }
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / BENCH_FRAMES;
+}
+
+void test_render_cost()
+{
+    DialContext  dial = summerDay();
+    ClockLayers  pipeline;
+    VirtualClock virtualClock;
+    dial.animate = true;
+    animStart(ANIM_CHIME, 0);
+    animUpdate(700);
+
+    double staticUs  = usPerFrame([&]() { pipeline.render(staticFrame, dial); });
+    double virtualUs = usPerFrame([&]() { virtualClock.render(virtualFrame, dial); });
+
+    char message[128];
+    snprintf(message, sizeof(message), "%d LEDs x 9 layers: static %.2f us, virtual %.2f us per frame, %.2fx",
+             TEST_LEDS, staticUs, virtualUs, virtualUs / staticUs);
+    TEST_MESSAGE(message);
+
+    // The speed-up depends on the build's optimisation, so only the
+    // outputs are held to account here; "layerbench" times it on the board
+    TEST_ASSERT_TRUE(staticLeds[0] == virtualLeds[0]);
+    TEST_ASSERT_EQUAL_UINT32(virtualFrame.estimate(255).totalMa(), staticFrame.estimate(255).totalMa());
+}
+
+int main(int argc, char** argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_summer_day_colors);
+    RUN_TEST(test_static_matches_virtual);
+    RUN_TEST(test_static_matches_virtual_while_animating);
+    RUN_TEST(test_static_matches_virtual_with_layers_off);
+    RUN_TEST(test_render_cost);
+    return UNITY_END();
+}
@@ -0,0 +1,161 @@
+#include <unity.h>
+#include <chrono>
+#include <thread>
+#include <stdio.h>
+#include "log.h"
+
+//-----------------------------------------------------------------------------
+// Deferred logging (log.cpp): formatting from captured arguments must match
+// printf, a full queue drops and counts from any number of tasks, and
+// statement cost on the host
+//-----------------------------------------------------------------------------
+
+// Format through the capture path and through snprintf; both must agree
+template<typename... Args>
+static void checkFormat(const char* format, Args... args)
+{
+    const LogArg captured[] = { logArg(args)... };
+    char expected[160];
+    char actual[160];
+    snprintf(expected, sizeof(expected), format, args...);
+    size_t length = logFormat(actual, sizeof(actual), format, captured, sizeof...(Args));
+    TEST_ASSERT_EQUAL_STRING(expected, actual);
+    TEST_ASSERT_EQUAL(strlen(expected), length);
+}
+
+void setUp()
+{
+    logBegin();
+}
+
+void tearDown() {}
+
+void test_format_matches_printf()
+{
+    checkFormat("WiFi connected, RSSI %d dBm", -67);
+    checkFormat("%02d:%02d:%02d", 7, 5, 0);
+    checkFormat("heap %lu, largest %u, %ld", 123456UL, 4096U, -12L);
+    checkFormat("%lld us, %llu total", -9000000000LL, 18000000000ULL);
+    checkFormat("offset %.3f s, drift %+.1f ppm, %e", 0.125, -12.75, 6.02e23);
+    checkFormat("%-10s|%10s|%s", "left", "right", "plain");
+    checkFormat("%x %X %08x %o %c", 0xBEEFU, 0xCAFEU, 0x2AU, 8U, 'Z');
+    checkFormat("100%% done, %d%%", 5);
+    checkFormat("%5.1f%% of %s", 99.25, "budget");
+}
+
+void test_format_without_arguments()
+{
+    char out[32];
+    TEST_ASSERT_EQUAL(12, logFormat(out, sizeof(out), "no arguments", nullptr, 0));
+    TEST_ASSERT_EQUAL_STRING("no arguments", out);
+
+    // Missing arguments leave their conversion out rather than reading garbage
+    TEST_ASSERT_EQUAL(4, logFormat(out, sizeof(out), "a %d b", nullptr, 0));
+    TEST_ASSERT_EQUAL_STRING("a  b", out);
+}
+
+void test_format_null_string()
+{
+    const LogArg captured[] = { logArg((const char*)nullptr) };
+    char out[32];
+    logFormat(out, sizeof(out), "name %s", captured, 1);
+    TEST_ASSERT_EQUAL_STRING("name (null)", out);
+}
+
+void test_format_truncates()
+{
+    const LogArg captured[] = { logArg("a long argument string"), logArg(12345) };
+    char out[16];
+    size_t length = logFormat(out, sizeof(out), "x %s %d tail", captured, 2);
+    TEST_ASSERT_EQUAL(15, length);
+    TEST_ASSERT_EQUAL_STRING("x a long argume", out);
+
+    TEST_ASSERT_EQUAL(0, logFormat(out, 1, "anything", nullptr, 0));
+    TEST_ASSERT_EQUAL_STRING("", out);
+}
+
+void test_full_queue_drops_and_counts()
+{
+    // No writer task runs on the host, so the queue fills after its depth
+    uint32_t before = logDropped();
+    for (int i = 0; i < 40; i++) 
+    {
+        LOG_INFO(LOG_SYSTEM, "record %d", i);
+    }
+    TEST_ASSERT_EQUAL_UINT32(before + 8, logDropped());
+}
+
+void test_drops_from_many_tasks_are_all_counted()
+{
+    // The first 32 records fill the fresh queue; every drop after that must
+    // count, whichever task it came from
+    const int tasks = 4;
+    const int perTask = 50000;
+    uint32_t before = logDropped();
+
+    std::thread threads[tasks];
+    for (int t = 0; t < tasks; t++) 
+    {
+        threads[t] = std::thread([]() {
+            for (int i = 0; i < perTask; i++) 
+            {
+                LOG_WARN(LOG_NET, "dropped %d", i);
+            }
+        });
+    }
+    for (int t = 0; t < tasks; t++) 
+    {
+        threads[t].join();
+    }
+    TEST_ASSERT_EQUAL_UINT32(before + tasks * perTask - 32, logDropped());
+}
+
+void test_disabled_categories_are_free()
+{
+    const int disabledCount = 100000;
+    const int enabledCount = 32;
+    volatile int value = 42;
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < disabledCount; i++) 
+    {
+        LOG_AT(LOG_LEVEL_ERROR, 0, "disabled %d %d", i, value);
+    }
+    double disabledNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() 
+                        / disabledCount;
+
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < enabledCount; i++) 
+    {
+        LOG_INFO(LOG_RENDER, "benchmark %d of %d", i, (int)value);
+    }
+    double enabledNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() 
+                       / enabledCount;
+
+    char message[96];
+    snprintf(message, sizeof(message), "disabled %.2f ns, enabled %.1f ns per statement", disabledNs, enabledNs);
+    TEST_MESSAGE(message);
+
+    // A disabled statement must not capture or queue anything
+    uint32_t before = logDropped();
+    logBegin();
+    for (int i = 0; i < 64; i++) 
+    {
+        LOG_AT(LOG_LEVEL_ERROR, 0, "disabled %d", i);
+    }
+    TEST_ASSERT_EQUAL_UINT32(before, logDropped());
+    TEST_ASSERT_TRUE(disabledNs < enabledNs);
+}
+
+int main(int argc, char** argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_format_matches_printf);
+    RUN_TEST(test_format_without_arguments);
+    RUN_TEST(test_format_null_string);
+    RUN_TEST(test_format_truncates);
+    RUN_TEST(test_full_queue_drops_and_counts);
+    RUN_TEST(test_drops_from_many_tasks_are_all_counted);
+    RUN_TEST(test_disabled_categories_are_free);
+    return UNITY_END();
+}
@@ -0,0 +1,233 @@
+#include <unity.h>
+#include <chrono>
+#include <math.h>
+#include <stdio.h>
+#include "oklab.h"
+
+//-----------------------------------------------------------------------------
+// OKLab conversion accuracy
+//-----------------------------------------------------------------------------
+// oklabFromRgb() against the same transform with the library cube root in
+// double precision, over a grid through the whole RGB cube, plus round
+// trips, Ottosson's published values and the gradient ends.
+
+#define GRID_STEP           5           // Every 5th value per channel, 52^3 colours
+#define MAX_LAB_ERROR       2e-4f
+#define BENCH_LEDS          332
+#define BENCH_RUNS          2000
+
+static OkLab oklabExact(const CRGB& color)
+{
+    double r = color.r / 255.0, g = color.g / 255.0, b = color.b / 255.0;
+    double l = cbrt(0.4122214708 * r + 0.5363325363 * g + 0.0514459929 * b);
+    double m = cbrt(0.2119034982 * r + 0.6806995451 * g + 0.1073969566 * b);
+    double s = cbrt(0.0883024619 * r + 0.2817188376 * g + 0.6299787005 * b);
+
+    OkLab lab;
+    lab.L = (float)(0.2104542553 * l + 0.7936177850 * m - 0.0040720468 * s);
+    lab.a = (float)(1.9779984951 * l - 2.4285922050 * m + 0.4505937099 * s);
+    lab.b = (float)(0.0259040371 * l + 0.7827717662 * m - 0.8086757660 * s);
+    return lab;
+}
+
+static float labDistance(const OkLab& x, const OkLab& y)
+{
+    return fmaxf(fabsf(x.L - y.L), fmaxf(fabsf(x.a - y.a), fabsf(x.b - y.b)));
+}
+
+static int channelDistance(const CRGB& x, const CRGB& y)
+{
+    int worst = 0;
+    for (int ch = 0; ch < 3; ch++)
+    {
+        worst = max(worst, abs((int)x[ch] - (int)y[ch]));
+    }
+    return worst;
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_table_cube_root_accuracy()
+{
+    float worst = 0.0f;
+    CRGB  worstColor(0, 0, 0);
+    for (int r = 0; r < 256; r += GRID_STEP)
+    {
+        for (int g = 0; g < 256; g += GRID_STEP)
+        {
+            for (int b = 0; b < 256; b += GRID_STEP)
+            {
+                CRGB c(r, g, b);
+                float error = labDistance(oklabFromRgb(c), oklabExact(c));
+                if (error > worst)
+                {
+                    worst      = error;
+                    worstColor = c;
+                }
+            }
+        }
+    }
+
+    // The dim end matters most: the clock's colours are mostly below 32
+    for (int v = 1; v < 32; v++)
+    {
+        const CRGB samples[] = { CRGB(v, v, v), CRGB(v, 0, 0), CRGB(0, v, 0), CRGB(0, 0, v), CRGB(v, v / 4, v / 2) };
+        for (const CRGB& c : samples)
+        {
+            worst = fmaxf(worst, labDistance(oklabFromRgb(c), oklabExact(c)));
+        }
+    }
+
+    char message[96];
+    snprintf(message, sizeof(message), "max OKLab error %.6f (at %u,%u,%u)", worst, worstColor.r, worstColor.g, worstColor.b);
+    TEST_MESSAGE(message);
+    TEST_ASSERT_TRUE(worst < MAX_LAB_ERROR);
+}
+
+void test_reference_values()
+{
+    // Ottosson's table for linear sRGB primaries and white
+    OkLab white = oklabFromRgb(CRGB(255, 255, 255));
+    TEST_ASSERT_FLOAT_WITHIN(2e-4, 1.0, white.L);
+    TEST_ASSERT_FLOAT_WITHIN(2e-4, 0.0, white.a);
+    TEST_ASSERT_FLOAT_WITHIN(2e-4, 0.0, white.b);
+
+    OkLab red = oklabFromRgb(CRGB(255, 0, 0));
+    TEST_ASSERT_FLOAT_WITHIN(2e-4, 0.62795536, red.L);
+    TEST_ASSERT_FLOAT_WITHIN(2e-4, 0.22486306, red.a);
+    TEST_ASSERT_FLOAT_WITHIN(2e-4, 0.12584630, red.b);
+
+    OkLab blue = oklabFromRgb(CRGB(0, 0, 255));
+    TEST_ASSERT_FLOAT_WITHIN(2e-4, 0.45201372, blue.L);
+    TEST_ASSERT_FLOAT_WITHIN(2e-4, -0.03245698, blue.a);
+    TEST_ASSERT_FLOAT_WITHIN(2e-4, -0.31152815, blue.b);
+
+    OkLab black = oklabFromRgb(CRGB(0, 0, 0));
+    TEST_ASSERT_TRUE(black.L == 0.0f && black.a == 0.0f && black.b == 0.0f);
+}
+
+void test_round_trip()
+{
+    int worst = 0;
+    int off   = 0;
+    for (int r = 0; r < 256; r += GRID_STEP)
+    {
+        for (int g = 0; g < 256; g += GRID_STEP)
+        {
+            for (int b = 0; b < 256; b += GRID_STEP)
+            {
+                CRGB c(r, g, b);
+                int d = channelDistance(oklabToRgb(oklabFromRgb(c)), c);
+                worst = max(worst, d);
+                off  += d != 0;
+            }
+        }
+    }
+
+    // Every colour the clock draws comes back unchanged
+    const CRGB palette[] = { CRGB(0, 0, 8), CRGB(12, 2, 6), CRGB(4, 3, 0), CRGB(32, 0, 0), CRGB(0, 255, 0),
+                             CRGB(255, 255, 0), CRGB(96, 48, 0) };
+    for (const CRGB& c : palette)
+    {
+        TEST_ASSERT_TRUE(oklabToRgb(oklabFromRgb(c)) == c);
+    }
+
+    char message[96];
+    snprintf(message, sizeof(message), "round trip: %d of %d colours changed, by at most %d", off, 52 * 52 * 52, worst);
+    TEST_MESSAGE(message);
+    TEST_ASSERT_EQUAL(0, worst);
+}
+
+void test_gradient()
+{
+    CRGB ramp[17];
+    const CRGB night(12, 2, 6), day(0, 0, 8);
+
+    oklabGradient(ramp, 17, night, day);
+    TEST_ASSERT_TRUE(ramp[0] == night);
+    TEST_ASSERT_TRUE(ramp[16] == day);
+
+    // Equal steps in lightness, unlike an RGB blend; bright ends, so 8-bit
+    // rounding stays small against the steps
+    const CRGB amber(255, 96, 0), sky(0, 64, 255);
+    oklabGradient(ramp, 17, amber, sky);
+    float first = oklabExact(amber).L, last = oklabExact(sky).L;
+    for (int i = 1; i < 16; i++)
+    {
+        TEST_ASSERT_FLOAT_WITHIN(0.01, first + (last - first) * i / 16, oklabExact(ramp[i]).L);
+    }
+
+    // A blend lands halfway in lightness between its ends
+    const CRGB red(255, 0, 0), blue(0, 0, 255);
+    float halfway = (oklabExact(red).L + oklabExact(blue).L) / 2;
+    TEST_ASSERT_FLOAT_WITHIN(0.005, halfway, oklabExact(oklabBlend(red, blue, 128)).L);
+
+    TEST_ASSERT_TRUE(oklabBlend(night, day, 0) == night);
+    TEST_ASSERT_TRUE(oklabBlend(night, day, 255) == day);
+
+    // Degenerate lengths
+    CRGB one[1] = { CRGB(1, 2, 3) };
+    oklabGradient(one, 1, night, day);
+    TEST_ASSERT_TRUE(one[0] == night);
+    oklabGradient(one, 0, day, day);
+    TEST_ASSERT_TRUE(one[0] == night);
+}
+
+//-----------------------------------------------------------------------------
+// Benchmark
+//-----------------------------------------------------------------------------
+template<typename Run>
+static double usPerRun(Run run)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (int n = 0; n < BENCH_RUNS; n++)
+    {
+        run();
+    }
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / BENCH_RUNS;
+}
+
+void test_gradient_cost()
+{
+    static CRGB strip[BENCH_LEDS];
+    const CRGB night(12, 2, 6), day(0, 0, 8);
+    volatile float sink = 0;
+
+    double gradient = usPerRun([&]() { oklabGradient(strip, BENCH_LEDS, night, day); });
+    double rgb = usPerRun([&]() {
+        for (int i = 0; i < BENCH_LEDS; i++)
+        {
+            strip[i] = blend(night, day, (uint8_t)(i * 255 / (BENCH_LEDS - 1)));
+        }
+    });
+    double table = usPerRun([&]() {
+        for (int i = 0; i < BENCH_LEDS; i++)
+        {
+            sink = sink + oklabFromRgb(CRGB(i & 255, i / 2, 255 - (i & 255))).L;
+        }
+    });
+    double exact = usPerRun([&]() {
+        for (int i = 0; i < BENCH_LEDS; i++)
+        {
+            sink = sink + oklabExact(CRGB(i & 255, i / 2, 255 - (i & 255))).L;
+        }
+    });
+
+    char message[160];
+    snprintf(message, sizeof(message), "%d LEDs: OKLab gradient %.2f us, RGB blend %.2f us; "
+             "%d conversions: table %.2f us, cbrt %.2f us", BENCH_LEDS, gradient, rgb, BENCH_LEDS, table, exact);
+    TEST_MESSAGE(message);
+    TEST_ASSERT_TRUE(strip[BENCH_LEDS - 1] == day);
+}
+
+int main(int argc, char** argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_table_cube_root_accuracy);
+    RUN_TEST(test_reference_values);
+    RUN_TEST(test_round_trip);
+    RUN_TEST(test_gradient);
+    RUN_TEST(test_gradient_cost);
+    return UNITY_END();
+}
@@ -0,0 +1,206 @@
+#include <unity.h>
+#include <stdio.h>
+#include "compositor.h"
+#include "power_limiter.h"
+
+//-----------------------------------------------------------------------------
+// A simulated year of frames through the compositor and power limiter
+//-----------------------------------------------------------------------------
+// One frame per minute: mostly a clock-like dial, with all-white frames,
+// full random frames and dark spells mixed in. Every frame is rescanned
+// from scratch and its current at the chosen brightness must stay within
+// the budget.
+
+#define TEST_LEDS           332
+#define TEST_BUDGET_MA      2000
+#define TEST_RAMP_STEP      4
+#define MINUTES_PER_YEAR    (365 * 24 * 60)
+
+static CRGB        leds[TEST_LEDS];
+static Compositor  frame(leds, TEST_LEDS);
+static uint32_t    seed;
+
+static uint32_t nextRandom()
+{
+    seed = seed * 1664525UL + 1013904223UL;
+    return seed >> 8;
+}
+
+static uint32_t estimateMa(uint8_t brightness)
+{
+    return frame.estimate(brightness).totalMa();
+}
+
+// Exact current of the buffer at a brightness, from the pixels alone
+static double rescanMa(uint8_t brightness)
+{
+    double ma = 0;
+    for (int i = 0; i < TEST_LEDS; i++) 
+    {
+        ma += (leds[i].r * LED_RED_MA + leds[i].g * LED_GREEN_MA + leds[i].b * LED_BLUE_MA) 
+              * (double)brightness / (255.0 * 255.0);
+        ma += LED_IDLE_MA;
+    }
+    return ma;
+}
+
+// Channel sums of the buffer, for checking the compositor's running sums
+static CurrentEstimate rescanEstimate(uint8_t brightness)
+{
+    uint32_t sums[3] = { 0, 0, 0 };
+    for (int i = 0; i < TEST_LEDS; i++) 
+    {
+        sums[0] += leds[i].r;
+        sums[1] += leds[i].g;
+        sums[2] += leds[i].b;
+    }
+    const uint32_t fullScale = 255UL * 255UL;
+    CurrentEstimate e;
+    e.redMa   = (sums[0] * brightness * LED_RED_MA   + fullScale - 1) / fullScale;
+    e.greenMa = (sums[1] * brightness * LED_GREEN_MA + fullScale - 1) / fullScale;
+    e.blueMa  = (sums[2] * brightness * LED_BLUE_MA  + fullScale - 1) / fullScale;
+    e.idleMa  = TEST_LEDS * LED_IDLE_MA;
+    return e;
+}
+
+static void drawFrame(uint32_t minute)
+{
+    uint32_t kind = nextRandom() % 100;
+    if (kind < 2) 
+    {
+        for (int i = 0; i < TEST_LEDS; i++) 
+        {
+            frame.set(i, CRGB::White);
+        }
+    }
+    else if (kind < 5) 
+    {
+        for (int i = 0; i < TEST_LEDS; i++) 
+        {
+            frame.set(i, CRGB(nextRandom()));
+        }
+    }
+    else if (kind < 8) 
+    {
+        frame.clear();
+    }
+    else 
+    {
+        // Daylight arc that drifts through the day, plus a few changed pixels
+        int dayStart = (minute / 4) % TEST_LEDS;
+        int dayLength = 80 + (minute / 1440) % 120;
+        for (int i = 0; i < TEST_LEDS; i++) 
+        {
+            bool day = (i - dayStart + TEST_LEDS) % TEST_LEDS < dayLength;
+            frame.set(i, day ? CRGB(255, 160, 20) : CRGB(0, 0, 30));
+        }
+        for (int n = nextRandom() % 8; n > 0; n--) 
+        {
+            frame.set(nextRandom() % TEST_LEDS, CRGB(nextRandom()));
+        }
+    }
+}
+
+static void runYear(uint8_t maxBrightness)
+{
+    PowerLimiter limiter(TEST_BUDGET_MA, maxBrightness, TEST_RAMP_STEP);
+    seed = maxBrightness;
+    frame.clear();
+
+    double worstMa = 0;
+    for (uint32_t minute = 0; minute < MINUTES_PER_YEAR; minute++) 
+    {
+        drawFrame(minute);
+        uint8_t brightness = limiter.update(estimateMa);
+        TEST_ASSERT_TRUE(brightness <= maxBrightness);
+
+        double ma = rescanMa(brightness);
+        if (ma > worstMa) 
+        {
+            worstMa = ma;
+        }
+        if (ma > TEST_BUDGET_MA) 
+        {
+            char message[96];
+            snprintf(message, sizeof(message), "minute %lu: %.1f mA at brightness %u", 
+                     (unsigned long)minute, ma, brightness);
+            TEST_FAIL_MESSAGE(message);
+        }
+
+        if (minute % 97 == 0) 
+        {
+            CurrentEstimate running = frame.estimate(brightness);
+            CurrentEstimate rescanned = rescanEstimate(brightness);
+            TEST_ASSERT_EQUAL_UINT32(rescanned.redMa, running.redMa);
+            TEST_ASSERT_EQUAL_UINT32(rescanned.greenMa, running.greenMa);
+            TEST_ASSERT_EQUAL_UINT32(rescanned.blueMa, running.blueMa);
+        }
+    }
+
+    char message[96];
+    snprintf(message, sizeof(message), "max brightness %u: worst %.1f mA of %d, limited %lu times", 
+             maxBrightness, worstMa, TEST_BUDGET_MA, (unsigned long)limiter.activations());
+    TEST_MESSAGE(message);
+    TEST_ASSERT_TRUE(limiter.activations() > 0);
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_year_within_budget_at_default_brightness()
+{
+    runYear(50);
+}
+
+void test_year_within_budget_at_full_brightness()
+{
+    runYear(255);
+}
+
+void test_recovers_gradually_after_limiting()
+{
+    PowerLimiter limiter(TEST_BUDGET_MA, 255, TEST_RAMP_STEP);
+    fill_solid(leds, TEST_LEDS, CRGB::Black);
+    frame.clear();
+    for (int i = 0; i < TEST_LEDS; i++) 
+    {
+        frame.set(i, CRGB::White);
+    }
+    uint8_t limited = limiter.update(estimateMa);
+    TEST_ASSERT_TRUE(limiter.limiting());
+    TEST_ASSERT_TRUE(rescanMa(limited) <= TEST_BUDGET_MA);
+    TEST_ASSERT_TRUE(rescanMa(limited + 1) > TEST_BUDGET_MA);
+
+    frame.clear();
+    TEST_ASSERT_EQUAL_UINT8(limited + TEST_RAMP_STEP, limiter.update(estimateMa));
+    TEST_ASSERT_FALSE(limiter.limiting());
+    TEST_ASSERT_EQUAL_UINT32(1, limiter.activations());
+}
+
+void test_restored_frame_is_limited()
+{
+    // A frame put back after a reset is written straight into the buffer
+    PowerLimiter limiter(TEST_BUDGET_MA, 255, TEST_RAMP_STEP);
+    frame.clear();
+    fill_solid(leds, TEST_LEDS, CRGB::White);
+    TEST_ASSERT_EQUAL_UINT32(TEST_LEDS * LED_IDLE_MA, estimateMa(255));
+
+    frame.rescan();
+    CurrentEstimate running = frame.estimate(255);
+    CurrentEstimate rescanned = rescanEstimate(255);
+    TEST_ASSERT_EQUAL_UINT32(rescanned.totalMa(), running.totalMa());
+
+    uint8_t brightness = limiter.update(estimateMa);
+    TEST_ASSERT_TRUE(limiter.limiting());
+    TEST_ASSERT_TRUE(rescanMa(brightness) <= TEST_BUDGET_MA);
+}
+
+int main(int argc, char** argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_year_within_budget_at_default_brightness);
+    RUN_TEST(test_year_within_budget_at_full_brightness);
+    RUN_TEST(test_recovers_gradually_after_limiting);
+    RUN_TEST(test_restored_frame_is_limited);
+    return UNITY_END();
+}
@@ -0,0 +1,207 @@
+#include <unity.h>
+#include "preview_codec.h"
+
+//-----------------------------------------------------------------------------
+// Preview codec (preview_codec.cpp): frames encoded into a buffer and decoded
+// again must reproduce the source exactly
+//-----------------------------------------------------------------------------
+#define TEST_LEDS   332
+
+struct BufferSink
+{
+    uint8_t data[4 + TEST_LEDS * 7];
+    size_t  length;
+    size_t  capacity;
+
+    bool write(const uint8_t* bytes, size_t count)
+    {
+        if (length + count > capacity) 
+        {
+            return false;
+        }
+        memcpy(&data[length], bytes, count);
+        length += count;
+        return true;
+    }
+};
+
+static CRGB       frame[TEST_LEDS];
+static CRGB       sent[TEST_LEDS];
+static CRGB       viewer[TEST_LEDS];
+static BufferSink sink;
+static uint32_t   seed;
+
+static uint32_t nextRandom()
+{
+    seed = seed * 1664525UL + 1013904223UL;
+    return seed >> 8;
+}
+
+// Encode the frame, decode it into the viewer and check both match it
+static size_t loopback(bool keyframe)
+{
+    size_t expected = previewMessageSize(frame, sent, TEST_LEDS, keyframe);
+    sink.length = 0;
+    TEST_ASSERT_TRUE(previewEncode(sink, frame, sent, TEST_LEDS, keyframe));
+    if (expected == 0) 
+    {
+        // Nothing changed: the sender skips the message
+        return 0;
+    }
+    TEST_ASSERT_EQUAL(expected, sink.length);
+    TEST_ASSERT_EQUAL(TEST_LEDS, previewDecode(sink.data, sink.length, viewer, TEST_LEDS));
+    TEST_ASSERT_EQUAL_MEMORY(frame, viewer, sizeof(frame));
+    TEST_ASSERT_EQUAL_MEMORY(frame, sent, sizeof(frame));
+    return sink.length;
+}
+
+// Number of runs in the last message
+static int runCount()
+{
+    int runs = 0;
+    for (size_t p = 3; p < sink.length; runs++) 
+    {
+        p += 4 + (sink.data[p + 2] | (sink.data[p + 3] << 8)) * 3;
+    }
+    return runs;
+}
+
+void setUp()
+{
+    seed = 1;
+    sink.capacity = sizeof(sink.data);
+    fill_solid(frame, TEST_LEDS, CRGB::Black);
+    fill_solid(sent, TEST_LEDS, CRGB::Black);
+    fill_solid(viewer, TEST_LEDS, CRGB(1, 2, 3));
+}
+
+void tearDown() {}
+
+void test_keyframe_is_one_run()
+{
+    for (int i = 0; i < TEST_LEDS; i++) frame[i] = CRGB(nextRandom());
+    TEST_ASSERT_EQUAL(3 + 4 + TEST_LEDS * 3, loopback(true));
+    TEST_ASSERT_EQUAL(PREVIEW_KEYFRAME, sink.data[0]);
+    TEST_ASSERT_EQUAL(1, runCount());
+
+    // A key frame is sent even when nothing changed
+    TEST_ASSERT_EQUAL(3 + 4 + TEST_LEDS * 3, loopback(true));
+}
+
+void test_deltas_follow_random_changes()
+{
+    loopback(true);
+    for (int step = 0; step < 2000; step++) 
+    {
+        int changes = nextRandom() % 12;
+        for (int n = 0; n < changes; n++) 
+        {
+            int start = nextRandom() % TEST_LEDS;
+            int length = 1 + nextRandom() % 6;
+            CRGB color(nextRandom());
+            for (int i = start; i < start + length && i < TEST_LEDS; i++) frame[i] = color;
+        }
+        size_t length = loopback(false);
+        if (length > 0) 
+        {
+            TEST_ASSERT_EQUAL(PREVIEW_DELTA, sink.data[0]);
+            TEST_ASSERT_TRUE(length < 3 + 4 + TEST_LEDS * 3);
+        }
+    }
+}
+
+void test_unchanged_frame_sends_nothing()
+{
+    frame[5] = CRGB::White;
+    loopback(true);
+    TEST_ASSERT_EQUAL(0, previewMessageSize(frame, sent, TEST_LEDS, false));
+    TEST_ASSERT_EQUAL(0, loopback(false));
+}
+
+void test_close_changes_share_a_run()
+{
+    loopback(true);
+
+    // One unchanged pixel between: cheaper to resend it than to start a run
+    frame[10] = CRGB::Red;
+    frame[12] = CRGB::Red;
+    TEST_ASSERT_EQUAL(3 + 4 + 3 * 3, loopback(false));
+    TEST_ASSERT_EQUAL(1, runCount());
+
+    // Two unchanged pixels between: two runs
+    frame[20] = CRGB::Blue;
+    frame[23] = CRGB::Blue;
+    TEST_ASSERT_EQUAL(3 + 2 * (4 + 3), loopback(false));
+    TEST_ASSERT_EQUAL(2, runCount());
+
+    // Changes at both ends of the ring
+    frame[0] = CRGB::Green;
+    frame[TEST_LEDS - 1] = CRGB::Green;
+    loopback(false);
+    TEST_ASSERT_EQUAL(2, runCount());
+}
+
+void test_keyframe_clears_the_viewer()
+{
+    loopback(true);
+    frame[7] = CRGB::White;
+    loopback(false);
+
+    // Decoding a delta alone keeps what the viewer had; a key frame replaces it
+    fill_solid(viewer, TEST_LEDS, CRGB::Red);
+    fill_solid(sent, TEST_LEDS, CRGB::Black);
+    sink.length = 0;
+    previewEncode(sink, frame, sent, TEST_LEDS, false);
+    previewDecode(sink.data, sink.length, viewer, TEST_LEDS);
+    TEST_ASSERT_TRUE(viewer[0] == CRGB(CRGB::Red));
+    TEST_ASSERT_TRUE(viewer[7] == CRGB(CRGB::White));
+    loopback(true);
+}
+
+void test_sink_failure_stops_encoding()
+{
+    frame[100] = CRGB::White;
+    sink.length = 0;
+    sink.capacity = 10;
+    TEST_ASSERT_FALSE(previewEncode(sink, frame, sent, TEST_LEDS, true));
+}
+
+void test_malformed_messages_are_rejected()
+{
+    frame[3] = CRGB::White;
+    frame[300] = CRGB::Blue;
+    loopback(true);
+
+    sink.length = 0;
+    frame[40] = CRGB::Red;
+    previewEncode(sink, frame, sent, TEST_LEDS, false);
+    size_t length = sink.length;
+
+    // Every truncation that cuts a run short
+    for (size_t cut = 0; cut < length; cut++) 
+    {
+        if (cut != 3) 
+        {
+            TEST_ASSERT_EQUAL(-1, previewDecode(sink.data, cut, viewer, TEST_LEDS));
+        }
+    }
+    TEST_ASSERT_EQUAL(-1, previewDecode(sink.data, length, viewer, 40));
+
+    uint8_t badType[] = { 2, 1, 0 };
+    TEST_ASSERT_EQUAL(-1, previewDecode(badType, sizeof(badType), viewer, TEST_LEDS));
+    uint8_t pastEnd[] = { PREVIEW_DELTA, 2, 0, 1, 0, 2, 0, 1, 2, 3, 4, 5, 6 };
+    TEST_ASSERT_EQUAL(-1, previewDecode(pastEnd, sizeof(pastEnd), viewer, TEST_LEDS));
+}
+
+int main(int argc, char** argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_keyframe_is_one_run);
+    RUN_TEST(test_deltas_follow_random_changes);
+    RUN_TEST(test_unchanged_frame_sends_nothing);
+    RUN_TEST(test_close_changes_share_a_run);
+    RUN_TEST(test_keyframe_clears_the_viewer);
+    RUN_TEST(test_sink_failure_stops_encoding);
+    RUN_TEST(test_malformed_messages_are_rejected);
+    return UNITY_END();
+}
@@ -0,0 +1,124 @@
+#include <unity.h>
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include "sun_calc.h"
+
+//-----------------------------------------------------------------------------
+// Batched sun calculation (sun_calc.cpp) against the scalar version, known
+// times, and throughput in locations/ms
+//-----------------------------------------------------------------------------
+#define MAX_SITES   64
+
+static float   latitude[MAX_SITES], longitude[MAX_SITES];
+static int16_t sunrise[MAX_SITES], sunset[MAX_SITES], noon[MAX_SITES], dayMinutes[MAX_SITES], twilight[MAX_SITES];
+
+static SunBatch batchOf(int count)
+{
+    SunBatch batch = { count, latitude, longitude, sunrise, sunset, noon, dayMinutes, twilight };
+    return batch;
+}
+
+// Minutes apart on the 24-hour dial
+static int dialDistance(int a, int b)
+{
+    int d = abs(a - b) % 1440;
+    return d > 720 ? 1440 - d : d;
+}
+
+void setUp()
+{
+    // Sites spread over every latitude band, including both polar circles
+    for (int i = 0; i < MAX_SITES; i++) 
+    {
+        latitude[i]  = -80.0f + 160.0f * i / (MAX_SITES - 1);
+        longitude[i] = -180.0f + 360.0f * ((i * 37) % MAX_SITES) / MAX_SITES;
+    }
+}
+
+void tearDown() {}
+
+void test_batch_matches_scalar_all_year()
+{
+    SunBatch batch = batchOf(MAX_SITES);
+    for (int day = 0; day < 366; day++) 
+    {
+        calcSunTimesBatch(batch, day);
+        for (int i = 0; i < MAX_SITES; i++) 
+        {
+            SunTimes t = calcSunTimes(latitude[i], longitude[i], day);
+            TEST_ASSERT_LESS_OR_EQUAL(1, dialDistance(t.solarNoonMinutes, noon[i]));
+            TEST_ASSERT_INT_WITHIN(1, t.dayMinutes, dayMinutes[i]);
+            if (t.dayMinutes > 0 && t.dayMinutes < 1440) 
+            {
+                TEST_ASSERT_LESS_OR_EQUAL(1, dialDistance(t.sunriseMinutes, sunrise[i]));
+                TEST_ASSERT_LESS_OR_EQUAL(1, dialDistance(t.sunsetMinutes, sunset[i]));
+            }
+            TEST_ASSERT_GREATER_OR_EQUAL(0, twilight[i]);
+        }
+    }
+}
+
+void test_greenwich_solstices()
+{
+    // NOAA: 21 June sunrise 03:43, sunset 20:21 UTC; 21 December 08:04 and 15:53
+    SunTimes june = calcSunTimes(51.4786f, -0.0013f, 171);
+    SunTimes december = calcSunTimes(51.4786f, -0.0013f, 354);
+    TEST_ASSERT_INT_WITHIN(3, 3 * 60 + 43, june.sunriseMinutes);
+    TEST_ASSERT_INT_WITHIN(3, 20 * 60 + 21, june.sunsetMinutes);
+    TEST_ASSERT_INT_WITHIN(3, 8 * 60 + 4, december.sunriseMinutes);
+    TEST_ASSERT_INT_WITHIN(3, 15 * 60 + 53, december.sunsetMinutes);
+}
+
+void test_polar_days()
+{
+    latitude[0] = 78.2f;    // Longyearbyen
+    longitude[0] = 15.6f;
+    SunBatch batch = batchOf(1);
+
+    calcSunTimesBatch(batch, 171);
+    TEST_ASSERT_EQUAL(1440, dayMinutes[0]);
+    TEST_ASSERT_EQUAL(0, sunrise[0]);
+    TEST_ASSERT_EQUAL(1439, sunset[0]);
+
+    calcSunTimesBatch(batch, 354);
+    TEST_ASSERT_EQUAL(0, dayMinutes[0]);
+    TEST_ASSERT_EQUAL(sunrise[0], sunset[0]);
+}
+
+// Locations per millisecond over many passes of one batch
+static double throughput(int count)
+{
+    const int passes = 20000 / count + 200;
+    SunBatch batch = batchOf(count);
+    auto start = std::chrono::steady_clock::now();
+    for (int pass = 0; pass < passes; pass++) 
+    {
+        calcSunTimesBatch(batch, pass % 365);
+    }
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return (double)count * passes / (ms > 0 ? ms : 1e-3);
+}
+
+void test_throughput_scales_with_sites()
+{
+    double few  = throughput(4);
+    double many = throughput(MAX_SITES);
+    char message[96];
+    snprintf(message, sizeof(message), "%.0f locations/ms for 4 sites, %.0f for %d sites", few, many, MAX_SITES);
+    TEST_MESSAGE(message);
+
+    // The date terms are shared, so more sites per batch must not be slower per site
+    TEST_ASSERT_TRUE(many >= few * 0.8);
+    TEST_ASSERT_TRUE(many > 100.0);
+}
+
+int main(int argc, char** argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_batch_matches_scalar_all_year);
+    RUN_TEST(test_greenwich_solstices);
+    RUN_TEST(test_polar_days);
+    RUN_TEST(test_throughput_scales_with_sites);
+    return UNITY_END();
+}
@@ -0,0 +1,315 @@
+#include <unity.h>
+#include <chrono>
+#include <new>
+#include <stdio.h>
+#include <stdlib.h>
+#include <WiFi.h>
+#include "sun_fetch.h"
+#include "time_parse.h"
+
+//-----------------------------------------------------------------------------
+// Sun data fetch and parse (sun_fetch.cpp) against scripted servers serving
+// tools/mock_sun_api.py's responses, one per fault mode. Each fault must
+// leave the day unset, none may hold a fetch past its deadline, and no
+// refresh may touch the heap.
+//-----------------------------------------------------------------------------
+#define TEST_TIMEOUT_MS     1000
+#define TEST_DAY            19895       // 2024-06-21
+#define TEST_BODY_LENGTH    1000        // Fits the firmware's response buffer
+
+// The mock's bodies for Greenwich on 2024-06-21, normal and faulty
+static const char GOOD_BODY[] =
+    "{\"results\": {\"sunrise\": \"2024-06-21T03:42:24+00:00\", \"sunset\": \"2024-06-21T20:20:41+00:00\", "
+    "\"solar_noon\": \"2024-06-21T12:01:33+00:00\", \"day_length\": 59897}, \"status\": \"OK\", \"tzid\": \"UTC\"}";
+static const char MALFORMED_BODY[] =
+    "{\"results\": {\"sunrise\": \"7:61 AM\", \"sunset\": \"2024-13-45T25:99\", \"solar_noon\": \"\", "
+    "\"day_length\": 59897}, \"status\": \"OK\", \"tzid\": \"UTC\"}";
+static const char MISSING_BODY[] =
+    "{\"results\": {\"solar_noon\": \"2024-06-21T12:01:33+00:00\", \"day_length\": 59897}, "
+    "\"status\": \"OK\", \"tzid\": \"UTC\"}";
+static const char ERROR_BODY[] = "{\"status\":\"UNAVAILABLE\"}";
+
+// Heap allocations while counting is on: operator new always, and with
+// glibc malloc() as well, which ArduinoJson's default allocator uses
+static bool   counting    = false;
+static size_t allocations = 0;
+
+void* operator new(size_t size)
+{
+    allocations += counting;
+    void* block = malloc(size ? size : 1);
+    if (block == nullptr) throw std::bad_alloc();
+    return block;
+}
+
+void* operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void* block) noexcept { free(block); }
+void operator delete[](void* block) noexcept { free(block); }
+void operator delete(void* block, size_t) noexcept { free(block); }
+void operator delete[](void* block, size_t) noexcept { free(block); }
+
+#ifdef __GLIBC__
+extern "C" void* __libc_malloc(size_t size);
+extern "C" void* __libc_calloc(size_t count, size_t size);
+extern "C" void* __libc_realloc(void* block, size_t size);
+
+extern "C" void* malloc(size_t size)
+{
+    allocations += counting;
+    return __libc_malloc(size);
+}
+
+extern "C" void* calloc(size_t count, size_t size)
+{
+    allocations += counting;
+    return __libc_calloc(count, size);
+}
+
+extern "C" void* realloc(void* block, size_t size)
+{
+    allocations += counting;
+    return __libc_realloc(block, size);
+}
+#endif
+
+static StubPeer   peer;
+static HttpTarget api;
+static char       script[2048];
+static SunData    data;
+static size_t     length;
+
+// A response as the mock's http.server sends it; bodyLength below the
+// Content-Length cuts the body short, as the truncate fault does
+static void serve(const char* status, const char* body, size_t bodyLength, bool close)
+{
+    int n = snprintf(script, sizeof(script), "HTTP/1.1 %s\r\nServer: BaseHTTP/0.6 Python/3.12\r\n"
+                     "Content-Type: application/json\r\nContent-Length: %u\r\n\r\n", status, (unsigned)strlen(body));
+    TEST_ASSERT_TRUE(n > 0 && n + bodyLength < sizeof(script));
+    memcpy(script + n, body, bodyLength);
+    script[n + bodyLength] = '\0';
+    stubPeerInit(peer, script, close);
+}
+
+static void serve(const char* status, const char* body)
+{
+    serve(status, body, strlen(body), false);
+}
+
+// Fetch the test day and report how long it took on the fake clock
+static int fetch(const char* mode)
+{
+    WiFiClient client(&peer);
+    unsigned long start = millis();
+    int code = sunFetchDay(client, api, "/json?lat=51.478581&lng=-0.001292&formatted=0&date=2024-06-21",
+                           TEST_DAY, data, length, TEST_TIMEOUT_MS);
+    unsigned long elapsed = millis() - start;
+
+    char message[96];
+    snprintf(message, sizeof(message), "%-9s HTTP %d in %lu ms, day %s", mode, code, elapsed,
+             data.lastUpdate ? "used" : "rejected");
+    TEST_MESSAGE(message);
+    TEST_ASSERT_TRUE(elapsed <= TEST_TIMEOUT_MS + 5);
+    return code;
+}
+
+void setUp()
+{
+    TEST_ASSERT_TRUE(httpParseUrl("http://192.168.1.10:8080/json", api));
+    stubAdvanceMs(1);       // A fetch that succeeds stamps lastUpdate, never 0
+}
+
+void tearDown() {}
+
+void test_good_day()
+{
+    serve("200 OK", GOOD_BODY);
+    TEST_ASSERT_EQUAL(200, fetch("none"));
+    TEST_ASSERT_EQUAL(strlen(GOOD_BODY), length);
+    TEST_ASSERT_TRUE(data.lastUpdate != 0);
+    TEST_ASSERT_EQUAL(3 * 60 + 42, data.sunriseMinutes);
+    TEST_ASSERT_EQUAL(20 * 60 + 20, data.sunsetMinutes);
+    TEST_ASSERT_EQUAL(12 * 60 + 1, data.solarNoonMinutes);
+    TEST_ASSERT_EQUAL(59897, data.daySeconds);
+    TEST_ASSERT_TRUE(peer.open);
+    TEST_ASSERT_NOT_NULL(strstr(peer.sent, "GET /json?lat=51.478581&lng=-0.001292&formatted=0&date=2024-06-21 "));
+}
+
+void test_latency_within_deadline()
+{
+    serve("200 OK", GOOD_BODY);
+    peer.delayMs = 200;
+    unsigned long start = millis();
+    TEST_ASSERT_EQUAL(200, fetch("latency"));
+    TEST_ASSERT_TRUE(millis() - start >= 200);
+    TEST_ASSERT_TRUE(data.lastUpdate != 0);
+}
+
+void test_latency_past_deadline()
+{
+    // The mock's default delay, three times the fetch's timeout
+    serve("200 OK", GOOD_BODY);
+    peer.delayMs = 3000;
+    unsigned long start = millis();
+    TEST_ASSERT_EQUAL(HTTP_FETCH_ERROR_TIMEOUT, fetch("latency"));
+    TEST_ASSERT_TRUE(millis() - start >= TEST_TIMEOUT_MS);
+    TEST_ASSERT_EQUAL(0, data.lastUpdate);
+    TEST_ASSERT_FALSE(peer.open);
+}
+
+void test_truncated_body()
+{
+    // Half the promised body, then the connection drops
+    serve("200 OK", GOOD_BODY, strlen(GOOD_BODY) / 2, true);
+    TEST_ASSERT_TRUE(fetch("truncate") < 0);
+    TEST_ASSERT_EQUAL(0, data.lastUpdate);
+    TEST_ASSERT_FALSE(peer.open);
+}
+
+void test_server_error()
+{
+    serve("503 Service Unavailable", ERROR_BODY);
+    TEST_ASSERT_EQUAL(503, fetch("error"));
+    TEST_ASSERT_EQUAL(0, data.lastUpdate);
+}
+
+void test_malformed_timestamps()
+{
+    serve("200 OK", MALFORMED_BODY);
+    TEST_ASSERT_EQUAL(200, fetch("malformed"));
+    TEST_ASSERT_EQUAL(0, data.lastUpdate);
+    TEST_ASSERT_EQUAL(SUN_PARSE_MALFORMED, sunParseResponse(MALFORMED_BODY, strlen(MALFORMED_BODY), data));
+}
+
+void test_missing_fields()
+{
+    serve("200 OK", MISSING_BODY);
+    TEST_ASSERT_EQUAL(200, fetch("missing"));
+    TEST_ASSERT_EQUAL(0, data.lastUpdate);
+    TEST_ASSERT_EQUAL(SUN_PARSE_MALFORMED, sunParseResponse(MISSING_BODY, strlen(MISSING_BODY), data));
+}
+
+void test_bad_bodies_are_rejected()
+{
+    // Cut short with a matching length, so HTTP is happy but JSON is not
+    TEST_ASSERT_EQUAL(SUN_PARSE_INVALID_JSON, sunParseResponse(GOOD_BODY, 90, data));
+    TEST_ASSERT_EQUAL(SUN_PARSE_INVALID_JSON, sunParseResponse("", 0, data));
+    TEST_ASSERT_EQUAL(0, data.lastUpdate);
+
+    // Well-formed JSON in the wrong shape
+    const char* const WRONG[] =
+    {
+        "{}",
+        "[]",
+        "{\"results\": null}",
+        "{\"results\": [1, 2, 3]}",
+        "{\"results\": \"2024-06-21T03:42:24+00:00\"}",
+        "{\"results\": {\"sunrise\": \"2024-06-21T03:42:24+00:00\", \"sunset\": \"2024-06-21T20:20:41+00:00\", "
+        "\"solar_noon\": \"2024-06-21T12:01:33+00:00\", \"day_length\": \"59897\"}}",
+        "{\"results\": {\"sunrise\": \"2024-06-21T03:42:24+00:00\", \"sunset\": \"2024-06-21T20:20:41+00:00\", "
+        "\"solar_noon\": \"2024-06-21T12:01:33+00:00\", \"day_length\": 90000}}",
+        "{\"results\": {\"sunrise\": 1718941344, \"sunset\": \"2024-06-21T20:20:41+00:00\", "
+        "\"solar_noon\": \"2024-06-21T12:01:33+00:00\", \"day_length\": 59897}}",
+    };
+    for (const char* body : WRONG)
+    {
+        TEST_ASSERT_EQUAL_MESSAGE(SUN_PARSE_MALFORMED, sunParseResponse(body, strlen(body), data), body);
+        TEST_ASSERT_EQUAL(0, data.lastUpdate);
+    }
+}
+
+void test_refresh_never_allocates()
+{
+    // Fetch, pool, deserializeJson and field checks, for every fault
+    static char tooMany[TEST_BODY_LENGTH];
+    size_t n = 0;
+    tooMany[n++] = '[';
+    while (n < sizeof(tooMany) - 2)
+    {
+        tooMany[n++] = '0';
+        tooMany[n++] = ',';
+    }
+    tooMany[n - 1] = ']';
+    tooMany[n] = '\0';
+
+    counting    = true;
+    allocations = 0;
+    for (int pass = 0; pass < 50; pass++)
+    {
+        WiFiClient client(&peer);
+        serve("200 OK", GOOD_BODY);
+        sunFetchDay(client, api, "/json", TEST_DAY, data, length, TEST_TIMEOUT_MS);
+        TEST_ASSERT_TRUE(data.lastUpdate != 0);
+
+        serve("503 Service Unavailable", ERROR_BODY);
+        TEST_ASSERT_EQUAL(503, sunFetchDay(client, api, "/json", TEST_DAY, data, length, TEST_TIMEOUT_MS));
+        serve("200 OK", MALFORMED_BODY);
+        sunFetchDay(client, api, "/json", TEST_DAY, data, length, TEST_TIMEOUT_MS);
+        serve("200 OK", MISSING_BODY);
+        sunFetchDay(client, api, "/json", TEST_DAY, data, length, TEST_TIMEOUT_MS);
+        serve("200 OK", GOOD_BODY, strlen(GOOD_BODY) / 2, true);
+        sunFetchDay(client, api, "/json", TEST_DAY, data, length, TEST_TIMEOUT_MS);
+        serve("200 OK", GOOD_BODY);
+        peer.delayMs = 3000;
+        sunFetchDay(client, api, "/json", TEST_DAY, data, length, TEST_TIMEOUT_MS);
+        TEST_ASSERT_EQUAL(0, data.lastUpdate);
+
+        // More values than the pool holds: refused, not moved to the heap
+        serve("200 OK", tooMany);
+        TEST_ASSERT_EQUAL(200, sunFetchDay(client, api, "/json", TEST_DAY, data, length, TEST_TIMEOUT_MS));
+        TEST_ASSERT_EQUAL(SUN_PARSE_INVALID_JSON, sunParseResponse(tooMany, strlen(tooMany), data));
+    }
+    size_t counted = allocations;
+
+    // The counters do see allocations
+    delete new int(1);
+    free(malloc(16));
+    size_t seen = allocations - counted;
+    counting = false;
+
+    TEST_ASSERT_EQUAL(0, counted);
+#ifdef __GLIBC__
+    TEST_ASSERT_EQUAL(3, seen);         // new calls malloc() too
+#else
+    TEST_ASSERT_EQUAL(1, seen);
+#endif
+}
+
+void test_parse_cost()
+{
+    const int runs = 20000;
+    volatile int sink = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int n = 0; n < runs; n++)
+    {
+        sunParseResponse(GOOD_BODY, strlen(GOOD_BODY), data);
+        sink = sink + data.sunriseMinutes;
+    }
+    double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / runs;
+
+    char message[96];
+    snprintf(message, sizeof(message), "parse %.2f us per response, JSON pool peak %u of %u bytes", us,
+             (unsigned)sunJsonPoolPeak(), (unsigned)sunJsonPoolCapacity());
+    TEST_MESSAGE(message);
+    TEST_ASSERT_TRUE(data.lastUpdate != 0);
+    TEST_ASSERT_TRUE(sunJsonPoolPeak() <= sunJsonPoolCapacity());
+}
+
+int main(int argc, char** argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_good_day);
+    RUN_TEST(test_latency_within_deadline);
+    RUN_TEST(test_latency_past_deadline);
+    RUN_TEST(test_truncated_body);
+    RUN_TEST(test_server_error);
+    RUN_TEST(test_malformed_timestamps);
+    RUN_TEST(test_missing_fields);
+    RUN_TEST(test_bad_bodies_are_rejected);
+    RUN_TEST(test_parse_cost);
+    RUN_TEST(test_refresh_never_allocates);
+    return UNITY_END();
+}
@@ -0,0 +1,174 @@
+#include <unity.h>
+#include "telemetry.h"
+
+//-----------------------------------------------------------------------------
+// Telemetry codec (telemetry.cpp): frames encoded and decoded again must give
+// back the same payload and fields, and damage must be caught
+//-----------------------------------------------------------------------------
+static uint8_t  frame[TELEMETRY_MAX_FRAME];
+static uint8_t  decoded[TELEMETRY_MAX_PAYLOAD];
+static uint32_t seed;
+
+static uint32_t nextRandom()
+{
+    seed = seed * 1664525UL + 1013904223UL;
+    return seed >> 8;
+}
+
+// Encode, check the framing and decode; returns the frame length
+static size_t loopback(const uint8_t* payload, size_t length)
+{
+    size_t size = telemetryEncode(payload, length, frame);
+    TEST_ASSERT_TRUE(size >= length + 4);
+    TEST_ASSERT_TRUE(size <= TELEMETRY_MAX_FRAME);
+
+    // Delimited, and no 0x00 inside for a reader to resync on
+    TEST_ASSERT_EQUAL(0, frame[0]);
+    TEST_ASSERT_EQUAL(0, frame[size - 1]);
+    for (size_t i = 1; i < size - 1; i++)
+    {
+        TEST_ASSERT_TRUE(frame[i] != 0);
+    }
+
+    TEST_ASSERT_EQUAL((int)length, telemetryDecode(&frame[1], size - 2, decoded, sizeof(decoded)));
+    TEST_ASSERT_EQUAL_MEMORY(payload, decoded, length);
+    return size;
+}
+
+// Varints back out of a decoded payload, as tools/telemetry_decode.py reads them
+static size_t readVarints(const uint8_t* data, size_t length, uint32_t* values, size_t max)
+{
+    size_t count = 0;
+    uint32_t value = 0;
+    int shift = 0;
+    for (size_t i = 0; i < length && count < max; i++)
+    {
+        value |= (uint32_t)(data[i] & 0x7F) << shift;
+        shift += 7;
+        if (!(data[i] & 0x80))
+        {
+            values[count++] = value;
+            value = 0;
+            shift = 0;
+        }
+    }
+    return count;
+}
+
+void setUp()
+{
+    seed = 7;
+}
+
+void tearDown() {}
+
+void test_fields_round_trip()
+{
+    static const uint32_t UNSIGNED[] = { 0, 1, 127, 128, 16383, 16384, 1700000000UL, 0xFFFFFFFFUL };
+    static const int32_t  SIGNED[]   = { 0, -1, 1, -64, 64, -1440, 1440, INT32_MIN, INT32_MAX };
+
+    TelemetryFrame telemetry(TELEMETRY_CLOCK);
+    for (uint32_t v : UNSIGNED) telemetry.put(v);
+    for (int32_t v : SIGNED)    telemetry.putSigned(v);
+    TEST_ASSERT_FALSE(telemetry.overflowed());
+
+    loopback(telemetry.data(), telemetry.size());
+    TEST_ASSERT_EQUAL(TELEMETRY_CLOCK, decoded[0]);
+
+    uint32_t values[32];
+    size_t count = readVarints(&decoded[1], telemetry.size() - 1, values, 32);
+    TEST_ASSERT_EQUAL(17, count);
+    for (size_t i = 0; i < 8; i++)
+    {
+        TEST_ASSERT_TRUE(values[i] == UNSIGNED[i]);
+    }
+    for (size_t i = 0; i < 9; i++)
+    {
+        int32_t unzigzag = (int32_t)((values[8 + i] >> 1) ^ (0U - (values[8 + i] & 1)));
+        TEST_ASSERT_EQUAL(SIGNED[i], unzigzag);
+    }
+}
+
+void test_zero_bytes_round_trip()
+{
+    // Every byte zero, zero at either end, and random payloads of every length
+    uint8_t payload[TELEMETRY_MAX_PAYLOAD - 1];
+    memset(payload, 0, sizeof(payload));
+    loopback(payload, sizeof(payload));
+    loopback(payload, 1);
+
+    for (int round = 0; round < 2000; round++)
+    {
+        size_t length = 1 + nextRandom() % sizeof(payload);
+        for (size_t i = 0; i < length; i++)
+        {
+            // Mostly zeros and small values, like varint fields
+            uint32_t r = nextRandom();
+            payload[i] = (r & 3) == 0 ? 0 : (uint8_t)(r >> 4);
+        }
+        loopback(payload, length);
+    }
+}
+
+void test_damage_is_caught()
+{
+    TelemetryFrame telemetry(TELEMETRY_CLOCK);
+    for (uint32_t v = 0; v < 20; v++) telemetry.put(v * 1000);
+    size_t size = loopback(telemetry.data(), telemetry.size());
+
+    // Any single changed byte fails the CRC or the COBS structure
+    int caught = 0;
+    for (size_t i = 1; i < size - 1; i++)
+    {
+        for (int bit = 0; bit < 8; bit++)
+        {
+            uint8_t saved = frame[i];
+            frame[i] ^= 1 << bit;
+            if (frame[i] != 0)
+            {
+                caught += telemetryDecode(&frame[1], size - 2, decoded, sizeof(decoded)) < 0;
+            }
+            else
+            {
+                caught++;           // A reader splits the frame here
+            }
+            frame[i] = saved;
+        }
+    }
+    TEST_ASSERT_EQUAL((int)(size - 2) * 8, caught);
+
+    // A frame cut short, as when text used to land inside one
+    TEST_ASSERT_EQUAL(-1, telemetryDecode(&frame[1], size / 2, decoded, sizeof(decoded)));
+    TEST_ASSERT_EQUAL(-1, telemetryDecode(&frame[1], 0, decoded, sizeof(decoded)));
+
+    // Too small an output buffer
+    TEST_ASSERT_EQUAL(-1, telemetryDecode(&frame[1], size - 2, decoded, 4));
+}
+
+void test_overflow_is_refused()
+{
+    TelemetryFrame telemetry(TELEMETRY_CLOCK);
+    for (int i = 0; i < TELEMETRY_MAX_PAYLOAD; i++)
+    {
+        telemetry.put(0xFFFFFFFFUL);
+    }
+    TEST_ASSERT_TRUE(telemetry.overflowed());
+    TEST_ASSERT_TRUE(telemetry.size() <= TELEMETRY_MAX_PAYLOAD - 1);
+
+    uint32_t dropped = telemetryDropped();
+    TEST_ASSERT_FALSE(telemetry.send());
+    TEST_ASSERT_EQUAL_UINT32(dropped + 1, telemetryDropped());
+
+    uint8_t payload[TELEMETRY_MAX_PAYLOAD] = { TELEMETRY_CLOCK };
+    TEST_ASSERT_EQUAL(0, telemetryEncode(payload, sizeof(payload), frame));
+}
+
+int main(int argc, char** argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_fields_round_trip);
+    RUN_TEST(test_zero_bytes_round_trip);
+    RUN_TEST(test_damage_is_caught);
+    RUN_TEST(test_overflow_is_refused);
+    return UNITY_END();
+}
@@ -0,0 +1,355 @@
+#include <unity.h>
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "time_parse.h"
+
+//-----------------------------------------------------------------------------
+// Timestamp parsers (time_parse.cpp): malformed and truncated input, a
+// mutation fuzz loop checked against an independent validator, and the
+// cost against the C library
+//-----------------------------------------------------------------------------
+#define FUZZ_ROUNDS     200000
+
+static uint32_t seed;
+
+static uint32_t nextRandom()
+{
+    seed = seed * 1664525UL + 1013904223UL;
+    return seed >> 8;
+}
+
+// Copy into a buffer of exactly the right size, so an overread lands past
+// the allocation where a sanitizer sees it
+static bool parseExact(const char* text, size_t length, IsoTimestamp& out)
+{
+    char* copy = (char*)malloc(length + 1);
+    memcpy(copy, text, length);
+    copy[length] = '\0';
+    bool ok = parseIsoTimestamp(copy, out);
+    free(copy);
+    return ok;
+}
+
+//-----------------------------------------------------------------------------
+// Reference Validator
+//-----------------------------------------------------------------------------
+// Written separately from the parser: the shape is matched against a
+// template, the date by a round trip through a day count.
+static long daysFromCivil(int y, int m, int d)
+{
+    y -= m <= 2;
+    long era = (y >= 0 ? y : y - 399) / 400;
+    long yoe = y - era * 400;
+    long doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    long doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + doe;
+}
+
+static void civilFromDays(long z, int& y, int& m, int& d)
+{
+    long era = (z >= 0 ? z : z - 146096) / 146097;
+    long doe = z - era * 146097;
+    long yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    long doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    long mp = (5 * doy + 2) / 153;
+    d = (int)(doy - (153 * mp + 2) / 5 + 1);
+    m = (int)(mp < 10 ? mp + 3 : mp - 9);
+    y = (int)(yoe + era * 400 + (m <= 2));
+}
+
+static bool matches(const char*& p, const char* shape)
+{
+    for (; *shape; shape++, p++) 
+    {
+        bool ok = *shape == 'D' ? (*p >= '0' && *p <= '9') : *p == *shape;
+        if (!ok) return false;
+    }
+    return true;
+}
+
+static int number(const char* p, int digits)
+{
+    int value = 0;
+    for (int i = 0; i < digits; i++) value = value * 10 + (p[i] - '0');
+    return value;
+}
+
+static bool referenceValid(const char* text, IsoTimestamp& t)
+{
+    const char* p = text;
+    if (!matches(p, "DDDD-DD-DDTDD:DD:DD")) return false;
+    t.year = number(text, 4);
+    t.month = number(text + 5, 2);
+    t.day = number(text + 8, 2);
+    t.hour = number(text + 11, 2);
+    t.minute = number(text + 14, 2);
+    t.second = number(text + 17, 2);
+
+    if (*p == '.') 
+    {
+        p++;
+        if (!(*p >= '0' && *p <= '9')) return false;
+        while (*p >= '0' && *p <= '9') p++;
+    }
+    t.offsetMinutes = 0;
+    if (*p == 'Z') 
+    {
+        p++;
+    }
+    else 
+    {
+        const char* offset = p;
+        if ((*p != '+' && *p != '-') || !matches(++p, "DD:DD")) return false;
+        int hours = number(offset + 1, 2), minutes = number(offset + 4, 2);
+        if (hours >= 24 || minutes >= 60) return false;
+        t.offsetMinutes = (*offset == '-' ? -1 : 1) * (hours * 60 + minutes);
+    }
+    if (*p != '\0') return false;
+
+    if (t.month < 1 || t.month > 12 || t.day < 1) return false;
+    int y, m, d;
+    civilFromDays(daysFromCivil(t.year, t.month, t.day), y, m, d);
+    return y == t.year && m == t.month && d == t.day && t.hour < 24 && t.minute < 60 && t.second <= 60;
+}
+
+static void checkAgainstReference(const char* text)
+{
+    IsoTimestamp parsed, expected;
+    bool ok = parseIsoTimestamp(text, parsed);
+    bool valid = referenceValid(text, expected);
+    if (ok != valid) 
+    {
+        char message[96];
+        snprintf(message, sizeof(message), "\"%s\" parsed %s", text, ok ? "but is invalid" : "failed but is valid");
+        TEST_FAIL_MESSAGE(message);
+    }
+    if (ok) 
+    {
+        TEST_ASSERT_EQUAL_MEMORY(&expected, &parsed, sizeof(parsed));
+        int minutes = -1;
+        TEST_ASSERT_TRUE(parseIsoUtcMinutes(text, minutes));
+        TEST_ASSERT_TRUE(minutes >= 0 && minutes < 1440);
+    }
+}
+
+//-----------------------------------------------------------------------------
+// Tests
+//-----------------------------------------------------------------------------
+static const char* const VALID[] = 
+{
+    "2024-06-21T03:43:27+00:00",
+    "2024-12-21T08:03:59Z",
+    "2024-02-29T23:59:60.123456-05:30",
+    "0001-01-01T00:00:00+14:00",
+    "9999-12-31T23:59:59.9-12:00",
+    "2000-02-29T12:00:00+23:59",
+};
+
+void setUp()
+{
+    seed = 12345;
+}
+
+void tearDown() {}
+
+void test_valid_timestamps()
+{
+    IsoTimestamp t;
+    TEST_ASSERT_TRUE(parseIsoTimestamp(VALID[2], t));
+    TEST_ASSERT_EQUAL(2024, t.year);
+    TEST_ASSERT_EQUAL(2, t.month);
+    TEST_ASSERT_EQUAL(29, t.day);
+    TEST_ASSERT_EQUAL(60, t.second);
+    TEST_ASSERT_EQUAL(-330, t.offsetMinutes);
+
+    int minutes;
+    TEST_ASSERT_TRUE(parseIsoUtcMinutes("2024-06-21T03:43:27+00:00", minutes));
+    TEST_ASSERT_EQUAL(3 * 60 + 43, minutes);
+    TEST_ASSERT_TRUE(parseIsoUtcMinutes("2024-06-21T01:00:00+02:30", minutes));
+    TEST_ASSERT_EQUAL(1440 - 90, minutes);
+    TEST_ASSERT_TRUE(parseIsoUtcMinutes("2024-06-21T23:00:00-05:00", minutes));
+    TEST_ASSERT_EQUAL(4 * 60, minutes);
+
+    for (const char* text : VALID) 
+    {
+        checkAgainstReference(text);
+    }
+}
+
+void test_malformed_timestamps()
+{
+    static const char* const MALFORMED[] = 
+    {
+        "", "2024", "2024-06-21", "2024-06-21T03:43", "2024-06-21T03:43:27",
+        "2024-06-21 03:43:27Z", "2024-06-21t03:43:27Z", " 2024-06-21T03:43:27Z",
+        "2024-06-21T03:43:27Z ", "2024-06-21T03:43:27ZZ", "2024-6-21T03:43:27Z",
+        "+024-06-21T03:43:27Z", "2024-06-21T03:43:27.Z", "2024-06-21T03:43:27+0000",
+        "2024-06-21T03:43:27+00", "2024-06-21T03:43:27+24:00", "2024-06-21T03:43:27+05:60",
+        "2023-02-29T00:00:00Z", "1900-02-29T00:00:00Z", "2024-04-31T00:00:00Z",
+        "2024-00-10T00:00:00Z", "2024-13-10T00:00:00Z", "2024-06-00T00:00:00Z",
+        "2024-06-21T24:00:00Z", "2024-06-21T23:60:00Z", "2024-06-21T23:59:61Z",
+        "2024-06-21T03:43:27\xff", "2024-06-21T03:4\0" "3:27Z", "２０２４-06-21T03:43:27Z",
+    };
+    IsoTimestamp t;
+    TEST_ASSERT_FALSE(parseIsoTimestamp(nullptr, t));
+    for (const char* text : MALFORMED) 
+    {
+        if (parseIsoTimestamp(text, t)) 
+        {
+            TEST_FAIL_MESSAGE(text);
+        }
+        checkAgainstReference(text);
+    }
+}
+
+void test_every_truncation_is_rejected()
+{
+    IsoTimestamp t;
+    for (const char* text : VALID) 
+    {
+        size_t length = strlen(text);
+        for (size_t cut = 0; cut < length; cut++) 
+        {
+            TEST_ASSERT_FALSE(parseExact(text, cut, t));
+        }
+        TEST_ASSERT_TRUE(parseExact(text, length, t));
+    }
+}
+
+void test_clock_times()
+{
+    int minutes;
+    TEST_ASSERT_TRUE(parseClockTime("08:42", minutes));
+    TEST_ASSERT_EQUAL(522, minutes);
+    TEST_ASSERT_TRUE(parseClockTime("7:05", minutes));
+    TEST_ASSERT_EQUAL(425, minutes);
+    TEST_ASSERT_TRUE(parseClockTime("23:59", minutes));
+
+    static const char* const BAD[] = 
+    {
+        "", ":", "7", "7:", "7:5", "07:5", "24:00", "12:60", "123:00", "12:345", " 1:00", "1:00 ", "-1:00", "ab:cd"
+    };
+    TEST_ASSERT_FALSE(parseClockTime(nullptr, minutes));
+    for (const char* text : BAD) 
+    {
+        if (parseClockTime(text, minutes)) 
+        {
+            TEST_FAIL_MESSAGE(text);
+        }
+    }
+}
+
+// Random edits of valid timestamps, drawn from the characters that matter
+void test_mutation_fuzz()
+{
+    static const char ALPHABET[] = "0123456789-:T.Z+ 9x";
+    const int seeds = sizeof(VALID) / sizeof(VALID[0]);
+    char text[48];
+    int accepted = 0;
+
+    for (int round = 0; round < FUZZ_ROUNDS; round++) 
+    {
+        snprintf(text, sizeof(text), "%s", VALID[nextRandom() % seeds]);
+        for (int edits = 1 + nextRandom() % 3; edits > 0; edits--) 
+        {
+            size_t length = strlen(text);
+            size_t at = nextRandom() % (length + 1);
+            char c = ALPHABET[nextRandom() % (sizeof(ALPHABET) - 1)];
+            switch (nextRandom() % 5) 
+            {
+            case 0:     // Replace
+                if (at < length) text[at] = c;
+                break;
+            case 1:     // Insert
+                if (length < sizeof(text) - 2) 
+                {
+                    memmove(&text[at + 1], &text[at], length - at + 1);
+                    text[at] = c;
+                }
+                break;
+            case 2:     // Delete
+                if (at < length) memmove(&text[at], &text[at + 1], length - at);
+                break;
+            case 3:     // Truncate
+                text[at] = '\0';
+                break;
+            default:    // Change a digit, often to a value out of range
+                if (at < length && text[at] >= '0' && text[at] <= '9') text[at] = '0' + nextRandom() % 10;
+                break;
+            }
+        }
+
+        IsoTimestamp t;
+        bool ok = parseExact(text, strlen(text), t);
+        accepted += ok;
+        checkAgainstReference(text);
+    }
+
+    char message[64];
+    snprintf(message, sizeof(message), "%d of %d mutations still valid", accepted, FUZZ_ROUNDS);
+    TEST_MESSAGE(message);
+    TEST_ASSERT_TRUE(accepted > 0 && accepted < FUZZ_ROUNDS);
+}
+
+//-----------------------------------------------------------------------------
+// Benchmark
+//-----------------------------------------------------------------------------
+#define BENCH_RUNS  200000
+
+template<typename Parse>
+static double nsPerCall(Parse parse)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < BENCH_RUNS; i++) 
+    {
+        parse();
+    }
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / BENCH_RUNS;
+}
+
+void test_parse_cost()
+{
+    static const char SAMPLE[] = "2024-06-21T03:43:27+00:00";
+    volatile int sink = 0;
+
+    double parse = nsPerCall([&]() {
+        int minutes = 0;
+        parseIsoUtcMinutes(SAMPLE, minutes);
+        sink = sink + minutes;
+    });
+    double scan = nsPerCall([&]() {
+        int y, mo, d, h, mi, s;
+        sscanf(SAMPLE, "%4d-%2d-%2dT%2d:%2d:%2d", &y, &mo, &d, &h, &mi, &s);
+        sink = sink + h * 60 + mi;
+    });
+
+    double library = nsPerCall([&]() {
+        struct tm t = {0};
+        strptime(SAMPLE, "%Y-%m-%dT%H:%M:%S+00:00", &t);
+        sink = sink + t.tm_hour * 60 + t.tm_min;
+    });
+
+    char message[128];
+    snprintf(message, sizeof(message), "parseIsoUtcMinutes %.1f ns, sscanf %.1f ns, strptime %.1f ns per call", 
+             parse, scan, library);
+    TEST_MESSAGE(message);
+
+    // The host C library is optimised and the test build may not be, so
+    // only the generic scanner is a fair bar here
+    TEST_ASSERT_TRUE(parse < scan);
+}
+
+int main(int argc, char** argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_valid_timestamps);
+    RUN_TEST(test_malformed_timestamps);
+    RUN_TEST(test_every_truncation_is_rejected);
+    RUN_TEST(test_clock_times);
+    RUN_TEST(test_mutation_fuzz);
+    RUN_TEST(test_parse_cost);
+    return UNITY_END();
+}
@@ -0,0 +1,213 @@
+#include <unity.h>
+#include <math.h>
+#include <stdio.h>
+#include "time_discipline.h"
+
+//-----------------------------------------------------------------------------
+// Clock discipline (time_discipline.cpp) against a simulated drifting RTC
+//-----------------------------------------------------------------------------
+// Three days per crystal, one second per step, with SNTP replies that carry
+// a few milliseconds of jitter. The clock's error must stay within
+// TIME_TARGET_ERROR_MS once the drift is known.
+
+#define ADJTIME_SHIFT       6           // ESP-IDF slews at 1/64 of elapsed time
+#define JITTER_US           5000
+#define SIMULATED_DAYS      3
+
+static uint32_t seed;
+
+static double jitter()
+{
+    seed = seed * 1664525UL + 1013904223UL;
+    return ((double)(seed >> 8) / (1 << 24) * 2.0 - 1.0) * JITTER_US / 1e6;
+}
+
+// ESP32 system time: an RTC off by ppm, plus ESP-IDF's adjtime()
+class SimulatedClock
+{
+public:
+    SimulatedClock(double trueTime, double ppm)
+        : rate(1.0 + ppm / 1e6), baseTrue(trueTime), baseLocal(0.0), slewTotal(0.0), slewStart(0.0) {}
+
+    double now(double trueTime) const         { return raw(trueTime) + applied(trueTime); }
+    double outstanding(double trueTime) const { return slewTotal - applied(trueTime); }
+
+    void adjtime(double trueTime, double delta)
+    {
+        baseLocal = now(trueTime);
+        baseTrue  = trueTime;
+        slewTotal = delta;
+        slewStart = baseLocal;
+    }
+
+    void settimeofday(double trueTime, double value)
+    {
+        baseLocal = value;
+        baseTrue  = trueTime;
+        slewTotal = 0.0;
+    }
+
+private:
+    double rate;
+    double baseTrue;
+    double baseLocal;           // Cold boot: 1970
+    double slewTotal;
+    double slewStart;
+
+    double raw(double trueTime) const { return baseLocal + (trueTime - baseTrue) * rate; }
+
+    double applied(double trueTime) const
+    {
+        double step = fmin(fabs(slewTotal), (raw(trueTime) - slewStart) / (1 << ADJTIME_SHIFT));
+        return slewTotal >= 0 ? step : -step;
+    }
+};
+
+static int64_t toUs(double seconds)
+{
+    return (int64_t)llround(seconds * 1e6);
+}
+
+struct RunResult
+{
+    float    driftPpm;
+    uint32_t intervalMs;
+    double   worstErrorMs;
+    int      steps;
+    int      slews;
+    int      backwards;
+};
+
+static RunResult simulate(double ppm)
+{
+    TimeDiscipline discipline;
+    DisplayClock   display;
+    RunResult      result = { 0, 0, 0, 0, 0, 0 };
+    double start = 1.7e9;
+    double trueTime = start;
+    SimulatedClock clock(trueTime, ppm);
+    double nextSync = trueTime + 2;
+    time_t lastShown = 0;
+    seed = 7;
+
+    while (trueTime < start + SIMULATED_DAYS * 24 * 3600) 
+    {
+        trueTime += 1;
+        if (trueTime >= nextSync) 
+        {
+            double server = trueTime + jitter();
+            TimeCorrection c = discipline.sync(toUs(server), toUs(clock.now(trueTime)), 
+                                               toUs(clock.outstanding(trueTime)));
+            if (c.step) 
+            {
+                clock.settimeofday(trueTime, server);
+                result.steps++;
+            }
+            else 
+            {
+                clock.adjtime(trueTime, c.slewUs / 1e6);
+                result.slews++;
+            }
+            nextSync = trueTime + discipline.intervalMs() / 1000.0;
+        }
+
+        time_t shown = display.show((time_t)clock.now(trueTime));
+        result.backwards += shown < lastShown;
+        lastShown = shown;
+
+        // Error once the drift is known and no correction is still being slewed in
+        if (discipline.driftKnown() && fabs(clock.outstanding(trueTime)) < 0.001) 
+        {
+            result.worstErrorMs = fmax(result.worstErrorMs, fabs(clock.now(trueTime) - trueTime) * 1000);
+        }
+    }
+    result.driftPpm   = discipline.driftPpm();
+    result.intervalMs = discipline.intervalMs();
+    return result;
+}
+
+static void checkCrystal(double ppm)
+{
+    RunResult r = simulate(ppm);
+    char message[160];
+    snprintf(message, sizeof(message), "%+6.1f ppm: estimate %+7.2f ppm, interval %5lu s, worst error %3.0f ms, "
+             "%d steps, %d slews", ppm, r.driftPpm, (unsigned long)(r.intervalMs / 1000), r.worstErrorMs, 
+             r.steps, r.slews);
+    TEST_MESSAGE(message);
+
+    uint32_t expected = TimeDiscipline::intervalForDrift((float)ppm);
+    TEST_ASSERT_FLOAT_WITHIN(fmax(1.0, fabs(ppm) * 0.05), ppm, r.driftPpm);
+    TEST_ASSERT_TRUE(fabs((double)r.intervalMs - expected) <= expected * 0.1);
+    TEST_ASSERT_TRUE(r.worstErrorMs < TIME_TARGET_ERROR_MS);
+    TEST_ASSERT_EQUAL(1, r.steps);
+    TEST_ASSERT_EQUAL(0, r.backwards);
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_slow_crystal()
+{
+    checkCrystal(-40.0);
+}
+
+void test_typical_crystal()
+{
+    checkCrystal(12.0);
+}
+
+void test_very_fast_crystal()
+{
+    // Out of spec for the module's crystal, but still inside TIME_SYNC_MIN_MS
+    checkCrystal(150.0);
+}
+
+void test_steps_only_beyond_slew_limit()
+{
+    TimeDiscipline discipline;
+    int64_t server = 1700000000LL * 1000000;
+    TimeCorrection c = discipline.sync(server, server - (TIME_SLEW_LIMIT_MS * 1000LL + 1), 0);
+    TEST_ASSERT_TRUE(c.step);
+
+    c = discipline.sync(server + 1000000, server + 1000000 - TIME_SLEW_LIMIT_MS * 1000LL, 0);
+    TEST_ASSERT_FALSE(c.step);
+    TEST_ASSERT_TRUE(c.slewUs == TIME_SLEW_LIMIT_MS * 1000LL);
+
+    // Drift is only measured over a long enough span
+    TEST_ASSERT_FALSE(discipline.driftKnown());
+    TEST_ASSERT_EQUAL_UINT32(TIME_SYNC_INITIAL_MS, discipline.intervalMs());
+}
+
+void test_interval_follows_drift()
+{
+    TEST_ASSERT_EQUAL_UINT32(TIME_SYNC_MAX_MS, TimeDiscipline::intervalForDrift(0.05f));
+    TEST_ASSERT_EQUAL_UINT32(TIME_SYNC_MAX_MS, TimeDiscipline::intervalForDrift(-2.0f));
+    TEST_ASSERT_EQUAL_UINT32(TIME_SYNC_MIN_MS, TimeDiscipline::intervalForDrift(400.0f));
+    TEST_ASSERT_UINT32_WITHIN(2, 25000000UL, TimeDiscipline::intervalForDrift(-10.0f));
+}
+
+void test_display_holds_small_backward_steps()
+{
+    DisplayClock display;
+    TEST_ASSERT_TRUE(display.show(1000) == 1000);
+    TEST_ASSERT_TRUE(display.show(995) == 1000);
+    TEST_ASSERT_TRUE(display.show(999) == 1000);
+    TEST_ASSERT_TRUE(display.show(1001) == 1001);
+    TEST_ASSERT_EQUAL_UINT32(1, display.holds());
+
+    // A large step back is a real correction
+    TEST_ASSERT_TRUE(display.show(1001 - TIME_HOLD_LIMIT_S - 1) == 1001 - TIME_HOLD_LIMIT_S - 1);
+    TEST_ASSERT_EQUAL_UINT32(1, display.holds());
+}
+
+int main(int argc, char** argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_slow_crystal);
+    RUN_TEST(test_typical_crystal);
+    RUN_TEST(test_very_fast_crystal);
+    RUN_TEST(test_steps_only_beyond_slew_limit);
+    RUN_TEST(test_interval_follows_drift);
+    RUN_TEST(test_display_holds_small_backward_steps);
+    return UNITY_END();
+}
@@ -0,0 +1,272 @@
+#include <unity.h>
+#include <stdio.h>
+#include <WiFi.h>
+#include "web_server.h"
+#include "log.h"
+
+//-----------------------------------------------------------------------------
+// HTTP server (web_server.cpp): routing and responses from raw request
+// text, and the socket layer against a scripted client
+//-----------------------------------------------------------------------------
+static char response[8192];
+static char lastQuery[192];
+static int  bigLines;
+
+static void handleEcho(ResponseWriter& out, const char* query)
+{
+    snprintf(lastQuery, sizeof(lastQuery), "%s", query);
+    out.printf("query=%s\n", query);
+}
+
+static void handleChange(ResponseWriter& out, const char* query)
+{
+    out.print("{\"changed\":");
+    out.printJson(query);
+    out.print("}");
+}
+
+static void handleBig(ResponseWriter& out, const char* query)
+{
+    for (int i = 0; i < bigLines; i++) 
+    {
+        out.printf("astroclock_test_metric{line=\"%d\"} %d\n", i, i * 7);
+    }
+}
+
+// Body of a response, after the blank line
+static const char* bodyOf(const char* text)
+{
+    const char* body = strstr(text, "\r\n\r\n");
+    return body ? body + 4 : "";
+}
+
+static unsigned contentLength(const char* text)
+{
+    const char* header = strstr(text, "Content-Length: ");
+    return header ? (unsigned)strtoul(header + 16, nullptr, 10) : 0;
+}
+
+// The response is sent by length; terminate it here to read it as text
+static size_t request(const char* text)
+{
+    size_t length = webHandleRequest(text, response, sizeof(response) - 1);
+    response[length] = '\0';
+    return length;
+}
+
+void setUp()
+{
+    static bool registered = false;
+    if (!registered) 
+    {
+        webRegister("/echo", "application/json", handleEcho);
+        webRegister("/big", "text/plain", handleBig);
+        webRegisterPost("/change", "application/json", handleChange);
+        webBegin(80);
+        registered = true;
+    }
+    bigLines = 10;
+    lastQuery[0] = '\0';
+}
+
+void tearDown() {}
+
+void test_routes_to_handler()
+{
+    size_t length = request("GET /echo?a=1&b=two HTTP/1.1\r\nHost: clock\r\n\r\n");
+    TEST_ASSERT_EQUAL(strlen(response), length);
+    TEST_ASSERT_EQUAL(0, strncmp(response, "HTTP/1.0 200 OK\r\n", 17));
+    TEST_ASSERT_NOT_NULL(strstr(response, "Content-Type: application/json\r\n"));
+    TEST_ASSERT_EQUAL_STRING("a=1&b=two", lastQuery);
+    TEST_ASSERT_EQUAL_STRING("query=a=1&b=two\n", bodyOf(response));
+    TEST_ASSERT_EQUAL(strlen(bodyOf(response)), contentLength(response));
+}
+
+void test_unknown_path_is_404()
+{
+    request("GET /missing HTTP/1.1\r\n");
+    TEST_ASSERT_EQUAL(0, strncmp(response, "HTTP/1.0 404 Not Found\r\n", 24));
+    TEST_ASSERT_EQUAL_STRING("Not found\n", bodyOf(response));
+
+    // Anything but a GET request line finds no route
+    request("BREW /echo HTTP/1.1\r\n");
+    TEST_ASSERT_EQUAL(0, strncmp(response, "HTTP/1.0 404", 12));
+    request("");
+    TEST_ASSERT_EQUAL(0, strncmp(response, "HTTP/1.0 404", 12));
+}
+
+void test_post_routes_need_post()
+{
+    request("POST /change?a=1 HTTP/1.1\r\nContent-Length: 0\r\n\r\n");
+    TEST_ASSERT_EQUAL(0, strncmp(response, "HTTP/1.0 200 OK\r\n", 17));
+    TEST_ASSERT_EQUAL_STRING("{\"changed\":\"a=1\"}", bodyOf(response));
+
+    request("GET /change?a=1 HTTP/1.1\r\n");
+    TEST_ASSERT_EQUAL(0, strncmp(response, "HTTP/1.0 405 Method Not Allowed\r\n", 33));
+    request("POST /echo HTTP/1.1\r\n");
+    TEST_ASSERT_EQUAL(0, strncmp(response, "HTTP/1.0 405", 12));
+    request("POST /missing HTTP/1.1\r\n");
+    TEST_ASSERT_EQUAL(0, strncmp(response, "HTTP/1.0 404", 12));
+}
+
+void test_json_strings_are_escaped()
+{
+    char text[64];
+    ResponseWriter out(text, sizeof(text));
+    out.printJson("say \"hi\"\\ \x01\n\xC3\xA9");
+    TEST_ASSERT_EQUAL_STRING("\"say \\\"hi\\\"\\\\ \\u0001\\u000a\xC3\xA9\"", text);
+    TEST_ASSERT_FALSE(out.overflow());
+
+    ResponseWriter small(text, 8);
+    small.printJson("0123456789");
+    TEST_ASSERT_TRUE(small.overflow());
+    TEST_ASSERT_EQUAL(7, small.length());
+}
+
+void test_query_params_are_decoded()
+{
+    const char* query = "name=Sun+Clock&city=S%C3%A3o%20Paulo&&flag&bad=%zz&last=";
+    char key[16], value[32];
+
+    TEST_ASSERT_TRUE(webQueryParam(query, key, sizeof(key), value, sizeof(value)));
+    TEST_ASSERT_EQUAL_STRING("name", key);
+    TEST_ASSERT_EQUAL_STRING("Sun Clock", value);
+    TEST_ASSERT_TRUE(webQueryParam(query, key, sizeof(key), value, sizeof(value)));
+    TEST_ASSERT_EQUAL_STRING("city", key);
+    TEST_ASSERT_EQUAL_STRING("S\xC3\xA3o Paulo", value);
+    TEST_ASSERT_TRUE(webQueryParam(query, key, sizeof(key), value, sizeof(value)));
+    TEST_ASSERT_EQUAL_STRING("flag", key);
+    TEST_ASSERT_EQUAL_STRING("", value);
+    TEST_ASSERT_TRUE(webQueryParam(query, key, sizeof(key), value, sizeof(value)));
+    TEST_ASSERT_EQUAL_STRING("%zz", value);
+    TEST_ASSERT_TRUE(webQueryParam(query, key, sizeof(key), value, sizeof(value)));
+    TEST_ASSERT_EQUAL_STRING("last", key);
+    TEST_ASSERT_FALSE(webQueryParam(query, key, sizeof(key), value, sizeof(value)));
+
+    // Overlong values are cut to fit, the rest is skipped
+    query = "k=0123456789abcdef&next=1";
+    char small[8];
+    TEST_ASSERT_TRUE(webQueryParam(query, key, sizeof(key), small, sizeof(small)));
+    TEST_ASSERT_EQUAL_STRING("0123456", small);
+    TEST_ASSERT_TRUE(webQueryParam(query, key, sizeof(key), value, sizeof(value)));
+    TEST_ASSERT_EQUAL_STRING("next", key);
+}
+
+void test_response_that_does_not_fit_is_500()
+{
+    bigLines = 100;
+    request("GET /big HTTP/1.1\r\n");
+    TEST_ASSERT_EQUAL(0, strncmp(response, "HTTP/1.0 200 OK", 15));
+    TEST_ASSERT_EQUAL(strlen(bodyOf(response)), contentLength(response));
+
+    uint32_t before = webTooLargeResponses();
+    bigLines = 1000;
+    size_t length = request("GET /big HTTP/1.1\r\n");
+    TEST_ASSERT_EQUAL(0, strncmp(response, "HTTP/1.0 500 Internal Server Error\r\n", 36));
+    TEST_ASSERT_EQUAL_STRING("Response too large\n", bodyOf(response));
+    TEST_ASSERT_EQUAL(strlen(response), length);
+    TEST_ASSERT_EQUAL_UINT32(before + 1, webTooLargeResponses());
+}
+
+void test_error_page_that_does_not_fit_is_500()
+{
+    // Room for the headers (160 bytes) and 5 of body: even "Not found" and
+    // "Method not allowed" overflow, with no route behind them
+    char small[165];
+    uint32_t before = webTooLargeResponses();
+
+    size_t length = webHandleRequest("GET /missing HTTP/1.1\r\n", small, sizeof(small));
+    TEST_ASSERT_TRUE(length > 0);
+    TEST_ASSERT_EQUAL(0, strncmp(small, "HTTP/1.0 500 ", 13));
+
+    length = webHandleRequest("POST /echo HTTP/1.1\r\n", small, sizeof(small));
+    TEST_ASSERT_TRUE(length > 0);
+    TEST_ASSERT_EQUAL(0, strncmp(small, "HTTP/1.0 500 ", 13));
+    TEST_ASSERT_EQUAL_UINT32(before + 2, webTooLargeResponses());
+}
+
+void test_routes_past_the_limit_are_reported()
+{
+    // No log task runs on the host, so each log statement counts as a drop
+    static const char* const EXTRA[] = { "/r1", "/r2", "/r3", "/r4", "/r5", "/r6" };
+    uint32_t before = logDropped();
+    for (const char* path : EXTRA) 
+    {
+        webRegister(path, "text/plain", handleEcho);
+    }
+
+    // Three routes were registered in setUp(), so five of these fit
+    TEST_ASSERT_EQUAL_UINT32(before + 1, logDropped());
+    request("GET /r5 HTTP/1.1\r\n");
+    TEST_ASSERT_EQUAL(0, strncmp(response, "HTTP/1.0 200 OK", 15));
+    request("GET /r6 HTTP/1.1\r\n");
+    TEST_ASSERT_EQUAL(0, strncmp(response, "HTTP/1.0 404 ", 13));
+}
+
+void test_tiny_buffer_gives_no_response()
+{
+    char small[64];
+    TEST_ASSERT_EQUAL(0, webHandleRequest("GET /echo HTTP/1.1\r\n", small, sizeof(small)));
+}
+
+void test_poll_serves_one_client()
+{
+    static StubPeer peer;
+    stubPeerInit(peer, "GET /echo?x=%41 HTTP/1.1\r\nHost: clock\r\n\r\n", false);
+    stubAccept(peer);
+    webPoll();
+
+    TEST_ASSERT_FALSE(peer.open);
+    TEST_ASSERT_EQUAL(0, strncmp(peer.sent, "HTTP/1.0 200 OK\r\n", 17));
+    TEST_ASSERT_EQUAL_STRING("query=x=%41\n", bodyOf(peer.sent));
+
+    // Nothing waiting, nothing sent
+    webPoll();
+    TEST_ASSERT_EQUAL(0, strncmp(peer.sent, "HTTP/1.0 200 OK\r\n", 17));
+}
+
+void test_poll_gives_up_on_slow_client()
+{
+    // One byte every 5 ms: the request line is not complete by the deadline
+    static StubPeer peer;
+    stubPeerInit(peer, "GET /echo?slow=1 HTTP/1.1\r\n", false);
+    peer.msPerByte = 5;
+    stubAccept(peer);
+    unsigned long start = millis();
+    webPoll();
+
+    TEST_ASSERT_TRUE(millis() - start <= 25);
+    TEST_ASSERT_FALSE(peer.open);
+    TEST_ASSERT_EQUAL(0, strncmp(peer.sent, "HTTP/1.0 404", 12));
+}
+
+void test_poll_large_response_in_one_write()
+{
+    static StubPeer peer;
+    bigLines = 150;
+    stubPeerInit(peer, "GET /big HTTP/1.1\r\n", false);
+    stubAccept(peer);
+    webPoll();
+
+    TEST_ASSERT_EQUAL(0, strncmp(peer.sent, "HTTP/1.0 200 OK", 15));
+    TEST_ASSERT_TRUE(contentLength(peer.sent) > 5000);
+    TEST_ASSERT_EQUAL(strlen(bodyOf(peer.sent)), contentLength(peer.sent));
+}
+
+int main(int argc, char** argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_routes_to_handler);
+    RUN_TEST(test_unknown_path_is_404);
+    RUN_TEST(test_post_routes_need_post);
+    RUN_TEST(test_json_strings_are_escaped);
+    RUN_TEST(test_query_params_are_decoded);
+    RUN_TEST(test_response_that_does_not_fit_is_500);
+    RUN_TEST(test_error_page_that_does_not_fit_is_500);
+    RUN_TEST(test_tiny_buffer_gives_no_response);
+    RUN_TEST(test_poll_serves_one_client);
+    RUN_TEST(test_poll_gives_up_on_slow_client);
+    RUN_TEST(test_poll_large_response_in_one_write);
+    RUN_TEST(test_routes_past_the_limit_are_reported);
+    return UNITY_END();
+}
@@ -0,0 +1,157 @@
+#!/usr/bin/env python3
+"""Local stand-in NTP server, for testing the clock's drift tracking.
+
+Answers SNTP requests with this PC's time plus a fixed offset, optionally
+running fast or slow by a set number of ppm and with random jitter. A
+reference that drifts against the clock looks, to the clock, exactly like
+its own RTC drifting, so hours of drift can be watched in minutes:
+
+    sudo mock_ntp.py --drift-ppm 500 --offset-ms 2000
+
+Point the clock at it by building with
+    -D NTP_SERVER='"<host-ip>"'
+and use the "time" serial command, or /metrics, to follow the measured
+offset, the drift estimate and the sync interval it picks. Port 123 needs
+root (or CAP_NET_BIND_SERVICE), as the clock always asks on port 123.
+
+--selftest checks the responder itself: over a simulated day, each reply
+carries the requested offset and drift, within the jitter. The clock's own
+sync logic (src/time_discipline.cpp) is tested against a simulated drifting
+RTC by the host tests in test/test_time_sync (pio test -e native).
+
+Usage:
+    mock_ntp.py [--port 123] [--offset-ms 0] [--drift-ppm 0] [--jitter-ms 0]
+    mock_ntp.py --selftest
+"""
+
+import argparse
+import random
+import socket
+import struct
+import sys
+import threading
+import time
+
+NTP_EPOCH_OFFSET = 2208988800       # 1900-01-01 to 1970-01-01
+
+
+def to_ntp(seconds):
+    whole = int(seconds)
+    return whole + NTP_EPOCH_OFFSET, int((seconds - whole) * 2**32) & 0xFFFFFFFF
+
+
+def from_ntp(whole, fraction):
+    return whole - NTP_EPOCH_OFFSET + fraction / 2**32
+
+
+# ---------------------------------------------------------------------------
+# Responder
+# ---------------------------------------------------------------------------
+class ReferenceClock:
+    """The time served: a base clock with an offset, a rate error and jitter."""
+
+    def __init__(self, offset_ms=0.0, drift_ppm=0.0, jitter_ms=0.0, base=time.time):
+        self.base = base
+        self.start = base()
+        self.offset = offset_ms / 1000
+        self.drift = drift_ppm / 1e6
+        self.jitter = jitter_ms / 1000
+
+    def now(self):
+        t = self.base()
+        return t + self.offset + (t - self.start) * self.drift + random.uniform(-self.jitter, self.jitter)
+
+
+def ntp_response(request, clock):
+    """Server reply (mode 4, stratum 2) to a client request, or None."""
+    if len(request) < 48 or request[0] & 0x07 != 3:
+        return None
+    now = clock.now()
+    version = (request[0] >> 3) & 0x07
+    received = to_ntp(now)
+    return struct.pack("!BBbb11I", (version << 3) | 4, 2, 6, -20, 0, 0, 0x4C4F434C,  # "LOCL"
+                       *to_ntp(now - 1), *struct.unpack("!II", request[40:48]), *received, *to_ntp(now))
+
+
+def serve(port, clock, quiet=False):
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    sock.bind(("", port))
+
+    def loop():
+        while True:
+            request, address = sock.recvfrom(512)
+            reply = ntp_response(request, clock)
+            if reply is not None:
+                sock.sendto(reply, address)
+                if not quiet:
+                    print("%s %s reference %+.3f s" % (time.strftime("%H:%M:%S"), address[0],
+                                                       clock.now() - clock.base()), flush=True)
+
+    threading.Thread(target=loop, daemon=True).start()
+    return sock
+
+
+def query(port, transmit_time):
+    """One SNTP client request; returns the server's transmit time."""
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    sock.settimeout(2)
+    request = struct.pack("!B47x", (4 << 3) | 3)[:40] + struct.pack("!II", *to_ntp(transmit_time))
+    sock.sendto(request, ("127.0.0.1", port))
+    reply, _ = sock.recvfrom(512)
+    sock.close()
+    fields = struct.unpack("!BBbb11I", reply[:48])
+    if fields[0] & 0x07 != 4 or (fields[9], fields[10]) != to_ntp(transmit_time):
+        raise ValueError("bad reply")
+    return from_ntp(fields[13], fields[14])
+
+
+# ---------------------------------------------------------------------------
+# Self test: the responder serves the reference it was asked for
+# ---------------------------------------------------------------------------
+def selftest():
+    # The reference runs on virtual time so a day passes in a moment
+    virtual = [1.7e9]
+    offset_ms, drift_ppm, jitter_ms = 2000.0, 500.0, 5.0
+    reference = ReferenceClock(offset_ms, drift_ppm, jitter_ms, base=lambda: virtual[0])
+    sock = serve(0, reference, quiet=True)
+    port = sock.getsockname()[1]
+
+    failures = 0
+    for elapsed in (0, 60, 3600, 6 * 3600, 24 * 3600):
+        virtual[0] = 1.7e9 + elapsed
+        expected = virtual[0] + offset_ms / 1000 + elapsed * drift_ppm / 1e6
+        served = query(port, virtual[0])
+        # NTP timestamps resolve to 2^-32 s; allow a microsecond beyond the jitter
+        ok = abs(served - expected) <= jitter_ms / 1000 + 1e-6
+        print("%6d s  %-4s served %+9.3f ms from this PC, expected %+9.3f ms" % (
+            elapsed, "ok" if ok else "FAIL", (served - virtual[0]) * 1000, (expected - virtual[0]) * 1000))
+        failures += not ok
+    sock.close()
+    return 1 if failures else 0
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--port", type=int, default=123)
+    parser.add_argument("--offset-ms", type=float, default=0.0, help="reference ahead of this PC by")
+    parser.add_argument("--drift-ppm", type=float, default=0.0, help="reference runs fast by")
+    parser.add_argument("--jitter-ms", type=float, default=0.0, help="random error per reply, +/-")
+    parser.add_argument("--selftest", action="store_true", help="check the responder and exit")
+    args = parser.parse_args()
+
+    if args.selftest:
+        return selftest()
+
+    serve(args.port, ReferenceClock(args.offset_ms, args.drift_ppm, args.jitter_ms))
+    print("Mock NTP server on port %d, offset %+.0f ms, drift %+.1f ppm" % (
+        args.port, args.offset_ms, args.drift_ppm), flush=True)
+    try:
+        while True:
+            time.sleep(3600)
+    except KeyboardInterrupt:
+        pass
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
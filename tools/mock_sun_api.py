@@ -0,0 +1,241 @@
+#!/usr/bin/env python3
+"""Local stand-in for api.sunrise-sunset.org, for testing the fetch path.
+
+Answers /json?lat=..&lng=..&date=YYYY-MM-DD&formatted=0 for any date and
+location with the same fields as the real API, calculated with the NOAA
+approximation used by the clock (src/sun_calc.cpp). Connections are kept
+alive, as the clock reuses one connection for a whole prefetch.
+
+Faults can be injected from the start or switched at run time:
+    latency     delay every response by --latency-ms
+    truncate    cut the body off half way
+    error       answer 503
+    malformed   timestamps that are not ISO-8601
+    missing     results without sunrise/sunset fields
+    mixed       a random choice of the above per request
+
+    curl 'http://localhost:8080/_fault?mode=truncate&rate=0.5&latency_ms=2000'
+
+Point the clock at it by building with
+    -D SUN_API_URL='"http://<host-ip>:8080/json"'
+then use the "fetch now" and "fetch" serial commands, or /metrics, to see
+the end-to-end fetch and parse time and how each fault was handled. Every
+request is logged here with the fault served and the time taken.
+
+Usage:
+    mock_sun_api.py [--port 8080] [--fault MODE] [--rate 1.0] [--latency-ms 0]
+    mock_sun_api.py --selftest
+"""
+
+import argparse
+import datetime
+import http.client
+import http.server
+import json
+import math
+import random
+import sys
+import threading
+import time
+import urllib.parse
+
+FAULTS = ["none", "latency", "truncate", "error", "malformed", "missing", "mixed"]
+
+
+# ---------------------------------------------------------------------------
+# Solar times (same model as calcSunTimes)
+# ---------------------------------------------------------------------------
+def sun_times(latitude, longitude, date):
+    """Sunrise, solar noon and sunset in UTC minutes, and day length in seconds."""
+    gamma = 2 * math.pi / 365 * (date.timetuple().tm_yday - 1)
+    eq_time = 229.18 * (0.000075 + 0.001868 * math.cos(gamma) - 0.032077 * math.sin(gamma)
+                        - 0.014615 * math.cos(2 * gamma) - 0.040849 * math.sin(2 * gamma))
+    decl = (0.006918 - 0.399912 * math.cos(gamma) + 0.070257 * math.sin(gamma)
+            - 0.006758 * math.cos(2 * gamma) + 0.000907 * math.sin(2 * gamma)
+            - 0.002697 * math.cos(3 * gamma) + 0.00148 * math.sin(3 * gamma))
+    lat = math.radians(latitude)
+    noon = 720 - 4 * longitude - eq_time
+    cos_ha = (math.cos(math.radians(90.833)) / (math.cos(lat) * math.cos(decl))
+              - math.tan(lat) * math.tan(decl))
+    ha = 4 * math.degrees(math.acos(max(-1.0, min(1.0, cos_ha))))
+    return noon - ha, noon, noon + ha, int(round(2 * ha * 60))
+
+
+def iso(date, minutes):
+    moment = datetime.datetime(date.year, date.month, date.day, tzinfo=datetime.timezone.utc)
+    moment += datetime.timedelta(minutes=minutes)
+    return moment.strftime("%Y-%m-%dT%H:%M:%S+00:00")
+
+
+def response_body(query, fault):
+    latitude = float(query.get("lat", ["0"])[0])
+    longitude = float(query.get("lng", ["0"])[0])
+    text = query.get("date", [None])[0]
+    date = datetime.date.fromisoformat(text) if text else datetime.datetime.now(datetime.timezone.utc).date()
+
+    sunrise, noon, sunset, day_length = sun_times(latitude, longitude, date)
+    results = {
+        "sunrise": iso(date, sunrise),
+        "sunset": iso(date, sunset),
+        "solar_noon": iso(date, noon),
+        "day_length": day_length,
+    }
+    if fault == "malformed":
+        results["sunrise"] = "7:61 AM"
+        results["sunset"] = "2024-13-45T25:99"
+        results["solar_noon"] = ""
+    elif fault == "missing":
+        del results["sunrise"]
+        del results["sunset"]
+    return json.dumps({"results": results, "status": "OK", "tzid": "UTC"}).encode()
+
+
+# ---------------------------------------------------------------------------
+# Server
+# ---------------------------------------------------------------------------
+class FaultSettings:
+    def __init__(self, mode, rate, latency_ms):
+        self.lock = threading.Lock()
+        self.mode = mode
+        self.rate = rate
+        self.latency_ms = latency_ms
+
+    def pick(self):
+        """Fault to apply to the next request."""
+        with self.lock:
+            mode, rate = self.mode, self.rate
+        if mode == "none" or random.random() >= rate:
+            return "none"
+        if mode == "mixed":
+            return random.choice(FAULTS[1:-1])
+        return mode
+
+
+class MockHandler(http.server.BaseHTTPRequestHandler):
+    protocol_version = "HTTP/1.1"      # Keep-alive, like the real API
+    settings = None
+    quiet = False
+
+    def log_message(self, fmt, *args):
+        pass
+
+    def send_body(self, code, body, content_type="application/json", length=None):
+        self.send_response(code)
+        self.send_header("Content-Type", content_type)
+        self.send_header("Content-Length", str(len(body) if length is None else length))
+        self.end_headers()
+        self.wfile.write(body)
+
+    def do_GET(self):
+        start = time.monotonic()
+        url = urllib.parse.urlsplit(self.path)
+        query = urllib.parse.parse_qs(url.query)
+
+        if url.path == "/_fault":
+            with self.settings.lock:
+                self.settings.mode = query.get("mode", [self.settings.mode])[0]
+                self.settings.rate = float(query.get("rate", [self.settings.rate])[0])
+                self.settings.latency_ms = int(query.get("latency_ms", [self.settings.latency_ms])[0])
+                state = {"mode": self.settings.mode, "rate": self.settings.rate,
+                         "latency_ms": self.settings.latency_ms}
+            self.send_body(200, json.dumps(state).encode())
+            return
+        if url.path != "/json":
+            self.send_body(404, b"not found\n", "text/plain")
+            return
+
+        fault = self.settings.pick()
+        if fault == "latency":
+            time.sleep(self.settings.latency_ms / 1000)
+
+        if fault == "error":
+            self.send_body(503, b'{"status":"UNAVAILABLE"}')
+        else:
+            body = response_body(query, fault)
+            if fault == "truncate":
+                # Promise the whole body, send half, then drop the connection
+                self.send_body(200, body[:len(body) // 2], length=len(body))
+                self.close_connection = True
+            else:
+                self.send_body(200, body)
+
+        if not self.quiet:
+            print("%s %-9s %6.1f ms  %s" % (time.strftime("%H:%M:%S"), fault,
+                                            (time.monotonic() - start) * 1000, self.path), flush=True)
+
+
+def serve(port, settings):
+    MockHandler.settings = settings
+    server = http.server.ThreadingHTTPServer(("", port), MockHandler)
+    server.daemon_threads = True
+    return server
+
+
+# ---------------------------------------------------------------------------
+# Self test
+# ---------------------------------------------------------------------------
+def selftest():
+    """Check the response to every fault mode against a local instance."""
+    settings = FaultSettings("none", 1.0, 0)
+    MockHandler.quiet = True
+    server = serve(0, settings)
+    threading.Thread(target=server.serve_forever, daemon=True).start()
+    port = server.server_address[1]
+    path = "/json?lat=51.4785810&lng=-0.0012920&date=2024-06-21&formatted=0"
+    failures = 0
+
+    def fetch(conn):
+        conn.request("GET", path)
+        response = conn.getresponse()
+        return response.status, response.read()
+
+    for mode in FAULTS[:-1]:
+        settings.mode, settings.latency_ms = mode, 200
+        conn = http.client.HTTPConnection("localhost", port, timeout=5)
+        start = time.monotonic()
+        try:
+            status, body = fetch(conn)
+            results = json.loads(body).get("results", {}) if status == 200 else {}
+            outcome = "HTTP %d, sunrise %s" % (status, results.get("sunrise"))
+            ok = {
+                "none": status == 200 and results.get("sunrise", "").startswith("2024-06-21T03:4"),
+                "latency": status == 200 and time.monotonic() - start >= 0.2,
+                "error": status == 503,
+                "malformed": status == 200 and ":" not in results.get("solar_noon", ":"),
+                "missing": status == 200 and "sunrise" not in results,
+            }.get(mode, False)
+        except (http.client.HTTPException, ValueError) as error:
+            outcome = "%s: %s" % (type(error).__name__, error)
+            ok = mode == "truncate"
+        elapsed = (time.monotonic() - start) * 1000
+        print("%-9s %-5s %6.1f ms  %s" % (mode, "ok" if ok else "FAIL", elapsed, outcome))
+        failures += not ok
+        conn.close()
+
+    server.shutdown()
+    return 1 if failures else 0
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--port", type=int, default=8080)
+    parser.add_argument("--fault", choices=FAULTS, default="none")
+    parser.add_argument("--rate", type=float, default=1.0, help="share of requests that get the fault")
+    parser.add_argument("--latency-ms", type=int, default=3000)
+    parser.add_argument("--selftest", action="store_true", help="check each fault mode and exit")
+    args = parser.parse_args()
+
+    if args.selftest:
+        return selftest()
+
+    server = serve(args.port, FaultSettings(args.fault, args.rate, args.latency_ms))
+    print("Mock sunrise-sunset API on port %d, fault %s" % (args.port, args.fault), flush=True)
+    try:
+        server.serve_forever()
+    except KeyboardInterrupt:
+        pass
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
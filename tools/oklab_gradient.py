@@ -0,0 +1,196 @@
+#!/usr/bin/env python3
+"""Render the clock's twilight gradients as an image, for checking by eye.
+
+Draws each gradient three ways, one band each:
+    rgb         a plain RGB blend (FastLED blend())
+    oklab       OKLab with exact cube roots
+    table       OKLab with the clock's table cube root (src/oklab.cpp)
+at full value and at the default BRIGHTNESS of 50, where the low channel
+values show any banding. The image is a binary PPM, which most viewers
+open, so no imaging library is needed:
+
+    oklab_gradient.py --image twilight.ppm
+
+--selftest checks the table against exact cube roots over every LED colour
+on the grey axis and the primaries, and checks that every table gradient
+matches the exact one to within one step per channel. Keep the constants
+here in step with src/oklab.cpp and TwilightLayer in include/layers.h.
+
+Usage:
+    oklab_gradient.py [--image PATH] [--leds 32] [--scale 12]
+    oklab_gradient.py --selftest
+"""
+
+import argparse
+import sys
+
+CBRT_STEPS = 128
+BRIGHTNESS = 50
+
+# Twilight edge to daylight (TwilightLayer), and a wider pair for contrast
+GRADIENTS = [
+    ((12, 2, 6), (0, 0, 8)),
+    ((255, 96, 0), (0, 64, 255)),
+    ((255, 0, 0), (0, 255, 0)),
+]
+
+TO_LMS = ((0.4122214708, 0.5363325363, 0.0514459929),
+          (0.2119034982, 0.6806995451, 0.1073969566),
+          (0.0883024619, 0.2817188376, 0.6299787005))
+TO_LAB = ((0.2104542553, 0.7936177850, -0.0040720468),
+          (1.9779984951, -2.4285922050, 0.4505937099),
+          (0.0259040371, 0.7827717662, -0.8086757660))
+FROM_LAB = ((1.0, 0.3963377774, 0.2158037573),
+            (1.0, -0.1055613458, -0.0638541728),
+            (1.0, -0.0894841775, -1.2914855480))
+FROM_LMS = ((4.0767416621, -3.3077115913, 0.2309699292),
+            (-1.2684380046, 2.6097574011, -0.3413193965),
+            (-0.0041960863, -0.7034186147, 1.7076147010))
+
+TABLE = [(i / CBRT_STEPS) ** (1 / 3) for i in range(CBRT_STEPS + 1)]
+
+
+# ---------------------------------------------------------------------------
+# Colour maths (same steps as src/oklab.cpp)
+# ---------------------------------------------------------------------------
+def mul(matrix, v):
+    return tuple(sum(m * x for m, x in zip(row, v)) for row in matrix)
+
+
+def cbrt_exact(x):
+    return x ** (1 / 3) if x > 0 else 0.0
+
+
+def cbrt_table(x):
+    if x <= 0:
+        return 0.0
+    scale = 1.0
+    n = 0
+    while x < 0.125 and n < 8:
+        x *= 8
+        scale *= 0.5
+        n += 1
+    pos = x * CBRT_STEPS
+    i = int(pos)
+    if i >= CBRT_STEPS:
+        return scale * TABLE[CBRT_STEPS]
+    return scale * (TABLE[i] + (TABLE[i + 1] - TABLE[i]) * (pos - i))
+
+
+def to_lab(rgb, cbrt):
+    lms = mul(TO_LMS, [c / 255 for c in rgb])
+    return mul(TO_LAB, [cbrt(v) for v in lms])
+
+
+def to_rgb(lab):
+    lms = [v ** 3 for v in mul(FROM_LAB, lab)]
+    return tuple(max(0, min(255, int(v * 255 + 0.5))) for v in mul(FROM_LMS, lms))
+
+
+def gradient_oklab(start, end, count, cbrt):
+    a, b = to_lab(start, cbrt), to_lab(end, cbrt)
+    out = [start]
+    for i in range(1, count - 1):
+        t = i / (count - 1)
+        out.append(to_rgb([x + (y - x) * t for x, y in zip(a, b)]))
+    return out + [end]
+
+
+def gradient_rgb(start, end, count):
+    # FastLED blend(): scale8 of each end by 255 - t and t
+    out = []
+    for i in range(count):
+        t = i * 255 // (count - 1)
+        out.append(tuple((x * (255 - t) >> 8) + (y * t >> 8) for x, y in zip(start, end)))
+    return out
+
+
+def dim(colors, brightness):
+    return [tuple(c * brightness >> 8 for c in color) for color in colors]
+
+
+# ---------------------------------------------------------------------------
+# Image
+# ---------------------------------------------------------------------------
+def render(path, leds, scale):
+    rows = []
+    for start, end in GRADIENTS:
+        bands = [gradient_rgb(start, end, leds),
+                 gradient_oklab(start, end, leds, cbrt_exact),
+                 gradient_oklab(start, end, leds, cbrt_table)]
+        for brightness in (255, BRIGHTNESS):
+            for band in bands:
+                shown = dim(band, brightness)
+                if brightness != 255:
+                    # Stretch the dimmed values back up so the steps are visible
+                    shown = [tuple(min(255, c * 255 // brightness) for c in color) for color in shown]
+                rows.extend([shown] * scale)
+            rows.append([(40, 40, 40)] * leds)
+        rows.extend([[(0, 0, 0)] * leds] * scale)
+
+    width, height = leds * scale, len(rows)
+    with open(path, "wb") as f:
+        f.write(b"P6 %d %d 255\n" % (width, height))
+        for row in rows:
+            f.write(bytes(c for color in row for _ in range(scale) for c in color))
+    print("Wrote %s (%dx%d): per gradient, rgb / oklab / table at full value, then at brightness %d"
+          % (path, width, height, BRIGHTNESS))
+
+
+# ---------------------------------------------------------------------------
+# Self test
+# ---------------------------------------------------------------------------
+def selftest():
+    failures = 0
+
+    worst = 0.0
+    for v in range(1, 256):
+        for rgb in ((v, v, v), (v, 0, 0), (0, v, 0), (0, 0, v)):
+            fast, exact = to_lab(rgb, cbrt_table), to_lab(rgb, cbrt_exact)
+            worst = max(worst, max(abs(x - y) for x, y in zip(fast, exact)))
+            if to_rgb(fast) != rgb:
+                print("round trip of %s gives %s" % (rgb, to_rgb(fast)))
+                failures += 1
+    ok = worst < 2e-4
+    print("%-5s table cube root, max OKLab error %.6f" % ("ok" if ok else "FAIL", worst))
+    failures += not ok
+
+    for start, end in GRADIENTS:
+        for leds in (2, 9, 33, 332):
+            fast = gradient_oklab(start, end, leds, cbrt_table)
+            exact = gradient_oklab(start, end, leds, cbrt_exact)
+            step = max(abs(a - b) for x, y in zip(fast, exact) for a, b in zip(x, y))
+            ok = step <= 1 and fast[0] == start and fast[-1] == end
+            if not ok or leds == 332:
+                print("%-5s %s -> %s over %d LEDs, off by at most %d" % ("ok" if ok else "FAIL", start, end, leds, step))
+            failures += not ok
+
+    # OKLab lightness should change evenly where the RGB blend sags
+    start, end = GRADIENTS[2]
+    mid_rgb = to_lab(gradient_rgb(start, end, 3)[1], cbrt_exact)[0]
+    mid_lab = to_lab(gradient_oklab(start, end, 3, cbrt_exact)[1], cbrt_exact)[0]
+    ends = (to_lab(start, cbrt_exact)[0] + to_lab(end, cbrt_exact)[0]) / 2
+    ok = abs(mid_lab - ends) < abs(mid_rgb - ends)
+    print("%-5s red -> green midpoint lightness: rgb %.3f, oklab %.3f, ends average %.3f"
+          % ("ok" if ok else "FAIL", mid_rgb, mid_lab, ends))
+    failures += not ok
+
+    return 1 if failures else 0
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--image", default="twilight.ppm")
+    parser.add_argument("--leds", type=int, default=32, help="LEDs per gradient")
+    parser.add_argument("--scale", type=int, default=12, help="pixels per LED")
+    parser.add_argument("--selftest", action="store_true", help="check the table maths and exit")
+    args = parser.parse_args()
+
+    if args.selftest:
+        return selftest()
+    render(args.image, args.leds, args.scale)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
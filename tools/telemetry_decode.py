@@ -0,0 +1,150 @@
+#!/usr/bin/env python3
+"""Decode the clock's binary telemetry stream into readable log lines.
+
+Frames are 0x00-delimited COBS blocks holding a type byte, varint fields and
+a CRC-8 (see include/telemetry.h). Anything that is not a valid frame, such
+as command responses, is printed as text.
+
+Usage:
+    telemetry_decode.py --port COM25 [--baud 115200]
+    telemetry_decode.py capture.bin
+"""
+
+import argparse
+import sys
+import time
+
+TELEMETRY_CLOCK = 1
+
+# Must match the order in reportClock() in src/main.cpp. Fields ending in
+# "minutes" are signed (zigzag) varints, the rest unsigned.
+CLOCK_FIELDS = [
+    "sequence", "uptime_ms", "time", "led",
+    "sunrise_minutes", "sunrise_led",
+    "noon_minutes", "noon_led",
+    "sunset_minutes", "sunset_led",
+    "day_seconds", "brightness", "current_ma", "limiter_activations",
+    "render_us", "dropped",
+]
+
+
+def crc8(data):
+    crc = 0
+    for byte in data:
+        crc ^= byte
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x07) & 0xFF if crc & 0x80 else (crc << 1) & 0xFF
+    return crc
+
+
+def cobs_decode(block):
+    out = bytearray()
+    i = 0
+    while i < len(block):
+        code = block[i]
+        if code == 0 or i + code > len(block):
+            return None
+        out += block[i + 1:i + code]
+        i += code
+        if code != 0xFF and i < len(block):
+            out.append(0)
+    return bytes(out)
+
+
+def read_varints(data):
+    values, value, shift = [], 0, 0
+    for byte in data:
+        value |= (byte & 0x7F) << shift
+        shift += 7
+        if not byte & 0x80:
+            values.append(value)
+            value, shift = 0, 0
+    return values
+
+
+def unzigzag(value):
+    return (value >> 1) ^ -(value & 1)
+
+
+def hhmm(minutes):
+    return "%02d:%02d" % (minutes // 60, minutes % 60)
+
+
+def format_clock(values):
+    if len(values) < len(CLOCK_FIELDS):
+        return None
+    f = dict(zip(CLOCK_FIELDS, values))
+    for name in CLOCK_FIELDS:
+        if name.endswith("_minutes"):
+            f[name] = unzigzag(f[name])
+    shown = time.strftime("%Y-%m-%d %H:%M:%S", time.gmtime(f["time"]))
+    return ("#%d [%d ms] %s LED %d | sunrise %s (LED %d) noon %s (LED %d) sunset %s (LED %d) "
+            "| %d mA @ %d, limiter %d | render %d us, dropped %d" % (
+                f["sequence"], f["uptime_ms"], shown, f["led"],
+                hhmm(f["sunrise_minutes"]), f["sunrise_led"],
+                hhmm(f["noon_minutes"]), f["noon_led"],
+                hhmm(f["sunset_minutes"]), f["sunset_led"],
+                f["current_ma"], f["brightness"], f["limiter_activations"],
+                f["render_us"], f["dropped"]))
+
+
+def decode_block(block):
+    """Return a log line for a valid frame, or None if the block is not one."""
+    payload = cobs_decode(block)
+    if not payload or len(payload) < 2 or crc8(payload[:-1]) != payload[-1]:
+        return None
+    if payload[0] == TELEMETRY_CLOCK:
+        return format_clock(read_varints(payload[1:-1]))
+    return "frame type %d: %s" % (payload[0], read_varints(payload[1:-1]))
+
+
+def decode_stream(chunks, out):
+    pending = bytearray()
+    for chunk in chunks:
+        pending += chunk
+        while b"\x00" in pending:
+            block, _, rest = pending.partition(b"\x00")
+            pending = bytearray(rest)
+            if not block:
+                continue
+            line = decode_block(bytes(block))
+            if line is None:
+                line = block.decode("utf-8", "replace").rstrip()
+            if line:
+                out.write(line + "\n")
+                out.flush()
+
+
+def serial_chunks(port, baud):
+    import serial  # pyserial
+    with serial.Serial(port, baud, timeout=0.1) as link:
+        while True:
+            yield link.read(256)
+
+
+def file_chunks(path):
+    with (sys.stdin.buffer if path == "-" else open(path, "rb")) as stream:
+        while True:
+            chunk = stream.read(4096)
+            if not chunk:
+                break
+            yield chunk
+    yield b"\x00"   # Flush any trailing text
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("capture", nargs="?", default="-", help="captured stream, - for stdin")
+    parser.add_argument("--port", help="serial port to read live")
+    parser.add_argument("--baud", type=int, default=115200)
+    args = parser.parse_args()
+
+    chunks = serial_chunks(args.port, args.baud) if args.port else file_chunks(args.capture)
+    try:
+        decode_stream(chunks, sys.stdout)
+    except KeyboardInterrupt:
+        pass
+
+
+if __name__ == "__main__":
+    main()